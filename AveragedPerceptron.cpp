@@ -0,0 +1,98 @@
+#include "AveragedPerceptron.h"
+#include <algorithm>
+#include <numeric>
+#include <random>
+
+AveragedPerceptron::AveragedPerceptron(Perceptron& model)
+    : model(model), slots(model.inputSize())
+{
+}
+
+// fold in the weight's value for every update since it last changed
+inline void AveragedPerceptron::catchUp(size_t i)
+{
+    Slot& s = slots[i];
+    s.total += static_cast<double>(count - s.stamp) * model.getWeight(i);
+    s.stamp = count;
+}
+
+double AveragedPerceptron::train(const SparseVector& inputs, int expectedOutput)
+{
+    const size_t n = inputs.nnz();
+    for (size_t k = 0; k < n; ++k) catchUp(inputs.indices[k]);
+    const double loss = model.train(inputs, expectedOutput);
+    biasTotal += model.getBias();
+    ++count;
+    return loss;
+}
+
+double AveragedPerceptron::train(const std::vector<double>& inputs, int expectedOutput)
+{
+    // zero inputs leave their weights unchanged, so they need no catch-up
+    for (size_t i = 0; i < inputs.size(); ++i)
+        if (inputs[i] != 0.0) catchUp(i);
+    const double loss = model.train(inputs, expectedOutput);
+    biasTotal += model.getBias();
+    ++count;
+    return loss;
+}
+
+void AveragedPerceptron::averaged(std::vector<double>& weights, double& bias) const
+{
+    weights = model.getWeights();
+    bias = model.getBias();
+    if (count == 0) return;
+
+    const double inv = 1.0 / static_cast<double>(count);
+    for (size_t i = 0; i < weights.size(); ++i)
+    {
+        const Slot& s = slots[i];
+        weights[i] = (s.total + static_cast<double>(count - s.stamp) * weights[i]) * inv;
+    }
+    bias = biasTotal * inv;
+}
+
+void AveragedPerceptron::finalize()
+{
+    if (count == 0) return;
+    std::vector<double> w;
+    double b = 0.0;
+    averaged(w, b);
+    model.setParameters(w, b);
+    reset();
+}
+
+void AveragedPerceptron::reset()
+{
+    std::fill(slots.begin(), slots.end(), Slot());
+    biasTotal = 0.0;
+    count = 0;
+}
+
+double trainAveraged(Perceptron& model, const SparseDataset& data, const AveragedOptions& options)
+{
+    AveragedPerceptron avg(model);
+    std::vector<size_t> order(data.rows());
+    std::iota(order.begin(), order.end(), static_cast<size_t>(0));
+    std::mt19937 rng(options.seed);
+    SparseVector x;
+    x.dimension = data.cols();
+
+    double epochLoss = 0.0;
+    for (int e = 0; e < options.epochs; ++e)
+    {
+        if (options.shuffle) std::shuffle(order.begin(), order.end(), rng);
+
+        epochLoss = 0.0;
+        for (size_t r : order)
+        {
+            const size_t n = data.rowNnz(r);
+            x.indices.assign(data.rowIndices(r), data.rowIndices(r) + n);
+            x.values.assign(data.rowValues(r), data.rowValues(r) + n);
+
+            epochLoss += avg.train(x, data.label(r));
+        }
+    }
+    avg.finalize();
+    return order.empty() ? 0.0 : epochLoss / static_cast<double>(order.size());
+}
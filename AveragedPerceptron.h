@@ -0,0 +1,72 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Dataset.h"
+#include "Perceptron.h"
+#include "SparseVector.h"
+
+// Averaged perceptron: trains a Perceptron as usual, but the weights it ends
+// with are the mean of the weights after every update. The averaged weights
+// are much steadier than the last ones, so they usually reach a given accuracy
+// in fewer epochs.
+//
+// Averaging is lazy: each weight remembers the update count at which it last
+// changed, and its running total is only brought up to date when a sample
+// touches it again (or at finalize()). A sparse update therefore costs
+// O(nnz) on top of Perceptron::train, independent of inputSize().
+class AveragedPerceptron
+{
+public:
+    // Starts averaging from the model's current weights. The model must
+    // outlive this object and should only be trained through it until
+    // finalize().
+    explicit AveragedPerceptron(Perceptron& model);
+
+    // Perceptron::train plus the lazy bookkeeping for the touched weights.
+    // Returns the sample's loss before the update (running weights).
+    double train(const SparseVector& inputs, int expectedOutput);
+    double train(const std::vector<double>& inputs, int expectedOutput);
+
+    // number of updates averaged so far
+    uint64_t updates() const { return count; }
+
+    // Averaged weights and bias without changing the model, e.g. to evaluate
+    // between epochs. O(inputSize()). Returns the model's own parameters
+    // before the first update.
+    void averaged(std::vector<double>& weights, double& bias) const;
+
+    // Replace the model's weights and bias with their averages and start a
+    // new average from there.
+    void finalize();
+
+private:
+    // running total and last-update stamp side by side: one cache line per touched feature
+    struct Slot
+    {
+        double total = 0.0;     // sum of the weight over updates [0, stamp)
+        uint64_t stamp = 0;
+    };
+
+    void catchUp(size_t i);
+    void reset();
+
+    Perceptron& model;
+    std::vector<Slot> slots;
+    double biasTotal = 0.0;
+    uint64_t count = 0;
+};
+
+// Options for trainAveraged
+struct AveragedOptions
+{
+    int epochs = 10;
+    bool shuffle = true;      // reshuffle sample order every epoch
+    unsigned seed = 0;        // shuffle seed
+};
+
+// Run options.epochs epochs of averaged training over data and leave the
+// averaged weights in the model. Returns the mean loss 0.5*(score-y)^2 of the
+// last epoch, measured with the running (not averaged) weights before each
+// update.
+double trainAveraged(Perceptron& model, const SparseDataset& data,
+    const AveragedOptions& options = AveragedOptions());
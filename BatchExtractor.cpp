@@ -0,0 +1,73 @@
+#include "BatchExtractor.h"
+#include "FeatureExtractor.h"
+#include <exception>
+
+BatchFeatures extractFeaturesBatch(const std::vector<std::string>& paths,
+    const KeywordMatcher& matcher, ThreadPool& pool, FeatureCache* cache)
+{
+    if (cache)
+    {
+        // the cache stores sparse rows; expand them
+        SparseBatchFeatures sparse = extractSparseFeaturesBatch(paths, matcher, pool, cache);
+        BatchFeatures out;
+        out.rows.resize(paths.size());
+        pool.parallelFor(paths.size(), [&](size_t i) {
+            out.rows[i] = sparse.rows[i].toDense();
+        }, 64);
+        out.errors = std::move(sparse.errors);
+        out.failed = sparse.failed;
+        return out;
+    }
+
+    BatchFeatures out;
+    out.rows.resize(paths.size());
+    out.errors.resize(paths.size());
+
+    // one file per task: sizes vary a lot, so let work stealing balance them
+    pool.parallelFor(paths.size(), [&](size_t i) {
+        try
+        {
+            tryExtractFeatures(paths[i], matcher, out.rows[i], out.errors[i]);
+        }
+        catch (const std::exception& ex)
+        {
+            out.rows[i].assign(matcher.size(), 0.0);
+            out.errors[i] = "'" + paths[i] + "': " + ex.what();
+        }
+    });
+
+    for (const auto& e : out.errors)
+        if (!e.empty()) ++out.failed;
+    return out;
+}
+
+SparseBatchFeatures extractSparseFeaturesBatch(const std::vector<std::string>& paths,
+    const KeywordMatcher& matcher, ThreadPool& pool, FeatureCache* cache)
+{
+    SparseBatchFeatures out;
+    out.rows.resize(paths.size());
+    out.errors.resize(paths.size());
+
+    pool.parallelFor(paths.size(), [&](size_t i) {
+        // one scratch per worker thread, reused across files
+        thread_local SparseExtractScratch scratch;
+        try
+        {
+            FileStamp stamp;
+            if (cache && cache->lookup(paths[i], out.rows[i], stamp))
+                return;
+            if (tryExtractSparseFeatures(paths[i], matcher, out.rows[i], scratch, out.errors[i]) && cache)
+                cache->insert(paths[i], stamp, out.rows[i]);
+        }
+        catch (const std::exception& ex)
+        {
+            out.rows[i].clear();
+            out.rows[i].dimension = matcher.size();
+            out.errors[i] = "'" + paths[i] + "': " + ex.what();
+        }
+    });
+
+    for (const auto& e : out.errors)
+        if (!e.empty()) ++out.failed;
+    return out;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "FeatureCache.h"
+#include "KeywordMatcher.h"
+#include "SparseVector.h"
+#include "ThreadPool.h"
+
+// Feature matrix for a list of files, in the same order as the input paths.
+struct BatchFeatures
+{
+    std::vector<std::vector<double>> rows;   // one feature vector per path
+    std::vector<std::string> errors;         // per path; empty string = ok
+    size_t failed = 0;                       // number of non-empty errors
+
+    bool ok(size_t i) const { return errors[i].empty(); }
+};
+
+// Extract features for every path on the pool's workers.
+// Files that cannot be read get an all-zero row plus an error message, so the
+// caller can decide to drop or report them instead of training on them blindly.
+// With a cache (opened for the matcher's keywords), unchanged files are served
+// from it without parsing and newly extracted ones are added; the caller
+// decides when to save() it.
+BatchFeatures extractFeaturesBatch(const std::vector<std::string>& paths,
+    const KeywordMatcher& matcher, ThreadPool& pool, FeatureCache* cache = nullptr);
+
+// Sparse counterpart of BatchFeatures
+struct SparseBatchFeatures
+{
+    std::vector<SparseVector> rows;
+    std::vector<std::string> errors;
+    size_t failed = 0;
+
+    bool ok(size_t i) const { return errors[i].empty(); }
+};
+
+SparseBatchFeatures extractSparseFeaturesBatch(const std::vector<std::string>& paths,
+    const KeywordMatcher& matcher, ThreadPool& pool, FeatureCache* cache = nullptr);
@@ -0,0 +1,94 @@
+#include "Classifier.h"
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+    const FeatureConfig& pick(const FeatureConfig& own, const FeatureConfig& fallback)
+    {
+        const bool empty = own.mode == FeatureMode::Keywords && own.keywords.empty();
+        return empty ? fallback : own;
+    }
+}
+
+bool Classifier::load(const std::string& filename, const FeatureConfig& fallback, std::string& error,
+    bool verify)
+{
+    // load into locals: a failed load keeps the current model, a good one
+    // replaces whichever kind was loaded before
+    MappedModel newMapped;
+    std::unique_ptr<Perceptron> newText;
+    std::unique_ptr<MulticlassPerceptron> newMulti;
+    const FeatureConfig* config = nullptr;
+    if (isBinaryModelFile(filename))
+    {
+        if (!newMapped.open(filename, &error, verify)) return false;
+        config = &newMapped.getFeatureConfig();
+    }
+    else if (MulticlassPerceptron::isMulticlassModelFile(filename))
+    {
+        newMulti.reset(new MulticlassPerceptron(0, 1));
+        if (!newMulti->loadModel(filename))
+        {
+            error = "cannot load model '" + filename + "'";
+            return false;
+        }
+        config = &newMulti->getFeatureConfig();
+    }
+    else
+    {
+        newText.reset(new Perceptron(0));
+        if (!newText->loadModel(filename))
+        {
+            error = "cannot load model '" + filename + "'";
+            return false;
+        }
+        config = &newText->getFeatureConfig();
+    }
+
+    featurizer = Featurizer(pick(*config, fallback));
+    mapped = std::move(newMapped);
+    text = std::move(newText);
+    multi = std::move(newMulti);
+    return true;
+}
+
+Prediction Classifier::classify(const SparseVector& x) const
+{
+    Prediction p;
+    classify(&x, 1, &p);
+    return p;
+}
+
+void Classifier::classify(const SparseVector* inputs, size_t count, Prediction* out) const
+{
+    if (multi)
+    {
+        thread_local std::vector<double> scores;
+        for (size_t i = 0; i < count; ++i)
+        {
+            multi->scores(inputs[i], scores);
+            out[i].label = static_cast<int>(std::max_element(scores.begin(), scores.end()) - scores.begin());
+            out[i].score = scores[static_cast<size_t>(out[i].label)];
+        }
+        return;
+    }
+    for (size_t i = 0; i < count; ++i)
+    {
+        out[i].score = text ? text->score(inputs[i]) : mapped.score(inputs[i]);
+        out[i].label = out[i].score >= 0.0 ? 1 : 0;
+    }
+}
+
+std::string Classifier::labelName(int label) const
+{
+    if (multi && static_cast<size_t>(label) < multi->getClassNames().size())
+        return multi->getClassNames()[static_cast<size_t>(label)];
+    return std::to_string(label);
+}
+
+size_t Classifier::dimension() const
+{
+    if (multi) return multi->inputSize();
+    return text ? text->inputSize() : mapped.dimension();
+}
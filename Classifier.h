@@ -0,0 +1,46 @@
+#pragma once
+#include <memory>
+#include <string>
+#include "FeatureConfig.h"
+#include "Featurizer.h"
+#include "ModelFormat.h"
+#include "MulticlassPerceptron.h"
+#include "Perceptron.h"
+#include "SparseVector.h"
+
+struct Prediction
+{
+    int label = 0;
+    double score = 0.0;      // binary: raw score; multi-class: winning class score
+};
+
+// A loaded model of any kind plus the Featurizer it was trained with, for
+// serving. Binary models are scored straight from the mapping; text models
+// are loaded into a Perceptron, multi-class models into a
+// MulticlassPerceptron. Read-only once loaded, so any number of threads may
+// classify at the same time.
+class Classifier
+{
+public:
+    // fallback: used when the model carries no feature config. verify also
+    // checks a binary model's weight checksum (reads every page).
+    bool load(const std::string& filename, const FeatureConfig& fallback, std::string& error,
+        bool verify = false);
+
+    Prediction classify(const SparseVector& x) const;
+
+    // One pass over a batch: inputs[i] -> out[i]
+    void classify(const SparseVector* inputs, size_t count, Prediction* out) const;
+
+    // class index -> printed label (class name if the model has names)
+    std::string labelName(int label) const;
+
+    size_t dimension() const;
+    const Featurizer& getFeaturizer() const { return featurizer; }
+
+private:
+    MappedModel mapped;
+    std::unique_ptr<Perceptron> text;
+    std::unique_ptr<MulticlassPerceptron> multi;
+    Featurizer featurizer;
+};
@@ -0,0 +1,556 @@
+#include "ClassifierServer.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    bool fail(std::string* error, const std::string& message)
+    {
+        if (error) *error = message;
+        return false;
+    }
+}
+
+ClassifierServer::ClassifierServer(const ModelRegistry& models, const ServerOptions& options)
+    : models(models), options(options)
+{
+    if (this->options.maxBatch == 0) this->options.maxBatch = 1;
+}
+
+ClassifierServer::~ClassifierServer()
+{
+    stop();
+}
+
+ServerStats ClassifierServer::stats() const
+{
+    std::lock_guard<std::mutex> guard(queueLock);
+    return counters;
+}
+
+#ifdef _WIN32
+
+bool ClassifierServer::start(std::string* error)
+{
+    return fail(error, "Unix domain socket serving is not supported on this platform");
+}
+
+void ClassifierServer::stop() {}
+void ClassifierServer::acceptLoop() {}
+void ClassifierServer::serveConnection(Connection*) {}
+void ClassifierServer::dispatchLoop() {}
+void ClassifierServer::runBatch(const std::vector<Request*>&) {}
+void ClassifierServer::finishBatch(const std::vector<Request*>&, uint64_t) {}
+void ClassifierServer::enqueue(Request*) {}
+void ClassifierServer::reapConnections(bool) {}
+
+bool ClassifierClient::connect(const std::string&, std::string* error)
+{
+    return fail(error, "Unix domain sockets are not supported on this platform");
+}
+void ClassifierClient::close() {}
+bool ClassifierClient::classifyText(std::string_view, std::string&, double&, std::string* error)
+{
+    return fail(error, "not connected");
+}
+bool ClassifierClient::classifyPath(const std::string&, std::string&, double&, std::string* error)
+{
+    return fail(error, "not connected");
+}
+bool ClassifierClient::roundTrip(const std::string&, std::string_view, std::string&, double&, std::string* error)
+{
+    return fail(error, "not connected");
+}
+
+#else
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0   // macOS: SO_NOSIGPIPE is set on the socket instead
+#endif
+
+namespace
+{
+    void noSigPipe(int fd)
+    {
+#ifdef SO_NOSIGPIPE
+        int on = 1;
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#else
+        (void)fd;
+#endif
+    }
+
+    bool sendAll(int fd, const char* data, size_t size)
+    {
+        while (size > 0)
+        {
+            const ssize_t n = ::send(fd, data, size, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            data += n;
+            size -= static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    // Buffered reads from a stream socket
+    class SocketReader
+    {
+    public:
+        SocketReader(int fd, std::string& buffer) : fd(fd), buffer(buffer) {}
+
+        // one line without its '\n'; false on EOF/error or a line longer than maxLine
+        bool line(std::string& out, size_t maxLine)
+        {
+            for (size_t scanned = 0;;)
+            {
+                const size_t nl = buffer.find('\n', scanned);
+                if (nl != std::string::npos)
+                {
+                    out.assign(buffer, 0, nl);
+                    buffer.erase(0, nl + 1);
+                    return true;
+                }
+                if (buffer.size() > maxLine) return false;
+                scanned = buffer.size();
+                if (!fill()) return false;
+            }
+        }
+
+        bool bytes(std::string& out, size_t n)
+        {
+            while (buffer.size() < n)
+                if (!fill()) return false;
+            out.assign(buffer, 0, n);
+            buffer.erase(0, n);
+            return true;
+        }
+
+    private:
+        bool fill()
+        {
+            char chunk[64 * 1024];
+            for (;;)
+            {
+                const ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+                if (n < 0 && errno == EINTR) continue;
+                if (n <= 0) return false;
+                buffer.append(chunk, static_cast<size_t>(n));
+                return true;
+            }
+        }
+
+        int fd;
+        std::string& buffer;
+    };
+
+    const size_t kMaxHeader = 4096;
+
+    bool socketAddress(const std::string& path, sockaddr_un& addr, std::string* error)
+    {
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (path.empty() || path.size() >= sizeof(addr.sun_path))
+            return fail(error, "socket path '" + path + "' is empty or too long");
+        std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+        return true;
+    }
+}
+
+bool ClassifierServer::start(std::string* error)
+{
+    if (started) return fail(error, "server already started");
+
+    sockaddr_un addr;
+    if (!socketAddress(options.socketPath, addr, error)) return false;
+
+    // a socket file left behind by a previous run would make bind() fail
+    struct stat st;
+    if (lstat(options.socketPath.c_str(), &st) == 0)
+    {
+        if (!S_ISSOCK(st.st_mode))
+            return fail(error, "'" + options.socketPath + "' exists and is not a socket");
+        ::unlink(options.socketPath.c_str());
+    }
+
+    listenFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0) return fail(error, std::string("cannot create socket: ") + std::strerror(errno));
+    fcntl(listenFd, F_SETFD, FD_CLOEXEC);
+    if (::bind(listenFd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0
+        || ::listen(listenFd, options.backlog) != 0)
+    {
+        const std::string reason = std::strerror(errno);
+        ::close(listenFd);
+        listenFd = -1;
+        return fail(error, "cannot listen on '" + options.socketPath + "': " + reason);
+    }
+    if (::pipe(wakePipe) != 0)
+    {
+        ::close(listenFd);
+        listenFd = -1;
+        return fail(error, std::string("cannot create pipe: ") + std::strerror(errno));
+    }
+
+    pool.reset(new ThreadPool(options.workers));
+    stopping = false;
+    draining = false;
+    started = true;
+    dispatcher = std::thread([this] { dispatchLoop(); });
+    acceptor = std::thread([this] { acceptLoop(); });
+    return true;
+}
+
+void ClassifierServer::stop()
+{
+    if (!started) return;
+    started = false;
+
+    // 1) no new connections
+    stopping = true;
+    const char byte = 0;
+    (void)!::write(wakePipe[1], &byte, 1);
+    acceptor.join();
+    ::close(listenFd);
+    ::close(wakePipe[0]);
+    ::close(wakePipe[1]);
+    listenFd = wakePipe[0] = wakePipe[1] = -1;
+    ::unlink(options.socketPath.c_str());
+
+    // 2) end every connection; a reader waiting on a reply still gets it
+    {
+        std::lock_guard<std::mutex> guard(connectionsLock);
+        for (auto& c : connections) ::shutdown(c->fd, SHUT_RDWR);
+    }
+    reapConnections(/*all=*/true);
+
+    // 3) the queue is empty now; let the dispatcher and the pool finish
+    {
+        std::lock_guard<std::mutex> guard(queueLock);
+        draining = true;
+    }
+    queueChanged.notify_all();
+    dispatcher.join();
+    pool.reset();
+}
+
+void ClassifierServer::reapConnections(bool all)
+{
+    std::vector<std::unique_ptr<Connection>> done;
+    {
+        std::lock_guard<std::mutex> guard(connectionsLock);
+        auto keep = std::partition(connections.begin(), connections.end(),
+            [&](const std::unique_ptr<Connection>& c) { return !all && !c->finished; });
+        std::move(keep, connections.end(), std::back_inserter(done));
+        connections.erase(keep, connections.end());
+    }
+    for (auto& c : done)
+    {
+        c->reader.join();
+        ::close(c->fd);
+    }
+}
+
+void ClassifierServer::acceptLoop()
+{
+    pollfd fds[2] = { { listenFd, POLLIN, 0 }, { wakePipe[0], POLLIN, 0 } };
+    while (!stopping)
+    {
+        if (::poll(fds, 2, -1) < 0)
+        {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (fds[1].revents) break;
+        if (!(fds[0].revents & POLLIN)) continue;
+
+        const int fd = ::accept(listenFd, nullptr, nullptr);
+        if (fd < 0) continue;
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+        noSigPipe(fd);
+
+        reapConnections(/*all=*/false);
+        std::unique_ptr<Connection> c(new Connection);
+        c->fd = fd;
+        Connection* raw = c.get();
+        {
+            std::lock_guard<std::mutex> guard(connectionsLock);
+            connections.push_back(std::move(c));
+        }
+        {
+            std::lock_guard<std::mutex> guard(queueLock);
+            ++counters.connections;
+            ++openConnections;
+        }
+        raw->reader = std::thread([this, raw] { serveConnection(raw); });
+    }
+}
+
+void ClassifierServer::serveConnection(Connection* c)
+{
+    std::string buffer, header, reply;
+    SocketReader in(c->fd, buffer);
+    Request r;
+    r.owner = c;
+
+    while (in.line(header, kMaxHeader))
+    {
+        if (!header.empty() && header.back() == '\r') header.pop_back();
+
+        bool ok = header.size() >= 2 && header[1] == ' ';
+        if (ok && header[0] == 'P')
+        {
+            r.isPath = true;
+            r.payload.assign(header, 2, std::string::npos);
+        }
+        else if (ok && header[0] == 'D')
+        {
+            char* end = nullptr;
+            const unsigned long long n = std::strtoull(header.c_str() + 2, &end, 10);
+            ok = end && *end == '\0' && end != header.c_str() + 2 && n <= options.maxDocumentBytes;
+            r.isPath = false;
+            if (ok && !in.bytes(r.payload, static_cast<size_t>(n))) break;
+        }
+        else ok = false;
+
+        if (!ok)
+        {
+            // the stream cannot be resynchronised after a bad header
+            reply = "error\tbad request header (expected 'D <bytes>' up to "
+                + std::to_string(options.maxDocumentBytes) + " or 'P <path>')\n";
+            sendAll(c->fd, reply.data(), reply.size());
+            break;
+        }
+
+        r.done = false;
+        r.error.clear();
+        enqueue(&r);
+        {
+            std::unique_lock<std::mutex> guard(c->lock);
+            c->completed.wait(guard, [&] { return r.done; });
+        }
+
+        if (r.error.empty())
+        {
+            char score[32];
+            std::snprintf(score, sizeof(score), "%.9g", r.result.score);
+            reply = r.label;
+            reply += '\t';
+            reply += score;
+        }
+        else
+        {
+            reply = "error\t" + r.error;
+            std::replace(reply.begin(), reply.end(), '\n', ' ');
+        }
+        reply += '\n';
+        if (!sendAll(c->fd, reply.data(), reply.size())) break;
+    }
+
+    // closed by reapConnections, so stop() never shuts down a reused descriptor
+    ::shutdown(c->fd, SHUT_RDWR);
+    {
+        std::lock_guard<std::mutex> guard(queueLock);
+        --openConnections;
+    }
+    queueChanged.notify_all();
+    c->finished = true;
+}
+
+void ClassifierServer::enqueue(Request* r)
+{
+    const auto now = std::chrono::steady_clock::now();
+    r->queued = now;
+    {
+        std::lock_guard<std::mutex> guard(queueLock);
+        if (lastArrival.time_since_epoch().count() != 0)
+        {
+            const double gap = std::chrono::duration<double, std::micro>(now - lastArrival).count();
+            arrivalGapUs += (gap - arrivalGapUs) * 0.125;
+        }
+        lastArrival = now;
+        queue.push_back(r);
+        ++outstanding;
+        ++counters.requests;
+    }
+    queueChanged.notify_all();
+}
+
+void ClassifierServer::dispatchLoop()
+{
+    const unsigned workers = pool->size();
+    const auto maxWait = std::chrono::microseconds(options.maxWaitUs);
+    std::vector<Request*> batch;
+
+    std::unique_lock<std::mutex> guard(queueLock);
+    for (;;)
+    {
+        queueChanged.wait(guard, [&] { return (!queue.empty() && busyWorkers < workers) || (draining && queue.empty()); });
+        if (queue.empty()) break;
+
+        // A worker is free. Hold the batch open only while requests come in
+        // fast enough to add to it within the wait budget, and while some
+        // connection is idle (each has at most one request outstanding, so
+        // otherwise nothing more can arrive).
+        const auto canGrow = [&] {
+            return queue.size() < options.maxBatch && outstanding < openConnections && !draining;
+        };
+        if (canGrow() && arrivalGapUs < options.maxWaitUs)
+            queueChanged.wait_until(guard, queue.front()->queued + maxWait, [&] { return !canGrow(); });
+
+        // spread what is waiting over the idle workers rather than giving it all to one
+        const size_t idle = workers - busyWorkers;
+        const size_t n = (std::min)((queue.size() + idle - 1) / idle, options.maxBatch);
+        batch.assign(queue.begin(), queue.begin() + static_cast<std::ptrdiff_t>(n));
+        queue.erase(queue.begin(), queue.begin() + static_cast<std::ptrdiff_t>(n));
+        ++busyWorkers;
+        ++counters.batches;
+        counters.largestBatch = (std::max)(counters.largestBatch, static_cast<uint64_t>(n));
+
+        guard.unlock();
+        pool->submit([this, batch] { runBatch(batch); });
+        guard.lock();
+    }
+}
+
+void ClassifierServer::runBatch(const std::vector<Request*>& batch)
+{
+    thread_local Featurizer::Scratch scratch;
+    thread_local std::vector<SparseVector> inputs;
+    thread_local std::vector<Prediction> predictions;
+
+    // one snapshot per batch: a reload never splits a batch between models
+    const ModelRegistry::Snapshot model = models.current();
+    const size_t n = batch.size();
+    if (!model)
+    {
+        for (Request* r : batch) r->error = "no model loaded";
+        finishBatch(batch, n);
+        return;
+    }
+
+    const Featurizer& featurizer = model->getFeaturizer();
+    inputs.resize(n);
+    predictions.resize(n);
+
+    uint64_t errors = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        Request& r = *batch[i];
+        SparseVector& x = inputs[i];
+        try
+        {
+            if (r.isPath)
+                featurizer.extractFile(r.payload, x, scratch, r.error);
+            else
+                featurizer.extract(r.payload, x, scratch);
+        }
+        catch (const std::exception& ex)
+        {
+            r.error = ex.what();
+        }
+        if (!r.error.empty())
+        {
+            x.clear();
+            x.dimension = featurizer.dimension();
+            ++errors;
+        }
+    }
+
+    model->classify(inputs.data(), n, predictions.data());
+    for (size_t i = 0; i < n; ++i)
+    {
+        batch[i]->result = predictions[i];
+        if (batch[i]->error.empty()) batch[i]->label = model->labelName(predictions[i].label);
+    }
+    finishBatch(batch, errors);
+}
+
+void ClassifierServer::finishBatch(const std::vector<Request*>& batch, uint64_t errors)
+{
+    for (Request* r : batch)
+    {
+        std::lock_guard<std::mutex> guard(r->owner->lock);
+        r->done = true;
+        r->owner->completed.notify_one();
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(queueLock);
+        --busyWorkers;
+        outstanding -= batch.size();
+        counters.errors += errors;
+    }
+    queueChanged.notify_all();
+}
+
+bool ClassifierClient::connect(const std::string& socketPath, std::string* error)
+{
+    close();
+    sockaddr_un addr;
+    if (!socketAddress(socketPath, addr, error)) return false;
+
+    fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return fail(error, std::string("cannot create socket: ") + std::strerror(errno));
+    noSigPipe(fd);
+    if (::connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0)
+    {
+        const std::string reason = std::strerror(errno);
+        close();
+        return fail(error, "cannot connect to '" + socketPath + "': " + reason);
+    }
+    return true;
+}
+
+void ClassifierClient::close()
+{
+    if (fd >= 0) ::close(fd);
+    fd = -1;
+    inbox.clear();
+}
+
+bool ClassifierClient::classifyText(std::string_view document, std::string& label, double& score,
+    std::string* error)
+{
+    return roundTrip("D " + std::to_string(document.size()) + "\n", document, label, score, error);
+}
+
+bool ClassifierClient::classifyPath(const std::string& path, std::string& label, double& score,
+    std::string* error)
+{
+    if (path.find('\n') != std::string::npos) return fail(error, "path contains a newline");
+    return roundTrip("P " + path + "\n", std::string_view(), label, score, error);
+}
+
+bool ClassifierClient::roundTrip(const std::string& header, std::string_view body, std::string& label,
+    double& score, std::string* error)
+{
+    if (fd < 0) return fail(error, "not connected");
+    if (!sendAll(fd, header.data(), header.size()) || !sendAll(fd, body.data(), body.size()))
+        return fail(error, std::string("send failed: ") + std::strerror(errno));
+
+    std::string line;
+    if (!SocketReader(fd, inbox).line(line, kMaxHeader))
+        return fail(error, "connection closed by server");
+
+    const size_t tab = line.find('\t');
+    if (tab == std::string::npos) return fail(error, "malformed reply '" + line + "'");
+    if (line.compare(0, tab, "error") == 0) return fail(error, line.substr(tab + 1));
+    label.assign(line, 0, tab);
+    score = std::strtod(line.c_str() + tab + 1, nullptr);
+    return true;
+}
+
+#endif
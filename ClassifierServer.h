@@ -0,0 +1,157 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "Classifier.h"
+#include "ModelRegistry.h"
+#include "ThreadPool.h"
+
+// Resident classifier on a local Unix domain socket.
+//
+// Protocol: every request is one header line, answered by one line.
+//   D <n>\n<n bytes>    classify the document bytes
+//   P <path>\n          classify the file at path (as seen by the server)
+// reply:
+//   <label>\t<score>\n  or  error\t<message>\n
+// A connection may send any number of requests; they are served one at a
+// time, in order, so concurrency comes from using several connections.
+//
+// Requests from all connections are grouped into micro-batches: a batch is
+// closed when it reaches maxBatch, or once a worker is free and either the
+// oldest request has waited maxWaitUs or requests arrive too slowly to fill
+// it (so light load adds no waiting). Each batch is extracted and scored in
+// one pass on one worker of a fixed pool.
+//
+// POSIX only; on Windows start() fails.
+struct ServerOptions
+{
+    std::string socketPath;
+    unsigned workers = 0;              // 0 = hardware threads
+    size_t maxBatch = 32;
+    unsigned maxWaitUs = 200;          // longest a request is held back to grow a batch
+    size_t maxDocumentBytes = 16u << 20;
+    int backlog = 128;
+};
+
+struct ServerStats
+{
+    uint64_t connections = 0;
+    uint64_t requests = 0;
+    uint64_t errors = 0;               // requests answered with error
+    uint64_t batches = 0;
+    uint64_t largestBatch = 0;
+};
+
+class ClassifierServer
+{
+public:
+    // Every batch is scored with models.current() as of the batch, so a
+    // model published to the registry takes over without a restart.
+    ClassifierServer(const ModelRegistry& models, const ServerOptions& options);
+    ~ClassifierServer();   // stop()
+
+    ClassifierServer(const ClassifierServer&) = delete;
+    ClassifierServer& operator=(const ClassifierServer&) = delete;
+
+    // Binds the socket (replacing a stale socket file) and starts serving in
+    // the background. false + error if the socket cannot be set up.
+    bool start(std::string* error = nullptr);
+
+    // Stops accepting, closes every connection, finishes queued batches and
+    // removes the socket file.
+    void stop();
+
+    ServerStats stats() const;
+
+private:
+    // one client; its reader thread has at most one request in flight
+    struct Connection
+    {
+        int fd = -1;
+        std::mutex lock;
+        std::condition_variable completed;
+        std::thread reader;
+        std::atomic<bool> finished{ false };
+    };
+
+    struct Request
+    {
+        bool isPath = false;
+        std::string payload;           // document bytes or path
+        Prediction result;
+        std::string label;             // result.label as printed
+        std::string error;             // empty = ok
+        bool done = false;             // guarded by owner->lock
+        Connection* owner = nullptr;
+        std::chrono::steady_clock::time_point queued;
+    };
+
+    void acceptLoop();
+    void serveConnection(Connection* c);
+    void dispatchLoop();
+    void runBatch(const std::vector<Request*>& batch);
+    void finishBatch(const std::vector<Request*>& batch, uint64_t errors);
+    void enqueue(Request* r);
+    void reapConnections(bool all);
+
+    const ModelRegistry& models;
+    ServerOptions options;
+    std::unique_ptr<ThreadPool> pool;
+
+    int listenFd = -1;
+    int wakePipe[2] = { -1, -1 };      // wakes acceptLoop on stop()
+    std::thread acceptor;
+    std::thread dispatcher;
+    std::atomic<bool> stopping{ false };
+    bool started = false;
+
+    std::mutex connectionsLock;
+    std::vector<std::unique_ptr<Connection>> connections;
+
+    // pending requests, guarded by queueLock
+    mutable std::mutex queueLock;
+    std::condition_variable queueChanged;
+    std::deque<Request*> queue;
+    unsigned busyWorkers = 0;
+    size_t outstanding = 0;            // queued or being scored
+    size_t openConnections = 0;
+    bool draining = false;             // stop(): dispatcher exits once the queue is empty
+    double arrivalGapUs = 1e9;         // moving average of the time between requests
+    std::chrono::steady_clock::time_point lastArrival;
+    ServerStats counters;
+};
+
+// Blocking client for the protocol above (used by serve-loadgen).
+class ClassifierClient
+{
+public:
+    ClassifierClient() = default;
+    ~ClassifierClient() { close(); }
+
+    ClassifierClient(const ClassifierClient&) = delete;
+    ClassifierClient& operator=(const ClassifierClient&) = delete;
+
+    bool connect(const std::string& socketPath, std::string* error = nullptr);
+    void close();
+
+    // Send one request and wait for the reply. false + error on a transport
+    // failure or an error reply.
+    bool classifyText(std::string_view document, std::string& label, double& score, std::string* error = nullptr);
+    bool classifyPath(const std::string& path, std::string& label, double& score, std::string* error = nullptr);
+
+private:
+    bool roundTrip(const std::string& header, std::string_view body, std::string& label, double& score,
+        std::string* error);
+
+    int fd = -1;
+    std::string inbox;                 // received bytes not yet consumed
+};
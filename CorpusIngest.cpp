@@ -0,0 +1,519 @@
+#include "CorpusIngest.h"
+#include "Metrics.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+#ifdef __linux__
+#include <cerrno>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    // Collects finished files into batches for the consumer. Once the
+    // consumer has closed the queue, files are counted and dropped.
+    class BatchSink
+    {
+    public:
+        BatchSink(BoundedQueue<IngestBatch>& out, size_t batchSize, IngestStats& stats)
+            : out(out), batchSize((std::max)(static_cast<size_t>(1), batchSize)), stats(stats)
+        {
+            batch.reserve(this->batchSize);
+        }
+
+        void add(IngestedFile&& file)
+        {
+            ++stats.files;
+            if (file.ok()) stats.bytes += file.view().size();
+            else ++stats.failed;
+            if (!open) return;
+            batch.push_back(std::move(file));
+            if (batch.size() >= batchSize) flush();
+        }
+
+        void flush()
+        {
+            if (batch.empty() || !open) return;
+            open = out.push(std::move(batch));
+            batch = IngestBatch();
+            batch.reserve(batchSize);
+        }
+
+        bool closed() const { return !open; }
+
+    private:
+        BoundedQueue<IngestBatch>& out;
+        size_t batchSize;
+        IngestStats& stats;
+        IngestBatch batch;
+        bool open = true;
+    };
+
+    std::string tooLarge(const std::string& path, size_t limit)
+    {
+        return "'" + path + "' is larger than " + std::to_string(limit) + " bytes";
+    }
+
+    // Threads backend for the paths at `retry`, then paths[from, end): one
+    // chunk of batchSize files at a time, read in parallel by blocking reader
+    // threads
+    void readWithThreads(const std::vector<std::string>& paths, const std::vector<size_t>& retry, size_t from,
+        const IngestOptions& options, BatchSink& sink)
+    {
+        ThreadPool readers(options.readers);
+        const size_t chunk = (std::max)(static_cast<size_t>(1), options.batchSize);
+        const size_t total = retry.size() + (paths.size() - from);
+        for (size_t start = 0; start < total && !sink.closed(); start += chunk)
+        {
+            IngestBatch files((std::min)(chunk, total - start));
+            readers.parallelFor(files.size(), [&](size_t i) {
+                IngestedFile& f = files[i];
+                const size_t k = start + i;
+                f.index = k < retry.size() ? retry[k] : from + (k - retry.size());
+                if (f.file.open(paths[f.index], &f.error) && f.file.size() > options.maxFileBytes)
+                {
+                    f.file.close();
+                    f.error = tooLarge(paths[f.index], options.maxFileBytes);
+                }
+            });
+            for (IngestedFile& f : files) sink.add(std::move(f));
+        }
+    }
+
+#ifdef __linux__
+    // Minimal io_uring over the raw syscalls: one SQ/CQ pair, no SQPOLL
+    class Ring
+    {
+    public:
+        Ring() = default;
+        ~Ring() { close(); }
+
+        Ring(const Ring&) = delete;
+        Ring& operator=(const Ring&) = delete;
+
+        bool init(unsigned entries, std::string& error)
+        {
+            io_uring_params p;
+            std::memset(&p, 0, sizeof(p));
+            fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &p));
+            if (fd < 0)
+            {
+                error = std::string("io_uring_setup: ") + std::strerror(errno);
+                return false;
+            }
+
+            sqRingSize = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+            cqRingSize = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+            const bool single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+            if (single) sqRingSize = cqRingSize = (std::max)(sqRingSize, cqRingSize);
+            sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+            if (sqRing == MAP_FAILED) return fail(error, "mmap sq ring");
+            cqRing = single ? sqRing
+                : mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+            if (cqRing == MAP_FAILED) return fail(error, "mmap cq ring");
+            sqesSize = p.sq_entries * sizeof(io_uring_sqe);
+            void* s = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+            if (s == MAP_FAILED) return fail(error, "mmap sqes");
+            sqes = static_cast<io_uring_sqe*>(s);
+
+            char* sq = static_cast<char*>(sqRing);
+            char* cq = static_cast<char*>(cqRing);
+            sqHead = reinterpret_cast<unsigned*>(sq + p.sq_off.head);
+            sqTail = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+            sqArray = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+            sqMask = *reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+            sqEntries = p.sq_entries;
+            cqHead = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+            cqTail = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+            cqMask = *reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+            cqes = reinterpret_cast<io_uring_cqe*>(cq + p.cq_off.cqes);
+            localTail = *sqTail;
+
+            // openat/read/close need 5.6+; older kernels set up a ring but
+            // would fail every request
+            std::vector<unsigned char> memory(sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op));
+            io_uring_probe* probe = reinterpret_cast<io_uring_probe*>(memory.data());
+            if (syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, 256) < 0)
+                return fail(error, "io_uring probe");
+            for (unsigned op : { IORING_OP_OPENAT, IORING_OP_READ, IORING_OP_CLOSE })
+            {
+                if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED))
+                {
+                    error = "io_uring lacks openat/read/close (kernel older than 5.6)";
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // Unmaps and closes the ring; the kernel cancels or finishes whatever
+        // is still in flight
+        void close()
+        {
+            if (sqes != MAP_FAILED) munmap(sqes, sqesSize);
+            if (cqRing != MAP_FAILED && cqRing != sqRing) munmap(cqRing, cqRingSize);
+            if (sqRing != MAP_FAILED) munmap(sqRing, sqRingSize);
+            if (fd >= 0) ::close(fd);
+            sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+            cqRing = sqRing = MAP_FAILED;
+            fd = -1;
+        }
+
+        // sequence number of the entry next() hands out next
+        unsigned tail() const { return localTail; }
+        // true once the kernel has taken entry `seq` (enter() submitted it)
+        bool taken(unsigned seq) const { return localTail - seq > pending; }
+
+        // a zeroed submission entry, or nullptr if the queue is full
+        io_uring_sqe* next()
+        {
+            const unsigned head = __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+            if (localTail - head >= sqEntries) return nullptr;
+            const unsigned slot = localTail & sqMask;
+            io_uring_sqe* sqe = &sqes[slot];
+            std::memset(sqe, 0, sizeof(*sqe));
+            sqArray[slot] = slot;
+            ++localTail;
+            ++pending;
+            return sqe;
+        }
+
+        // submit what next() queued and wait for at least waitFor
+        // completions; 0 or -errno
+        int enter(unsigned waitFor)
+        {
+            __atomic_store_n(sqTail, localTail, __ATOMIC_RELEASE);
+            const long r = syscall(__NR_io_uring_enter, fd, pending, waitFor, IORING_ENTER_GETEVENTS, nullptr, 0);
+            if (r < 0) return -errno;
+            pending -= static_cast<unsigned>(r);
+            return 0;
+        }
+
+        template <class Fn>
+        void drain(Fn&& fn)
+        {
+            unsigned head = *cqHead;
+            const unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+            for (; head != tail; ++head)
+            {
+                const io_uring_cqe& c = cqes[head & cqMask];
+                fn(c.user_data, c.res);
+            }
+            __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+        }
+
+    private:
+        bool fail(std::string& error, const char* what)
+        {
+            error = std::string(what) + ": " + std::strerror(errno);
+            return false;
+        }
+
+        int fd = -1;
+        void* sqRing = MAP_FAILED;
+        void* cqRing = MAP_FAILED;
+        io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+        size_t sqRingSize = 0, cqRingSize = 0, sqesSize = 0;
+        unsigned* sqHead = nullptr;
+        unsigned* sqTail = nullptr;
+        unsigned* sqArray = nullptr;
+        unsigned sqMask = 0, sqEntries = 0;
+        unsigned* cqHead = nullptr;
+        unsigned* cqTail = nullptr;
+        unsigned cqMask = 0;
+        io_uring_cqe* cqes = nullptr;
+        unsigned localTail = 0;
+        unsigned pending = 0;     // queued by next(), not yet taken by the kernel
+    };
+
+    // first read per file; mail-sized documents fit in one
+    constexpr size_t kFirstRead = 16 * 1024;
+
+    // One file in flight: openat -> read (repeated while the buffer fills) -> close
+    struct UringSlot
+    {
+        enum class Stage { Idle, Open, Read, Close };
+        Stage stage = Stage::Idle;
+        size_t index = 0;
+        int fd = -1;
+        unsigned seq = 0;      // Ring::tail() of the slot's last request
+        size_t got = 0;
+        std::vector<char> buffer;
+        std::string error;
+    };
+
+    // io_uring backend; reads paths[next, end) and advances next past every
+    // file it started. false if no ring could be set up (nothing started);
+    // after a mid-run failure it returns true with next < end and the files
+    // that were in flight in retry, for the threads backend.
+    bool readWithUring(const std::vector<std::string>& paths, size_t& next, std::vector<size_t>& retry,
+        const IngestOptions& options, BatchSink& sink, IngestStats& stats)
+    {
+        const unsigned depth = (std::max)(1u, options.queueDepth);
+        std::vector<UringSlot> slots(depth);   // outlives the ring: the kernel may still write to buffers
+        Ring ring;
+        std::string error;
+        if (!ring.init(depth, error)) return false;
+
+        std::vector<unsigned> idle;
+        for (unsigned s = depth; s-- > 0;) idle.push_back(s);
+        size_t inFlight = 0;
+
+        auto finish = [&](unsigned s) {
+            UringSlot& slot = slots[s];
+            IngestedFile f;
+            f.index = slot.index;
+            f.error = std::move(slot.error);
+            if (f.error.empty())
+            {
+                slot.buffer.resize(slot.got);
+                f.bytes = std::move(slot.buffer);
+                METRIC_ADD(BytesRead, slot.got);
+            }
+            slot = UringSlot();
+            idle.push_back(s);
+            --inFlight;
+            sink.add(std::move(f));
+        };
+
+        // every slot has at most one request outstanding and the ring has one
+        // entry per slot, so next() cannot run out
+        auto submit = [&](unsigned s) {
+            UringSlot& slot = slots[s];
+            slot.seq = ring.tail();
+            io_uring_sqe* sqe = ring.next();
+            sqe->user_data = s;
+            switch (slot.stage)
+            {
+            case UringSlot::Stage::Open:
+                sqe->opcode = IORING_OP_OPENAT;
+                sqe->fd = AT_FDCWD;
+                sqe->addr = reinterpret_cast<uint64_t>(paths[slot.index].c_str());
+                sqe->open_flags = O_RDONLY | O_CLOEXEC;
+                break;
+            case UringSlot::Stage::Read:
+                sqe->opcode = IORING_OP_READ;
+                sqe->fd = slot.fd;
+                sqe->addr = reinterpret_cast<uint64_t>(slot.buffer.data() + slot.got);
+                sqe->len = static_cast<uint32_t>(slot.buffer.size() - slot.got);
+                sqe->off = slot.got;
+                break;
+            case UringSlot::Stage::Close:
+                sqe->opcode = IORING_OP_CLOSE;
+                sqe->fd = slot.fd;
+                break;
+            case UringSlot::Stage::Idle:
+                break;
+            }
+        };
+
+        auto complete = [&](uint64_t userData, int res) {
+            const unsigned s = static_cast<unsigned>(userData);
+            UringSlot& slot = slots[s];
+            const std::string& path = paths[slot.index];
+            switch (slot.stage)
+            {
+            case UringSlot::Stage::Open:
+                if (res < 0)
+                {
+                    slot.error = "cannot open '" + path + "': " + std::strerror(-res);
+                    finish(s);
+                    return;
+                }
+                slot.fd = res;
+                slot.buffer.resize((std::min)(kFirstRead, options.maxFileBytes + 1));
+                slot.stage = UringSlot::Stage::Read;
+                break;
+            case UringSlot::Stage::Read:
+                if (res == -EINTR || res == -EAGAIN) break;   // retry the same read
+                if (res < 0)
+                {
+                    slot.error = "cannot read '" + path + "': " + std::strerror(-res);
+                    slot.stage = UringSlot::Stage::Close;
+                    break;
+                }
+                slot.got += static_cast<size_t>(res);
+                if (res == 0 || slot.got < slot.buffer.size())
+                {
+                    // a short read of a regular file is its end
+                    slot.stage = UringSlot::Stage::Close;
+                }
+                else if (slot.got > options.maxFileBytes)
+                {
+                    slot.error = tooLarge(path, options.maxFileBytes);
+                    slot.stage = UringSlot::Stage::Close;
+                }
+                else
+                {
+                    slot.buffer.resize((std::min)(slot.buffer.size() * 2, options.maxFileBytes + 1));
+                }
+                break;
+            case UringSlot::Stage::Close:
+                finish(s);
+                return;
+            case UringSlot::Stage::Idle:
+                return;
+            }
+            submit(s);
+        };
+
+        while (true)
+        {
+            while (!idle.empty() && next < paths.size() && !sink.closed())
+            {
+                const unsigned s = idle.back();
+                idle.pop_back();
+                slots[s].stage = UringSlot::Stage::Open;
+                slots[s].index = next++;
+                ++inFlight;
+                submit(s);
+            }
+            if (inFlight == 0) break;
+
+            ++stats.submitCalls;
+            const int r = ring.enter(1);
+            if (r == -EINTR || r == -EAGAIN || r == -EBUSY) continue;
+            if (r < 0)
+            {
+                // Give up on the ring. Reads the kernel has taken may still
+                // write into the slot buffers, so the ring goes first; then
+                // the descriptors still ours are closed (not those of a
+                // close the kernel already took) and the caller reads the
+                // files again on threads.
+                std::vector<int> fds;
+                for (const UringSlot& slot : slots)
+                {
+                    if (slot.stage == UringSlot::Stage::Idle) continue;
+                    retry.push_back(slot.index);
+                    const bool closing = slot.stage == UringSlot::Stage::Close && ring.taken(slot.seq);
+                    if (slot.fd >= 0 && !closing) fds.push_back(slot.fd);
+                }
+                ring.close();
+                for (int fd : fds) ::close(fd);
+                std::sort(retry.begin(), retry.end());
+                return true;
+            }
+            ring.drain(complete);
+        }
+        return true;
+    }
+#endif
+}
+
+const char* ingestBackendName(IngestBackend backend)
+{
+    switch (backend)
+    {
+    case IngestBackend::Auto: return "auto";
+    case IngestBackend::IoUring: return "io_uring";
+    case IngestBackend::Threads: return "threads";
+    }
+    return "?";
+}
+
+bool parseIngestBackend(const std::string& name, IngestBackend& backend)
+{
+    for (IngestBackend b : { IngestBackend::Auto, IngestBackend::IoUring, IngestBackend::Threads })
+    {
+        if (name == ingestBackendName(b))
+        {
+            backend = b;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ioUringAvailable()
+{
+#ifdef __linux__
+    Ring ring;
+    std::string error;
+    return ring.init(2, error);
+#else
+    return false;
+#endif
+}
+
+IngestStats readFiles(const std::vector<std::string>& paths, BoundedQueue<IngestBatch>& out,
+    const IngestOptions& options)
+{
+    const auto t0 = Clock::now();
+    IngestStats stats;
+    BatchSink sink(out, options.batchSize, stats);
+    size_t next = 0;
+    std::vector<size_t> retry;   // in flight when io_uring gave up
+    bool uring = false;
+#ifdef __linux__
+    if (options.backend != IngestBackend::Threads)
+        uring = readWithUring(paths, next, retry, options, sink, stats);
+#endif
+    stats.backend = uring ? IngestBackend::IoUring : IngestBackend::Threads;
+    if ((!retry.empty() || next < paths.size()) && !sink.closed())
+        readWithThreads(paths, retry, next, options, sink);
+    sink.flush();
+    out.close();
+    stats.seconds = std::chrono::duration<double>(Clock::now() - t0).count();
+    return stats;
+}
+
+bool listFiles(const std::string& root, std::vector<std::string>& paths, std::string* error)
+{
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    fs::recursive_directory_iterator it(root, fs::directory_options::skip_permission_denied, ec);
+    if (ec)
+    {
+        if (error) *error = "cannot list '" + root + "': " + ec.message();
+        return false;
+    }
+    paths.clear();
+    for (; it != fs::recursive_directory_iterator(); it.increment(ec))
+    {
+        if (ec)
+        {
+            if (error) *error = "cannot list '" + root + "': " + ec.message();
+            return false;
+        }
+        if (it->is_regular_file(ec)) paths.push_back(it->path().string());
+    }
+    std::sort(paths.begin(), paths.end());
+    return true;
+}
+
+IngestStats extractFiles(const std::vector<std::string>& paths, const Featurizer& featurizer, ThreadPool& pool,
+    std::vector<SparseVector>& rows, std::vector<std::string>& errors, const IngestOptions& options)
+{
+    rows.assign(paths.size(), SparseVector());
+    errors.assign(paths.size(), std::string());
+
+    BoundedQueue<IngestBatch> queue(options.prefetch);
+    IngestStats stats;
+    std::thread reader([&] { stats = readFiles(paths, queue, options); });
+
+    IngestBatch batch;
+    while (queue.pop(batch))
+    {
+        pool.parallelFor(batch.size(), [&](size_t i) {
+            thread_local Featurizer::Scratch scratch;
+            IngestedFile& f = batch[i];
+            SparseVector& x = rows[f.index];
+            x.dimension = featurizer.dimension();
+            if (f.ok()) featurizer.extract(f.view(), x, scratch);
+            else errors[f.index] = std::move(f.error);
+        });
+    }
+    reader.join();
+    return stats;
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "BoundedQueue.h"
+#include "Featurizer.h"
+#include "MappedFile.h"
+#include "SparseVector.h"
+#include "ThreadPool.h"
+
+// Bulk file reading for corpora of many small documents, where the time goes
+// to open/read/close syscalls and waiting on the disk rather than parsing.
+//
+// Two backends:
+//  - IoUring (Linux): one thread keeps queueDepth files in flight on an
+//    io_uring (raw syscalls, no liburing). Each file is an openat, one or
+//    more reads and a close; the submissions of all in-flight files go to
+//    the kernel in one io_uring_enter, which also collects their completions.
+//  - Threads (portable): `readers` blocking threads, each opening and reading
+//    whole files (MappedFile: one read() for small files, mmap for big ones).
+// Auto picks io_uring when the kernel allows it and falls back otherwise. If
+// io_uring_enter fails mid-run, the files in flight and the rest are read on
+// threads.
+//
+// Files are handed to the consumer in batches through a BoundedQueue, in
+// completion order; IngestedFile::index says which path it was.
+
+enum class IngestBackend { Auto, IoUring, Threads };
+
+const char* ingestBackendName(IngestBackend backend);   // "auto", "io_uring", "threads"
+bool parseIngestBackend(const std::string& name, IngestBackend& backend);
+
+// true if an io_uring can be set up here (kernel support, not disabled by
+// sysctl or a seccomp filter)
+bool ioUringAvailable();
+
+struct IngestOptions
+{
+    IngestBackend backend = IngestBackend::Auto;
+    unsigned queueDepth = 64;                 // io_uring: files in flight
+    unsigned readers = 8;                     // Threads: reader threads (0 = one per core)
+    size_t batchSize = 64;                    // files per batch handed to the consumer
+    size_t prefetch = 4;                      // batches buffered ahead of the consumer
+    size_t maxFileBytes = size_t(64) << 20;   // larger files fail with an error
+};
+
+struct IngestedFile
+{
+    size_t index = 0;           // position in the path list
+    std::string error;          // empty = ok
+    std::vector<char> bytes;    // io_uring backend
+    MappedFile file;            // Threads backend
+
+    bool ok() const { return error.empty(); }
+    std::string_view view() const
+    {
+        return bytes.empty() ? file.view() : std::string_view(bytes.data(), bytes.size());
+    }
+};
+
+using IngestBatch = std::vector<IngestedFile>;
+
+struct IngestStats
+{
+    IngestBackend backend = IngestBackend::Threads;   // the one that ran
+    size_t files = 0;
+    size_t failed = 0;
+    uint64_t bytes = 0;
+    uint64_t submitCalls = 0;   // io_uring_enter calls (io_uring backend)
+    double seconds = 0.0;
+};
+
+// Reads every path and pushes the files to out in batches; closes out at the
+// end. Runs on the calling thread (give it its own, the consumer pops on
+// another). Stops early, after draining the files in flight, if the consumer
+// closes out.
+IngestStats readFiles(const std::vector<std::string>& paths, BoundedQueue<IngestBatch>& out,
+    const IngestOptions& options = IngestOptions());
+
+// Regular files under root, recursively, sorted. Unreadable subdirectories
+// are skipped. false + error if root cannot be listed.
+bool listFiles(const std::string& root, std::vector<std::string>& paths, std::string* error = nullptr);
+
+// readFiles on a helper thread feeding Featurizer::extract on the pool.
+// rows[i] / errors[i] belong to paths[i]; errors[i] is empty on success.
+IngestStats extractFiles(const std::vector<std::string>& paths, const Featurizer& featurizer, ThreadPool& pool,
+    std::vector<SparseVector>& rows, std::vector<std::string>& errors,
+    const IngestOptions& options = IngestOptions());
@@ -0,0 +1,366 @@
+#include "CrossValidation.h"
+#include "AveragedPerceptron.h"
+#include "LeastSquares.h"
+#include "Perceptron.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <random>
+#include <utility>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double secondsSince(Clock::time_point t0)
+    {
+        return std::chrono::duration<double>(Clock::now() - t0).count();
+    }
+
+    struct Fold
+    {
+        std::vector<size_t> train;
+        std::vector<size_t> test;
+    };
+
+    struct FoldResult
+    {
+        ConfusionCounts counts;
+        double seconds = 0.0;
+    };
+
+    // One training run per fold: the configurations in it differ only in the
+    // epoch count (evaluated on the way) or, for least squares, the ridge
+    struct Run
+    {
+        TrainingMode mode = TrainingMode::Sgd;
+        double learningRate = 0.0;
+        int epochs = 0;                    // largest of the configurations
+        std::vector<size_t> configs;       // by increasing epochs
+    };
+
+    void loadRow(const SparseDataset& data, size_t r, SparseVector& x)
+    {
+        x.dimension = data.cols();
+        x.indices.assign(data.rowIndices(r), data.rowIndices(r) + data.rowNnz(r));
+        x.values.assign(data.rowValues(r), data.rowValues(r) + data.rowNnz(r));
+    }
+
+    // predictions as Perceptron::predict makes them (score >= 0 -> 1)
+    ConfusionCounts evaluate(const SparseDataset& data, const std::vector<size_t>& rows,
+        const std::vector<double>& w, double b)
+    {
+        ConfusionCounts c;
+        for (size_t r : rows)
+        {
+            const uint32_t* idx = data.rowIndices(r);
+            const double* val = data.rowValues(r);
+            double s = b;
+            for (size_t k = 0, n = data.rowNnz(r); k < n; ++k) s += w[idx[k]] * val[k];
+            const bool predicted = s >= 0.0, actual = data.label(r) > 0;
+            if (predicted) ++(actual ? c.truePositives : c.falsePositives);
+            else ++(actual ? c.falseNegatives : c.trueNegatives);
+        }
+        return c;
+    }
+
+    std::vector<Fold> makeFolds(const SparseDataset& data, const CrossValidationOptions& options)
+    {
+        const unsigned k = options.folds;
+        std::mt19937 rng(options.seed);
+        std::vector<unsigned> foldOf(data.rows());
+        size_t next = 0;
+        auto deal = [&](std::vector<size_t>& rows) {
+            std::shuffle(rows.begin(), rows.end(), rng);
+            for (size_t r : rows) foldOf[r] = static_cast<unsigned>(next++ % k);
+        };
+
+        std::vector<size_t> positive, negative;
+        for (size_t r = 0; r < data.rows(); ++r)
+            (options.stratify && data.label(r) > 0 ? positive : negative).push_back(r);
+        deal(positive);
+        deal(negative);
+
+        std::vector<Fold> folds(k);
+        for (size_t r = 0; r < data.rows(); ++r)
+            for (unsigned f = 0; f < k; ++f)
+                (foldOf[r] == f ? folds[f].test : folds[f].train).push_back(r);
+        return folds;
+    }
+
+    std::vector<Run> planRuns(const std::vector<TrainingConfig>& configs)
+    {
+        std::vector<Run> runs;
+        std::map<std::pair<int, double>, size_t> byKey;   // (mode, learning rate) -> run
+        for (size_t i = 0; i < configs.size(); ++i)
+        {
+            const TrainingConfig& c = configs[i];
+            const bool ls = c.mode == TrainingMode::LeastSquares;
+            const auto key = std::make_pair(static_cast<int>(c.mode), ls ? 0.0 : c.learningRate);
+            auto it = byKey.find(key);
+            if (it == byKey.end())
+            {
+                it = byKey.emplace(key, runs.size()).first;
+                runs.emplace_back();
+                runs.back().mode = c.mode;
+                runs.back().learningRate = c.learningRate;
+            }
+            Run& run = runs[it->second];
+            run.configs.push_back(i);
+            if (!ls) run.epochs = (std::max)(run.epochs, c.epochs);
+        }
+        for (Run& run : runs)
+            std::stable_sort(run.configs.begin(), run.configs.end(),
+                [&](size_t a, size_t b) { return configs[a].epochs < configs[b].epochs; });
+
+        // longest runs first, so the pool does not end on one big task
+        std::stable_sort(runs.begin(), runs.end(), [](const Run& a, const Run& b) {
+            return (std::max)(a.epochs, 1) > (std::max)(b.epochs, 1);
+        });
+        return runs;
+    }
+
+    void runIterative(const SparseDataset& data, const std::vector<TrainingConfig>& configs, const Run& run,
+        const Fold& fold, unsigned foldIndex, const CrossValidationOptions& options,
+        std::vector<std::vector<FoldResult>>& results)
+    {
+        // the constructor's initial weights are seeded from the clock; draw them
+        // from the same range with a per-fold seed instead, so that every run
+        // on this fold starts from the same point and results are reproducible
+        Perceptron model(static_cast<int>(data.cols()), run.learningRate);
+        std::mt19937 rng(options.seed + foldIndex);
+        std::uniform_real_distribution<double> init(-0.5, 0.5);
+        std::vector<double> w(data.cols());
+        for (double& v : w) v = init(rng);
+        model.setParameters(w, init(rng));
+
+        std::unique_ptr<AveragedPerceptron> averager;
+        if (run.mode == TrainingMode::Averaged) averager.reset(new AveragedPerceptron(model));
+
+        // same sample order on this fold for every run
+        std::vector<size_t> order = fold.train;
+        thread_local SparseVector x;
+        double b = 0.0;
+        double trained = 0.0;
+        size_t next = 0;
+        for (int e = 0; next < run.configs.size(); ++e)
+        {
+            if (e > 0)
+            {
+                const auto t0 = Clock::now();
+                if (options.shuffle) std::shuffle(order.begin(), order.end(), rng);
+                for (size_t r : order)
+                {
+                    loadRow(data, r, x);
+                    if (averager) averager->train(x, data.label(r));
+                    else model.train(x, data.label(r));
+                }
+                trained += secondsSince(t0);
+            }
+            for (; next < run.configs.size() && configs[run.configs[next]].epochs <= e; ++next)
+            {
+                const auto t0 = Clock::now();
+                if (averager) averager->averaged(w, b);
+                else
+                {
+                    w = model.getWeights();
+                    b = model.getBias();
+                }
+                FoldResult& out = results[run.configs[next]][foldIndex];
+                out.counts = evaluate(data, fold.test, w, b);
+                out.seconds = trained + secondsSince(t0);
+            }
+        }
+    }
+
+    bool runLeastSquares(const SparseDataset& data, const std::vector<TrainingConfig>& configs, const Run& run,
+        const Fold& fold, unsigned foldIndex, std::vector<std::vector<FoldResult>>& results, std::string& error)
+    {
+        const auto t0 = Clock::now();
+        GramAccumulator sums(data.cols());
+        thread_local SparseVector x;
+        for (size_t r : fold.train)
+        {
+            loadRow(data, r, x);
+            sums.add(x, data.label(r));
+        }
+        const double pass = secondsSince(t0);
+
+        std::vector<double> w;
+        double b = 0.0;
+        for (size_t c : run.configs)
+        {
+            const auto t1 = Clock::now();
+            if (!solveLeastSquares(sums, configs[c].ridge, w, b, &error)) return false;
+            FoldResult& out = results[c][foldIndex];
+            out.counts = evaluate(data, fold.test, w, b);
+            out.seconds = pass + secondsSince(t1);
+        }
+        return true;
+    }
+}
+
+const char* trainingModeName(TrainingMode mode)
+{
+    switch (mode)
+    {
+    case TrainingMode::Sgd: return "sgd";
+    case TrainingMode::Averaged: return "averaged";
+    case TrainingMode::LeastSquares: return "ls";
+    }
+    return "?";
+}
+
+bool parseTrainingMode(const std::string& name, TrainingMode& mode)
+{
+    for (TrainingMode m : { TrainingMode::Sgd, TrainingMode::Averaged, TrainingMode::LeastSquares })
+    {
+        if (name == trainingModeName(m))
+        {
+            mode = m;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<TrainingConfig> expandGrid(const SearchGrid& grid)
+{
+    std::vector<TrainingConfig> configs;
+    for (TrainingMode mode : grid.modes)
+    {
+        TrainingConfig c;
+        c.mode = mode;
+        if (mode == TrainingMode::LeastSquares)
+        {
+            for (double ridge : grid.ridges)
+            {
+                c.ridge = ridge;
+                configs.push_back(c);
+            }
+            continue;
+        }
+        for (double lr : grid.learningRates)
+        {
+            for (int epochs : grid.epochs)
+            {
+                c.learningRate = lr;
+                c.epochs = epochs;
+                configs.push_back(c);
+            }
+        }
+    }
+    return configs;
+}
+
+bool crossValidate(const SparseDataset& data, const std::vector<TrainingConfig>& configs, ThreadPool& pool,
+    const CrossValidationOptions& options, CrossValidationReport& report, std::string* error)
+{
+    const auto start = Clock::now();
+    const unsigned k = options.folds;
+    if (k < 2 || data.rows() < k)
+    {
+        if (error) *error = "need at least 2 folds and one sample per fold (" + std::to_string(data.rows())
+            + " samples, " + std::to_string(k) + " folds)";
+        return false;
+    }
+    for (const TrainingConfig& c : configs)
+    {
+        if (c.mode == TrainingMode::LeastSquares && data.cols() > kMaxLeastSquaresDimension)
+        {
+            if (error) *error = "least squares supports at most " + std::to_string(kMaxLeastSquaresDimension)
+                + " features, the data has " + std::to_string(data.cols());
+            return false;
+        }
+    }
+
+    const std::vector<Fold> folds = makeFolds(data, options);
+    const std::vector<Run> runs = planRuns(configs);
+    std::vector<std::vector<FoldResult>> results(configs.size(), std::vector<FoldResult>(k));
+    std::vector<std::string> errors(runs.size() * k);
+
+    // task t = (run t / k, fold t % k); every task writes its own result slots
+    pool.parallelFor(runs.size() * k, [&](size_t t) {
+        const Run& run = runs[t / k];
+        const unsigned f = static_cast<unsigned>(t % k);
+        if (run.mode == TrainingMode::LeastSquares)
+            runLeastSquares(data, configs, run, folds[f], f, results, errors[t]);
+        else
+            runIterative(data, configs, run, folds[f], f, options, results);
+    });
+    for (const std::string& e : errors)
+    {
+        if (!e.empty())
+        {
+            if (error) *error = e;
+            return false;
+        }
+    }
+
+    report = CrossValidationReport();
+    report.samples = data.rows();
+    report.folds = k;
+    report.tasks = runs.size() * k;
+    report.results.resize(configs.size());
+    for (size_t c = 0; c < configs.size(); ++c)
+    {
+        ConfigResult& r = report.results[c];
+        r.config = configs[c];
+        double sum = 0.0, sumSq = 0.0;
+        for (const FoldResult& f : results[c])
+        {
+            r.counts.add(f.counts);
+            r.seconds += f.seconds;
+            const double a = f.counts.accuracy();
+            sum += a;
+            sumSq += a * a;
+        }
+        r.accuracyMean = sum / k;
+        r.accuracyStddev = std::sqrt((std::max)(0.0, sumSq / k - r.accuracyMean * r.accuracyMean));
+    }
+    report.wallSeconds = secondsSince(start);
+    return true;
+}
+
+bool extractManifest(const Featurizer& featurizer, const std::string& manifest, ThreadPool& pool,
+    SparseDataset& data, StreamingStats* stats, std::string* error, const IngestOptions& ingest)
+{
+    ManifestReader reader;
+    if (!reader.open(manifest, error)) return false;
+
+    StreamingStats local;
+    std::vector<std::string> paths;
+    std::vector<int> labels;
+    std::string path, problem;
+    int label = 0;
+    while (reader.next(path, label, problem))
+    {
+        if (!problem.empty())
+        {
+            local.noteProblem(std::move(problem));
+            continue;
+        }
+        paths.push_back(path);
+        labels.push_back(label);
+    }
+
+    std::vector<SparseVector> rows;
+    std::vector<std::string> errors;
+    extractFiles(paths, featurizer, pool, rows, errors, ingest);
+
+    data = SparseDataset(featurizer.dimension());
+    for (size_t i = 0; i < paths.size(); ++i)
+    {
+        if (!errors[i].empty())
+        {
+            local.noteProblem(std::move(errors[i]));
+            continue;
+        }
+        data.addRow(rows[i], labels[i]);
+        ++local.samples;
+    }
+    if (stats) *stats = std::move(local);
+    return true;
+}
@@ -0,0 +1,122 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "CorpusIngest.h"
+#include "Dataset.h"
+#include "Featurizer.h"
+#include "StreamingTrainer.h"
+#include "ThreadPool.h"
+
+// k-fold cross-validation over a grid of training configurations.
+//
+// The corpus is extracted once into a SparseDataset; every fold and every
+// configuration reads that one matrix (the folds are row lists, nothing is
+// copied), so hundreds of configurations cost training time only. Work is
+// cut into (training run, fold) tasks on a ThreadPool. Configurations that
+// differ only in their epoch count share a training run: the model is
+// evaluated at each requested epoch on the way to the largest one. Least
+// squares configurations share one pass over each fold and differ only in
+// the solve.
+
+enum class TrainingMode
+{
+    Sgd,            // Perceptron::train, one update per sample
+    Averaged,       // AveragedPerceptron
+    LeastSquares    // closed-form ridge solve (LeastSquares.h); learning rate and epochs unused
+};
+
+const char* trainingModeName(TrainingMode mode);                   // "sgd", "averaged", "ls"
+bool parseTrainingMode(const std::string& name, TrainingMode& mode);
+
+struct TrainingConfig
+{
+    TrainingMode mode = TrainingMode::Sgd;
+    double learningRate = 0.001;
+    int epochs = 10;
+    double ridge = 1e-3;     // LeastSquares only
+};
+
+// Every mode x learning rate x epoch count; least squares once per ridge
+struct SearchGrid
+{
+    std::vector<TrainingMode> modes{ TrainingMode::Sgd, TrainingMode::Averaged, TrainingMode::LeastSquares };
+    std::vector<double> learningRates{ 0.001, 0.01, 0.1 };
+    std::vector<int> epochs{ 5, 10, 20 };
+    std::vector<double> ridges{ 1e-3 };
+};
+
+std::vector<TrainingConfig> expandGrid(const SearchGrid& grid);
+
+// Binary confusion counts; label 1 is the positive class
+struct ConfusionCounts
+{
+    size_t truePositives = 0;
+    size_t falsePositives = 0;
+    size_t trueNegatives = 0;
+    size_t falseNegatives = 0;
+
+    size_t total() const { return truePositives + falsePositives + trueNegatives + falseNegatives; }
+    double accuracy() const { return ratio(truePositives + trueNegatives, total()); }
+    double precision() const { return ratio(truePositives, truePositives + falsePositives); }
+    double recall() const { return ratio(truePositives, truePositives + falseNegatives); }
+    double f1() const
+    {
+        const double p = precision(), r = recall();
+        return p + r > 0.0 ? 2.0 * p * r / (p + r) : 0.0;
+    }
+
+    void add(const ConfusionCounts& o)
+    {
+        truePositives += o.truePositives;
+        falsePositives += o.falsePositives;
+        trueNegatives += o.trueNegatives;
+        falseNegatives += o.falseNegatives;
+    }
+
+private:
+    static double ratio(size_t a, size_t b) { return b ? static_cast<double>(a) / static_cast<double>(b) : 0.0; }
+};
+
+struct CrossValidationOptions
+{
+    unsigned folds = 5;
+    unsigned seed = 0;       // fold assignment and per-epoch shuffles
+    bool shuffle = true;     // reshuffle the training rows every epoch
+    bool stratify = true;    // keep the label ratio the same in every fold
+};
+
+struct ConfigResult
+{
+    TrainingConfig config;
+    ConfusionCounts counts;        // held-out predictions of all folds together
+    double accuracyMean = 0.0;     // over folds
+    double accuracyStddev = 0.0;
+    // time to train and evaluate this configuration on every fold, summed
+    // over folds, as if it had run alone (a shared training run is charged
+    // in full to each configuration that uses it)
+    double seconds = 0.0;
+};
+
+struct CrossValidationReport
+{
+    std::vector<ConfigResult> results;   // in the order of the configurations
+    size_t samples = 0;
+    unsigned folds = 0;
+    size_t tasks = 0;                    // (training run, fold) tasks executed
+    double wallSeconds = 0.0;
+};
+
+// Runs every configuration on every fold. Labels must be 0 or 1. false +
+// error if there are fewer rows than folds, folds < 2, or a least squares
+// configuration does not fit (kMaxLeastSquaresDimension).
+bool crossValidate(const SparseDataset& data, const std::vector<TrainingConfig>& configs, ThreadPool& pool,
+    const CrossValidationOptions& options, CrossValidationReport& report, std::string* error = nullptr);
+
+// Extracts every document of a 'path<TAB>label' manifest (ManifestReader)
+// into data, in manifest order: the files are read by CorpusIngest (ingest
+// picks the backend) and tokenized on the pool. Unreadable files and bad
+// lines are skipped and counted in *stats. false + error only if the
+// manifest cannot be read.
+bool extractManifest(const Featurizer& featurizer, const std::string& manifest, ThreadPool& pool,
+    SparseDataset& data, StreamingStats* stats = nullptr, std::string* error = nullptr,
+    const IngestOptions& ingest = IngestOptions());
@@ -0,0 +1,171 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+#include "SparseVector.h"
+
+// Minimal allocator that hands out `Align`-byte aligned blocks.
+template <class T, size_t Align>
+struct AlignedAllocator
+{
+    using value_type = T;
+    template <class U> struct rebind { using other = AlignedAllocator<U, Align>; };
+
+    AlignedAllocator() = default;
+    template <class U> AlignedAllocator(const AlignedAllocator<U, Align>&) {}
+
+    T* allocate(size_t n)
+    {
+        void* p = ::operator new(n * sizeof(T), std::align_val_t(Align));
+        return static_cast<T*>(p);
+    }
+    void deallocate(T* p, size_t) { ::operator delete(p, std::align_val_t(Align)); }
+
+    template <class U> bool operator==(const AlignedAllocator<U, Align>&) const { return true; }
+    template <class U> bool operator!=(const AlignedAllocator<U, Align>&) const { return false; }
+};
+
+// Training samples as one contiguous, row-major matrix plus a label array.
+// Rows are padded to a multiple of 8 doubles so every row starts on a 64-byte
+// boundary; padding is always zero.
+class Dataset
+{
+public:
+    static constexpr size_t kRowAlign = 64 / sizeof(double);
+
+    Dataset() = default;
+    explicit Dataset(size_t cols) : numCols(cols), rowStride(paddedStride(cols)) {}
+
+    size_t rows() const { return labels.size(); }
+    size_t cols() const { return numCols; }
+    size_t stride() const { return rowStride; }
+    bool empty() const { return labels.empty(); }
+
+    const double* row(size_t i) const { return values.data() + i * rowStride; }
+    double* row(size_t i) { return values.data() + i * rowStride; }
+    int label(size_t i) const { return labels[i]; }
+    const std::vector<int>& getLabels() const { return labels; }
+
+    void reserve(size_t n)
+    {
+        values.reserve(n * rowStride);
+        labels.reserve(n);
+    }
+
+    void clear()
+    {
+        values.clear();
+        labels.clear();
+    }
+
+    // append a sample; extra inputs beyond cols() are ignored, missing ones are 0
+    void addRow(const std::vector<double>& x, int y)
+    {
+        const size_t base = values.size();
+        values.resize(base + rowStride, 0.0);
+        const size_t n = x.size() < numCols ? x.size() : numCols;
+        for (size_t j = 0; j < n; ++j) values[base + j] = x[j];
+        labels.push_back(y);
+    }
+
+    void addRow(const SparseVector& x, int y)
+    {
+        const size_t base = values.size();
+        values.resize(base + rowStride, 0.0);
+        for (size_t k = 0; k < x.nnz(); ++k)
+            if (x.indices[k] < numCols) values[base + x.indices[k]] = x.values[k];
+        labels.push_back(y);
+    }
+
+    std::vector<double> rowVector(size_t i) const
+    {
+        return std::vector<double>(row(i), row(i) + numCols);
+    }
+
+private:
+    static size_t paddedStride(size_t cols) { return (cols + kRowAlign - 1) / kRowAlign * kRowAlign; }
+
+    size_t numCols = 0;
+    size_t rowStride = 0;
+    std::vector<double, AlignedAllocator<double, 64>> values;
+    std::vector<int> labels;
+};
+
+// Sparse training samples in CSR form: the non-zeros of all rows live in two
+// flat arrays, and rowStart[i]..rowStart[i+1] delimits row i.
+class SparseDataset
+{
+public:
+    SparseDataset() = default;
+    explicit SparseDataset(size_t cols) : numCols(cols) {}
+
+    size_t rows() const { return labels.size(); }
+    size_t cols() const { return numCols; }
+    size_t nnz() const { return indices.size(); }
+    bool empty() const { return labels.empty(); }
+
+    size_t rowNnz(size_t i) const { return rowStart[i + 1] - rowStart[i]; }
+    const uint32_t* rowIndices(size_t i) const { return indices.data() + rowStart[i]; }
+    const double* rowValues(size_t i) const { return values.data() + rowStart[i]; }
+    int label(size_t i) const { return labels[i]; }
+    const std::vector<int>& getLabels() const { return labels; }
+
+    void reserve(size_t rowCount, size_t nnzCount)
+    {
+        rowStart.reserve(rowCount + 1);
+        labels.reserve(rowCount);
+        indices.reserve(nnzCount);
+        values.reserve(nnzCount);
+    }
+
+    void clear()
+    {
+        rowStart.assign(1, 0);
+        indices.clear();
+        values.clear();
+        labels.clear();
+    }
+
+    // append a sample; entries with index >= cols() are dropped
+    void addRow(const SparseVector& x, int y)
+    {
+        for (size_t k = 0; k < x.nnz(); ++k)
+        {
+            if (x.indices[k] >= numCols) continue;
+            indices.push_back(x.indices[k]);
+            values.push_back(x.values[k]);
+        }
+        rowStart.push_back(indices.size());
+        labels.push_back(y);
+    }
+
+    void addRow(const std::vector<double>& x, int y)
+    {
+        const size_t n = x.size() < numCols ? x.size() : numCols;
+        for (size_t j = 0; j < n; ++j)
+        {
+            if (x[j] == 0.0) continue;
+            indices.push_back(static_cast<uint32_t>(j));
+            values.push_back(x[j]);
+        }
+        rowStart.push_back(indices.size());
+        labels.push_back(y);
+    }
+
+    SparseVector rowVector(size_t i) const
+    {
+        SparseVector sv;
+        sv.dimension = numCols;
+        sv.indices.assign(rowIndices(i), rowIndices(i) + rowNnz(i));
+        sv.values.assign(rowValues(i), rowValues(i) + rowNnz(i));
+        return sv;
+    }
+
+private:
+    size_t numCols = 0;
+    std::vector<size_t> rowStart{ 0 };
+    std::vector<uint32_t> indices;
+    std::vector<double> values;
+    std::vector<int> labels;
+};
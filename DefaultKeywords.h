@@ -0,0 +1,12 @@
+#pragma once
+#include <array>
+#include <string_view>
+
+// The production spam keyword set. Known at compile time so the embedded
+// filter (FixedPerceptron / FixedKeywordMatcher) can be specialized for it;
+// the GUI builds its runtime keyword list from the same table.
+constexpr std::array<std::string_view, 20> kDefaultKeywords = {
+    "free", "win", "money", "offer", "click", "buy", "urgent",
+    "reward", "account", "verify", "login", "pin", "selected",
+    "limited", "now", "risk", "credit", "deal", "bonus", "gift"
+};
@@ -0,0 +1,401 @@
+#include "FeatureCache.h"
+#include "ModelFormat.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#endif
+
+// On-disk record, one per cached document. pathOffset is relative to the path
+// block; dataOffset to the data block, where a document is nnz uint32 indices,
+// zero padding to 8 bytes, then nnz doubles.
+struct FeatureCache::Entry
+{
+    uint64_t pathHash;
+    uint64_t fileSize;
+    int64_t mtimeNs;
+    uint64_t pathOffset;
+    uint64_t dataOffset;
+    uint64_t dataChecksum;
+    uint32_t pathLen;
+    uint32_t nnz;
+};
+static_assert(sizeof(FeatureCache::Entry) == 56, "cache entry layout is part of the file format");
+
+namespace
+{
+    struct CacheHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t headerSize;
+        uint64_t configHash;
+        uint64_t entryCount;
+        uint64_t pathsOffset;
+        uint64_t pathsSize;
+        uint64_t dataOffset;
+        uint64_t dataSize;
+        uint64_t metaChecksum;   // header (this field zeroed) + entries + paths
+    };
+    static_assert(sizeof(CacheHeader) == 72, "cache header layout is part of the file format");
+
+    constexpr char kCacheMagic[8] = { 'P', 'C', 'P', 'T', 'F', 'C', 'A', 'C' };
+    constexpr uint32_t kCacheVersion = 1;
+
+    bool hostIsLittleEndian()
+    {
+        const uint16_t probe = 1;
+        unsigned char first;
+        std::memcpy(&first, &probe, 1);
+        return first == 1;
+    }
+
+    size_t dataBytes(size_t nnz)
+    {
+        const size_t idx = (nnz * sizeof(uint32_t) + 7) / 8 * 8;
+        return idx + nnz * sizeof(double);
+    }
+
+    uint64_t pathHashOf(const std::string& path)
+    {
+        return modelChecksum(path.data(), path.size());
+    }
+
+    bool fail(std::string* error, const std::string& msg)
+    {
+        if (error) *error = msg;
+        return false;
+    }
+}
+
+bool statFile(const std::string& path, FileStamp& stamp)
+{
+#ifdef _WIN32
+    WIN32_FILE_ATTRIBUTE_DATA info;
+    if (!GetFileAttributesExA(path.c_str(), GetFileExInfoStandard, &info)) return false;
+    stamp.size = (static_cast<uint64_t>(info.nFileSizeHigh) << 32) | info.nFileSizeLow;
+    const uint64_t ticks = (static_cast<uint64_t>(info.ftLastWriteTime.dwHighDateTime) << 32)
+        | info.ftLastWriteTime.dwLowDateTime;
+    stamp.mtimeNs = static_cast<int64_t>(ticks * 100); // 100 ns units
+#else
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) return false;
+    stamp.size = static_cast<uint64_t>(st.st_size);
+#ifdef __APPLE__
+    stamp.mtimeNs = static_cast<int64_t>(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+    stamp.mtimeNs = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+#endif
+    return true;
+}
+
+uint64_t featureConfigHash(const FeatureConfig& config)
+{
+    uint64_t h = modelChecksum("features", 8, static_cast<uint64_t>(config.mode));
+    if (config.mode == FeatureMode::Hashing)
+    {
+        const uint64_t params[3] = { config.hashing.bits, config.hashing.seed, config.hashing.signedHash ? 1u : 0u };
+        return modelChecksum(params, sizeof(params), h);
+    }
+    // substring configs hash as before, so existing caches stay valid
+    if (config.match == KeywordMatch::ExactToken)
+        h = modelChecksum("exact", 5, h);
+    for (const auto& k : config.keywords)
+    {
+        const uint64_t len = k.size();
+        h = modelChecksum(&len, sizeof(len), h);
+        h = modelChecksum(k.data(), k.size(), h);
+    }
+    return h;
+}
+
+void FeatureCache::reset()
+{
+    file.close();
+    entries = nullptr;
+    entryCount = 0;
+    paths = nullptr;
+    data = nullptr;
+    pathsSize = 0;
+    dataSize = 0;
+    used.reset();
+}
+
+bool FeatureCache::open(const std::string& filename, const FeatureConfig& featureConfig, std::string* error)
+{
+    reset();
+    path = filename;
+    config = featureConfig;
+    configHash = featureConfigHash(config);
+    {
+        std::lock_guard<std::mutex> guard(pendingLock);
+        pending.clear();
+    }
+
+    FileStamp stamp;
+    if (!statFile(filename, stamp)) return true; // no cache yet
+    if (!hostIsLittleEndian())
+        return fail(error, "feature caches are only supported on little-endian hosts");
+
+    MappedFile f;
+    if (!f.open(filename, error, /*sequential=*/false)) return false;
+    const std::string_view bytes = f.view();
+
+    CacheHeader h;
+    if (bytes.size() < sizeof(h))
+        return fail(error, "'" + filename + "' is too small to be a feature cache");
+    std::memcpy(&h, bytes.data(), sizeof(h));
+    if (std::memcmp(h.magic, kCacheMagic, sizeof(h.magic)) != 0
+        || h.version != kCacheVersion || h.headerSize != sizeof(CacheHeader))
+        return fail(error, "'" + filename + "' is not a feature cache of a supported version");
+    if (h.configHash != configHash) return true; // built for other features: start empty
+
+    const uint64_t entriesSize = h.entryCount * sizeof(Entry);
+    if (h.entryCount > bytes.size() / sizeof(Entry) || sizeof(h) + entriesSize > bytes.size()
+        || h.pathsOffset < sizeof(h) + entriesSize
+        || h.pathsOffset > bytes.size() || h.pathsSize > bytes.size() - h.pathsOffset
+        || h.dataOffset > bytes.size() || h.dataSize > bytes.size() - h.dataOffset || h.dataOffset % 8 != 0)
+        return fail(error, "'" + filename + "' is truncated or has inconsistent sections");
+
+    CacheHeader zeroed = h;
+    zeroed.metaChecksum = 0;
+    uint64_t c = modelChecksum(&zeroed, sizeof(zeroed));
+    c = modelChecksum(bytes.data() + sizeof(h), static_cast<size_t>(entriesSize), c);
+    c = modelChecksum(bytes.data() + h.pathsOffset, static_cast<size_t>(h.pathsSize), c);
+    if (c != h.metaChecksum)
+        return fail(error, "'" + filename + "': checksum mismatch");
+
+    file = std::move(f);
+    const char* base = file.view().data();
+    entries = reinterpret_cast<const Entry*>(base + sizeof(h));
+    entryCount = static_cast<size_t>(h.entryCount);
+    paths = base + h.pathsOffset;
+    pathsSize = h.pathsSize;
+    data = base + h.dataOffset;
+    dataSize = h.dataSize;
+    used.reset(new std::atomic<bool>[entryCount]);
+    for (size_t i = 0; i < entryCount; ++i) used[i].store(false, std::memory_order_relaxed);
+    return true;
+}
+
+const FeatureCache::Entry* FeatureCache::findEntry(const std::string& p) const
+{
+    const uint64_t hash = pathHashOf(p);
+    const Entry* end = entries + entryCount;
+    const Entry* it = std::lower_bound(entries, end, hash,
+        [](const Entry& e, uint64_t v) { return e.pathHash < v; });
+    for (; it != end && it->pathHash == hash; ++it)
+    {
+        if (it->pathLen == p.size() && it->pathOffset <= pathsSize && it->pathLen <= pathsSize - it->pathOffset
+            && std::memcmp(paths + it->pathOffset, p.data(), p.size()) == 0)
+            return it;
+    }
+    return nullptr;
+}
+
+bool FeatureCache::readEntry(const Entry& e, SparseVector& out) const
+{
+    const size_t bytes = dataBytes(e.nnz);
+    if (e.dataOffset > dataSize || bytes > dataSize - e.dataOffset) return false;
+    const char* p = data + e.dataOffset;
+    if (modelChecksum(p, bytes) != e.dataChecksum) return false;
+
+    out.dimension = config.dimension();
+    out.indices.resize(e.nnz);
+    out.values.resize(e.nnz);
+    std::memcpy(out.indices.data(), p, e.nnz * sizeof(uint32_t));
+    std::memcpy(out.values.data(), p + bytes - e.nnz * sizeof(double), e.nnz * sizeof(double));
+    for (uint32_t idx : out.indices)
+        if (idx >= out.dimension) return false;
+    return true;
+}
+
+bool FeatureCache::lookup(const std::string& p, SparseVector& out, FileStamp& stamp)
+{
+    stamp = FileStamp();
+    if (statFile(p, stamp))
+    {
+        {
+            std::lock_guard<std::mutex> guard(pendingLock);
+            auto it = pending.find(p);
+            if (it != pending.end() && it->second.stamp == stamp)
+            {
+                out = it->second.features;
+                hitCount.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        const Entry* e = findEntry(p);
+        if (e && e->fileSize == stamp.size && e->mtimeNs == stamp.mtimeNs && readEntry(*e, out))
+        {
+            used[e - entries].store(true, std::memory_order_relaxed);
+            hitCount.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    missCount.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+void FeatureCache::insert(const std::string& p, const FileStamp& stamp, const SparseVector& features)
+{
+    std::lock_guard<std::mutex> guard(pendingLock);
+    Pending& slot = pending[p];
+    slot.stamp = stamp;
+    slot.features = features;
+}
+
+size_t FeatureCache::size() const
+{
+    std::lock_guard<std::mutex> guard(pendingLock);
+    size_t n = pending.size();
+    for (size_t i = 0; i < entryCount; ++i)
+    {
+        const Entry& e = entries[i];
+        if (pending.count(std::string(paths + e.pathOffset, e.pathLen)) == 0) ++n;
+    }
+    return n;
+}
+
+bool FeatureCache::save(std::string* error, bool pruneUnused)
+{
+    if (path.empty()) return fail(error, "feature cache was never opened");
+    if (!hostIsLittleEndian())
+        return fail(error, "feature caches are only supported on little-endian hosts");
+
+    // one item per output entry: either an existing record or a pending one
+    struct Item
+    {
+        uint64_t hash;
+        std::string path;
+        const Entry* old;
+        const Pending* fresh;
+    };
+    std::vector<Item> items;
+    {
+        std::lock_guard<std::mutex> guard(pendingLock);
+        items.reserve(entryCount + pending.size());
+        for (size_t i = 0; i < entryCount; ++i)
+        {
+            const Entry& e = entries[i];
+            if (pruneUnused && !used[i].load(std::memory_order_relaxed)) continue;
+            std::string p(paths + e.pathOffset, e.pathLen);
+            if (pending.count(p)) continue; // superseded
+            items.push_back({ e.pathHash, std::move(p), &e, nullptr });
+        }
+        for (const auto& kv : pending)
+            items.push_back({ pathHashOf(kv.first), kv.first, nullptr, &kv.second });
+    }
+    std::sort(items.begin(), items.end(), [](const Item& a, const Item& b) {
+        return a.hash != b.hash ? a.hash < b.hash : a.path < b.path;
+    });
+
+    // lay out entries, path bytes and data
+    std::vector<Entry> outEntries(items.size());
+    std::string pathBlock;
+    uint64_t dataPos = 0;
+    for (size_t i = 0; i < items.size(); ++i)
+    {
+        const Item& it = items[i];
+        Entry& e = outEntries[i];
+        e.pathHash = it.hash;
+        e.pathOffset = pathBlock.size();
+        e.pathLen = static_cast<uint32_t>(it.path.size());
+        pathBlock += it.path;
+        if (it.old)
+        {
+            e.fileSize = it.old->fileSize;
+            e.mtimeNs = it.old->mtimeNs;
+            e.nnz = it.old->nnz;
+            e.dataChecksum = it.old->dataChecksum;
+        }
+        else
+        {
+            e.fileSize = it.fresh->stamp.size;
+            e.mtimeNs = it.fresh->stamp.mtimeNs;
+            e.nnz = static_cast<uint32_t>(it.fresh->features.nnz());
+            e.dataChecksum = 0; // filled while writing
+        }
+        e.dataOffset = dataPos;
+        dataPos += dataBytes(e.nnz);
+    }
+
+    CacheHeader h{};
+    std::memcpy(h.magic, kCacheMagic, sizeof(h.magic));
+    h.version = kCacheVersion;
+    h.headerSize = sizeof(CacheHeader);
+    h.configHash = configHash;
+    h.entryCount = outEntries.size();
+    h.pathsOffset = sizeof(CacheHeader) + outEntries.size() * sizeof(Entry);
+    h.pathsSize = pathBlock.size();
+    h.dataOffset = (h.pathsOffset + h.pathsSize + 7) / 8 * 8;
+    h.dataSize = dataPos;
+
+    // The data block is streamed first (it fills in the checksums of new
+    // entries); header, entries and paths are written over the reserved
+    // space at the start afterwards.
+    const std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out) return fail(error, "cannot create '" + tmp + "'");
+
+        const std::string head(static_cast<size_t>(h.dataOffset), '\0');
+        out.write(head.data(), static_cast<std::streamsize>(head.size()));
+
+        std::vector<char> buf;
+        for (size_t i = 0; i < items.size(); ++i)
+        {
+            Entry& e = outEntries[i];
+            const size_t bytes = dataBytes(e.nnz);
+            if (items[i].old)
+            {
+                out.write(data + items[i].old->dataOffset, static_cast<std::streamsize>(bytes));
+                continue;
+            }
+            const SparseVector& f = items[i].fresh->features;
+            buf.assign(bytes, '\0');
+            std::memcpy(buf.data(), f.indices.data(), f.nnz() * sizeof(uint32_t));
+            std::memcpy(buf.data() + bytes - f.nnz() * sizeof(double), f.values.data(), f.nnz() * sizeof(double));
+            e.dataChecksum = modelChecksum(buf.data(), bytes);
+            out.write(buf.data(), static_cast<std::streamsize>(bytes));
+        }
+
+        uint64_t c = modelChecksum(&h, sizeof(h));
+        c = modelChecksum(outEntries.data(), outEntries.size() * sizeof(Entry), c);
+        h.metaChecksum = modelChecksum(pathBlock.data(), pathBlock.size(), c);
+
+        out.seekp(0);
+        out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+        out.write(reinterpret_cast<const char*>(outEntries.data()),
+            static_cast<std::streamsize>(outEntries.size() * sizeof(Entry)));
+        out.write(pathBlock.data(), static_cast<std::streamsize>(pathBlock.size()));
+        out.flush();
+        if (!out)
+        {
+            out.close();
+            std::remove(tmp.c_str());
+            return fail(error, "cannot write '" + tmp + "'");
+        }
+    }
+
+    // drop the mapping before replacing the file (required on Windows)
+    reset();
+#ifdef _WIN32
+    std::remove(path.c_str()); // rename does not replace on Windows
+#endif
+    if (std::rename(tmp.c_str(), path.c_str()) != 0)
+    {
+        std::remove(tmp.c_str());
+        return fail(error, "cannot rename '" + tmp + "' to '" + path + "'");
+    }
+    return open(path, config, error);
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "FeatureConfig.h"
+#include "MappedFile.h"
+#include "SparseVector.h"
+
+// Identity of a file on disk: size + last-write time. A file whose stamp is
+// unchanged is assumed to have unchanged content (an edit that keeps the size
+// and lands within the same mtime tick is not detected).
+struct FileStamp
+{
+    uint64_t size = 0;
+    int64_t mtimeNs = 0;
+
+    bool operator==(const FileStamp& o) const { return size == o.size && mtimeNs == o.mtimeNs; }
+    bool operator!=(const FileStamp& o) const { return !(*this == o); }
+};
+
+// false if the file does not exist or cannot be stat'ed
+bool statFile(const std::string& path, FileStamp& stamp);
+
+// Hash of everything in a FeatureConfig that changes the extracted features
+uint64_t featureConfigHash(const FeatureConfig& config);
+
+// Persistent cache of extracted feature vectors, keyed by path + FileStamp and
+// tied to one FeatureConfig. The file is memory-mapped: opening costs
+// O(header), and a hit copies just that document's non-zeros.
+//
+// File layout (little-endian, see FeatureCache.cpp):
+//   [header][entries sorted by path hash][path bytes][feature data]
+//
+// A cache built with a different FeatureConfig is ignored (treated as empty)
+// and replaced on the next save(). lookup() and insert() may be called from
+// several threads at once; open() and save() may not.
+class FeatureCache
+{
+public:
+    struct Entry;   // on-disk record, defined in FeatureCache.cpp
+
+    FeatureCache() = default;
+    FeatureCache(const FeatureCache&) = delete;
+    FeatureCache& operator=(const FeatureCache&) = delete;
+
+    // Map filename for the given config. A missing file is not an error (the
+    // cache starts empty); a corrupt one is reported and then ignored.
+    bool open(const std::string& filename, const FeatureConfig& config, std::string* error = nullptr);
+
+    // Features for path if the cache has them for the file's current stamp.
+    // stamp receives the file's current stamp either way (valid if statFile
+    // succeeded); pass it to insert() after extracting on a miss so a file
+    // changed mid-extraction is not cached under the new stamp.
+    bool lookup(const std::string& path, SparseVector& out, FileStamp& stamp);
+
+    // Remember features extracted for path at the given stamp.
+    void insert(const std::string& path, const FileStamp& stamp, const SparseVector& features);
+
+    // Write the cache back (temp file + rename). Keeps every stored entry
+    // unless pruneUnused, which drops entries not looked up since open().
+    bool save(std::string* error = nullptr, bool pruneUnused = false);
+
+    size_t size() const;
+    size_t hits() const { return hitCount.load(std::memory_order_relaxed); }
+    size_t misses() const { return missCount.load(std::memory_order_relaxed); }
+
+private:
+    struct Pending
+    {
+        FileStamp stamp;
+        SparseVector features;
+    };
+
+    const Entry* findEntry(const std::string& path) const;
+    bool readEntry(const Entry& e, SparseVector& out) const;
+    void reset();
+
+    std::string path;
+    FeatureConfig config;
+    uint64_t configHash = 0;
+
+    MappedFile file;
+    const Entry* entries = nullptr;
+    size_t entryCount = 0;
+    const char* paths = nullptr;
+    const char* data = nullptr;
+    uint64_t pathsSize = 0;
+    uint64_t dataSize = 0;
+    std::unique_ptr<std::atomic<bool>[]> used;   // per entry: looked up this session
+
+    mutable std::mutex pendingLock;
+    std::unordered_map<std::string, Pending> pending;
+
+    std::atomic<size_t> hitCount{ 0 };
+    std::atomic<size_t> missCount{ 0 };
+};
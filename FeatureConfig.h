@@ -0,0 +1,117 @@
+#pragma once
+#include <cstdint>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Largest supported HashingConfig::bits: 2^30 weights, the most a Perceptron
+// (int input count) can hold
+constexpr unsigned kMaxHashBits = 30;
+
+// Parameters of the hashing-trick extractor (see FeatureHasher.h)
+struct HashingConfig
+{
+    unsigned bits = 18;       // 2^bits buckets
+    uint32_t seed = 0;        // hash seed; must match between training and serving
+    bool signedHash = false;  // add +1/-1 instead of +1 to reduce collision bias
+
+    size_t dimension() const { return static_cast<size_t>(1) << bits; }
+};
+
+// How a document is turned into features. Saved with the model so that
+// serving extracts exactly the way training did.
+enum class FeatureMode { Keywords, Hashing };
+
+// How a keyword is matched against a token: anywhere inside it ("winter"
+// counts as "win"), or only when the whole token equals it.
+enum class KeywordMatch { Substring, ExactToken };
+
+struct FeatureConfig
+{
+    FeatureMode mode = FeatureMode::Keywords;
+    std::vector<std::string> keywords;   // Keywords mode: one feature per keyword
+    KeywordMatch match = KeywordMatch::Substring;
+    HashingConfig hashing;               // Hashing mode
+
+    size_t dimension() const
+    {
+        return mode == FeatureMode::Hashing ? hashing.dimension() : keywords.size();
+    }
+
+    static FeatureConfig forKeywords(std::vector<std::string> kw,
+        KeywordMatch match = KeywordMatch::Substring)
+    {
+        FeatureConfig c;
+        c.mode = FeatureMode::Keywords;
+        c.keywords = std::move(kw);
+        c.match = match;
+        return c;
+    }
+
+    static FeatureConfig forHashing(const HashingConfig& h)
+    {
+        FeatureConfig c;
+        c.mode = FeatureMode::Hashing;
+        c.hashing = h;
+        return c;
+    }
+};
+
+// Optional trailing section of the text model formats:
+//   features hashing <bits> <seed> <signed>
+// or
+//   features keywords <K>            (or keywords-exact for KeywordMatch::ExactToken)
+//   <one keyword per line>
+// Nothing is written for an empty keyword list.
+inline void writeFeatureSection(std::ostream& out, const FeatureConfig& config)
+{
+    if (config.mode == FeatureMode::Hashing)
+    {
+        out << "features hashing " << config.hashing.bits << ' ' << config.hashing.seed
+            << ' ' << (config.hashing.signedHash ? 1 : 0) << '\n';
+    }
+    else if (!config.keywords.empty())
+    {
+        const bool exact = config.match == KeywordMatch::ExactToken;
+        out << (exact ? "features keywords-exact " : "features keywords ") << config.keywords.size() << '\n';
+        for (const auto& k : config.keywords) out << k << '\n';
+    }
+}
+
+// Reads the section if the stream has one (present = true) and leaves config
+// alone otherwise. Returns false if there is something malformed instead.
+inline bool readFeatureSection(std::istream& in, FeatureConfig& config, bool& present)
+{
+    present = false;
+    std::string tag, kind;
+    if (!(in >> tag)) return true; // end of file: no section
+    if (tag != "features" || !(in >> kind)) return false;
+
+    FeatureConfig parsed;
+    if (kind == "hashing")
+    {
+        int sign = 0;
+        parsed = FeatureConfig::forHashing(HashingConfig());
+        in >> parsed.hashing.bits >> parsed.hashing.seed >> sign;
+        if (!in || parsed.hashing.bits == 0 || parsed.hashing.bits > kMaxHashBits) return false;
+        parsed.hashing.signedHash = (sign != 0);
+    }
+    else if (kind == "keywords" || kind == "keywords-exact")
+    {
+        size_t k = 0;
+        if (!(in >> k)) return false;
+        in.ignore((std::numeric_limits<std::streamsize>::max)(), '\n');
+        std::vector<std::string> kw(k);
+        for (auto& word : kw)
+            if (!std::getline(in, word)) return false;
+        parsed = FeatureConfig::forKeywords(std::move(kw),
+            kind == "keywords" ? KeywordMatch::Substring : KeywordMatch::ExactToken);
+    }
+    else return false;
+
+    config = std::move(parsed);
+    present = true;
+    return true;
+}
@@ -4,17 +4,24 @@
 #include <fstream>
 #include <algorithm>
 #include <cctype>
+#include <string_view>
+#include "KeywordMatcher.h"
+#include "MappedFile.h"
+#include "Metrics.h"
+#include "SparseVector.h"
 
 // turn a text file into a feature vector: counts per keyword
+// (the matcher is built once per keyword set and reused across files)
 inline std::vector<double> extractFeatures(const std::string& filename,
-    const std::vector<std::string>& keywords)
+    const KeywordMatcher& matcher)
 {
     std::ifstream file(filename);
-    std::vector<double> features(keywords.size(), 0.0);
+    std::vector<double> features(matcher.size(), 0.0);
 
     if (!file.is_open())   // ✅ safer check
         return features;
 
+    KeywordMatcher::Scratch scratch;
     std::string token;
     while (file >> token)
     {
@@ -26,13 +33,180 @@ inline std::vector<double> extractFeatures(const std::string& filename,
         while (!token.empty() && std::ispunct(static_cast<unsigned char>(token.back())))
             token.pop_back();
 
-        // check against keywords
-        for (size_t i = 0; i < keywords.size(); ++i)
-        {
-            if (!keywords[i].empty() && token.find(keywords[i]) != std::string::npos)
-                features[i] += 1.0;
-        }
+        // check against all keywords in one pass
+        matcher.countToken(token, features.data(), scratch);
     }
 
     return features;
-}
\ No newline at end of file
+}
+
+// convenience overload for one-off calls; builds the matcher every time
+inline std::vector<double> extractFeatures(const std::string& filename,
+    const std::vector<std::string>& keywords)
+{
+    return extractFeatures(filename, KeywordMatcher(keywords));
+}
+
+// whitespace that ends a token for `file >> token` (classic locale)
+inline bool isTokenSpace(unsigned char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+
+// Split text into the same tokens as the stream path, as views into text.
+// Trailing punctuation is already stripped; lowercasing is left to the
+// consumer (see KeywordMatcher's foldCase) so nothing is copied.
+template <class OnToken>
+inline void forEachToken(std::string_view text, OnToken&& onToken)
+{
+    const char* p = text.data();
+    const char* end = p + text.size();
+    while (p < end)
+    {
+        while (p < end && isTokenSpace(static_cast<unsigned char>(*p))) ++p;
+        const char* start = p;
+        while (p < end && !isTokenSpace(static_cast<unsigned char>(*p))) ++p;
+        if (p == start) break;
+
+        const char* last = p;
+        while (last > start && std::ispunct(static_cast<unsigned char>(last[-1])))
+            --last;
+        onToken(std::string_view(start, static_cast<size_t>(last - start)));
+    }
+}
+
+// forEachToken for one whole document, plus the Extract/Tokenize/Match
+// metrics. On sampled documents the tokens are collected first and consumed
+// in a second pass so the two phases get separate timings.
+template <class OnToken>
+inline void forEachDocumentToken(std::string_view text, OnToken&& onToken)
+{
+#ifdef PERCEPTRON_METRICS
+    METRIC_TIME(Extract);
+    METRIC_ADD(Documents, 1);
+    uint64_t tokens = 0;
+    if (metrics::sampled(metrics::Timer::Tokenize))
+    {
+        thread_local std::vector<std::string_view> views;
+        views.clear();
+        auto t0 = std::chrono::steady_clock::now();
+        forEachToken(text, [&](std::string_view token) { views.push_back(token); });
+        metrics::record(metrics::Timer::Tokenize, metrics::ScopedTimer::elapsedNs(t0));
+        t0 = std::chrono::steady_clock::now();
+        for (std::string_view token : views) onToken(token);
+        metrics::record(metrics::Timer::Match, metrics::ScopedTimer::elapsedNs(t0));
+        tokens = views.size();
+    }
+    else
+    {
+        forEachToken(text, [&](std::string_view token) { ++tokens; onToken(token); });
+    }
+    METRIC_ADD(Tokens, tokens);
+#else
+    forEachToken(text, onToken);
+#endif
+}
+
+// keyword counts for an in-memory document; adds into features
+inline void extractFeaturesFromText(std::string_view text, const KeywordMatcher& matcher,
+    std::vector<double>& features)
+{
+    features.resize(matcher.size(), 0.0);
+    KeywordMatcher::Scratch scratch;
+    double* counts = features.data();
+    uint64_t hits = 0;
+    forEachDocumentToken(text, [&](std::string_view token) {
+        matcher.forEachTokenHit(token, scratch, [&](uint32_t k) {
+            counts[k] += 1.0;
+            ++hits;
+        }, /*foldCase=*/true);
+    });
+    METRIC_ADD(KeywordHits, hits);
+}
+
+// Mapped-file extraction that reports failures instead of hiding them:
+// returns false and sets error when the file cannot be opened or read.
+inline bool tryExtractFeatures(const std::string& filename, const KeywordMatcher& matcher,
+    std::vector<double>& features, std::string& error)
+{
+    features.assign(matcher.size(), 0.0);
+
+    MappedFile file;
+    if (!file.open(filename, &error))
+        return false;
+
+    extractFeaturesFromText(file.view(), matcher, features);
+    return true;
+}
+
+// Same result as extractFeatures, but reads the file through MappedFile and
+// tokenizes the bytes in place instead of going through std::ifstream.
+inline std::vector<double> extractFeaturesMapped(const std::string& filename,
+    const KeywordMatcher& matcher)
+{
+    std::vector<double> features;
+    std::string error;
+    tryExtractFeatures(filename, matcher, features, error);
+    return features;
+}
+
+// Reusable per-thread state for sparse extraction. Sized to the keyword count
+// once; each document only touches the entries it hits.
+struct SparseExtractScratch
+{
+    KeywordMatcher::Scratch token;   // per-token dedupe (same rule as countToken)
+    std::vector<double> counts;      // dense accumulator, all zero between documents
+    std::vector<uint32_t> touched;   // keyword indices hit by the current document
+};
+
+// Sparse keyword counts for an in-memory document: only the keywords that occur
+// end up in `out`. Cost depends on the document, not on the keyword count.
+inline void extractSparseFeaturesFromText(std::string_view text, const KeywordMatcher& matcher,
+    SparseVector& out, SparseExtractScratch& scratch)
+{
+    scratch.counts.resize(matcher.size(), 0.0);
+    scratch.touched.clear();
+
+    forEachDocumentToken(text, [&](std::string_view token) {
+        matcher.forEachTokenHit(token, scratch.token, [&](uint32_t k) {
+            if (scratch.counts[k] == 0.0) scratch.touched.push_back(k);
+            scratch.counts[k] += 1.0;
+        }, /*foldCase=*/true);
+    });
+
+    std::sort(scratch.touched.begin(), scratch.touched.end());
+    out.clear();
+    out.dimension = matcher.size();
+    double hits = 0.0;
+    for (uint32_t k : scratch.touched)
+    {
+        out.push(k, scratch.counts[k]);
+        hits += scratch.counts[k];
+        scratch.counts[k] = 0.0;
+    }
+    METRIC_ADD(KeywordHits, hits);
+}
+
+// Sparse counterpart of tryExtractFeatures
+inline bool tryExtractSparseFeatures(const std::string& filename, const KeywordMatcher& matcher,
+    SparseVector& out, SparseExtractScratch& scratch, std::string& error)
+{
+    out.clear();
+    out.dimension = matcher.size();
+
+    MappedFile file;
+    if (!file.open(filename, &error))
+        return false;
+
+    extractSparseFeaturesFromText(file.view(), matcher, out, scratch);
+    return true;
+}
+
+inline SparseVector extractSparseFeatures(const std::string& filename, const KeywordMatcher& matcher)
+{
+    SparseVector out;
+    SparseExtractScratch scratch;
+    std::string error;
+    tryExtractSparseFeatures(filename, matcher, out, scratch, error);
+    return out;
+}
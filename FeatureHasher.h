@@ -0,0 +1,75 @@
+#pragma once
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "FeatureConfig.h"
+#include "FeatureExtractor.h"
+#include "SparseVector.h"
+
+// Hashing-trick extractor: every token is hashed into one of 2^bits buckets,
+// so there is no keyword table and memory stays constant however large the
+// vocabulary gets. Tokens are split, lowercased and stripped exactly like the
+// keyword extractor.
+class FeatureHasher
+{
+public:
+    // reusable per-thread buffer of (bucket, +1/-1) hits
+    struct Scratch
+    {
+        std::vector<std::pair<uint32_t, int>> hits;
+    };
+
+    FeatureHasher() = default;
+    explicit FeatureHasher(const HashingConfig& config) : config(config) {}
+
+    const HashingConfig& getConfig() const { return config; }
+    size_t dimension() const { return config.dimension(); }
+
+    // 64-bit hash of the lowercased token (FNV-1a + final avalanche)
+    uint64_t hashToken(std::string_view token) const
+    {
+        uint64_t h = 1469598103934665603ull ^ (static_cast<uint64_t>(config.seed) * 0x9E3779B97F4A7C15ull);
+        for (unsigned char c : token)
+        {
+            h ^= static_cast<unsigned char>(std::tolower(c));
+            h *= 1099511628211ull;
+        }
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdull;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ull;
+        h ^= h >> 33;
+        return h;
+    }
+
+    // Hashed token counts of an in-memory document (colliding tokens add up).
+    void extract(std::string_view text, SparseVector& out, Scratch& scratch) const
+    {
+        const uint64_t mask = config.dimension() - 1;
+        scratch.hits.clear();
+        forEachDocumentToken(text, [&](std::string_view token) {
+            if (token.empty()) return;
+            const uint64_t h = hashToken(token);
+            const int sign = (config.signedHash && (h >> 63)) ? -1 : 1;
+            scratch.hits.emplace_back(static_cast<uint32_t>(h & mask), sign);
+        });
+
+        std::sort(scratch.hits.begin(), scratch.hits.end());
+        out.clear();
+        out.dimension = config.dimension();
+        for (size_t k = 0; k < scratch.hits.size();)
+        {
+            const uint32_t bucket = scratch.hits[k].first;
+            double v = 0.0;
+            for (; k < scratch.hits.size() && scratch.hits[k].first == bucket; ++k)
+                v += scratch.hits[k].second;
+            if (v != 0.0) out.push(bucket, v);
+        }
+    }
+
+private:
+    HashingConfig config;
+};
@@ -0,0 +1,64 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include "FeatureConfig.h"
+#include "FeatureExtractor.h"
+#include "FeatureHasher.h"
+#include "KeywordMatcher.h"
+#include "MappedFile.h"
+#include "SparseVector.h"
+
+// Turns documents into sparse feature vectors according to a FeatureConfig
+// (keyword counts or hashed tokens). Build it from the model's config so that
+// serving extracts the same features the model was trained on.
+class Featurizer
+{
+public:
+    // reusable per-thread buffers
+    struct Scratch
+    {
+        SparseExtractScratch keywords;
+        FeatureHasher::Scratch hashing;
+    };
+
+    Featurizer() = default;
+    explicit Featurizer(const FeatureConfig& config)
+        : config(config)
+    {
+        if (config.mode == FeatureMode::Hashing)
+            hasher = FeatureHasher(config.hashing);
+        else
+            matcher = KeywordMatcher(config.keywords, config.match);
+    }
+
+    const FeatureConfig& getConfig() const { return config; }
+    size_t dimension() const { return config.dimension(); }
+
+    void extract(std::string_view text, SparseVector& out, Scratch& scratch) const
+    {
+        if (config.mode == FeatureMode::Hashing)
+            hasher.extract(text, out, scratch.hashing);
+        else
+            extractSparseFeaturesFromText(text, matcher, out, scratch.keywords);
+    }
+
+    // false + error if the file cannot be read
+    bool extractFile(const std::string& filename, SparseVector& out, Scratch& scratch,
+        std::string& error) const
+    {
+        out.clear();
+        out.dimension = dimension();
+
+        MappedFile file;
+        if (!file.open(filename, &error))
+            return false;
+
+        extract(file.view(), out, scratch);
+        return true;
+    }
+
+private:
+    FeatureConfig config;
+    KeywordMatcher matcher;
+    FeatureHasher hasher;
+};
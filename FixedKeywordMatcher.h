@@ -0,0 +1,212 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "FeatureConfig.h"
+#include "MappedFile.h"
+#include "PerfectHash.h"
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Keyword counter for a keyword set fixed at compile time (at most 64 words).
+// Same results as KeywordMatcher + extractFeatures (in the default "C"
+// locale): the same tokens, matched case-insensitively, and a keyword counts
+// at most once per token.
+//
+// Every table is built by the constexpr constructor:
+//  - a byte-class table replaces isspace/ispunct in the tokenizer;
+//  - for the first three bytes of every keyword, a 256-entry table maps a
+//    byte to the bitmask of keywords that have it at that position, so one AND
+//    of three lookups leaves only the keywords that can start at a position;
+//  - the per-token dedupe is a bitmask, so nothing is allocated.
+//
+// With Match = KeywordMatch::ExactToken the constructor builds a perfect hash
+// of the keywords instead (StaticExactKeywordTable) and a token costs one hash
+// and one compare.
+template <size_t N, KeywordMatch Match = KeywordMatch::Substring>
+class FixedKeywordMatcher
+{
+    static_assert(N > 0 && N <= 64, "FixedKeywordMatcher handles 1 to 64 keywords");
+
+public:
+    using Counts = std::array<double, N>;
+
+    constexpr explicit FixedKeywordMatcher(const std::array<std::string_view, N>& keywords)
+        : words(keywords)
+    {
+        for (unsigned c = 0; c < 256; ++c)
+        {
+            const bool space = c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+            const bool punct = (c >= 33 && c <= 47) || (c >= 58 && c <= 64) || (c >= 91 && c <= 96) || (c >= 123 && c <= 126);
+            classes[c] = space ? kSpace : (punct ? kPunct : 0);
+        }
+
+        if constexpr (Match == KeywordMatch::ExactToken)
+        {
+            exact = StaticExactKeywordTable<N>(keywords);
+            return;
+        }
+
+        for (size_t k = 0; k < N; ++k)
+        {
+            const std::string_view w = words[k];
+            if (w.empty() || hasUpper(w)) continue; // never match lowercased text
+            const uint64_t bit = uint64_t(1) << k;
+            if (w.size() < minLength) minLength = w.size();
+            for (size_t j = 0; j < kFilterBytes; ++j)
+            {
+                if (j >= w.size())
+                {
+                    // past the keyword's end any byte (or the token's end) passes
+                    for (auto& m : filter[j]) m |= bit;
+                    continue;
+                }
+                const unsigned char c = static_cast<unsigned char>(w[j]);
+                filter[j][c] |= bit;
+                if (c >= 'a' && c <= 'z') filter[j][c - 'a' + 'A'] |= bit;
+            }
+        }
+    }
+
+    static constexpr size_t size() { return N; }
+    constexpr std::string_view keyword(size_t k) const { return words[k]; }
+
+    // true if keywords is this exact list (e.g. a loaded model's FeatureConfig)
+    bool sameKeywords(const std::vector<std::string>& keywords) const
+    {
+        if (keywords.size() != N) return false;
+        for (size_t k = 0; k < N; ++k)
+            if (keywords[k] != words[k]) return false;
+        return true;
+    }
+
+    // true if config extracts exactly like this matcher (same keywords and match mode)
+    bool sameFeatures(const FeatureConfig& config) const
+    {
+        return config.mode == FeatureMode::Keywords && config.match == Match && sameKeywords(config.keywords);
+    }
+
+    // the keyword list as a runtime FeatureConfig, to save with a model
+    FeatureConfig featureConfig() const
+    {
+        return FeatureConfig::forKeywords(std::vector<std::string>(words.begin(), words.end()), Match);
+    }
+
+    // keyword counts of an in-memory document (counts is overwritten)
+    void extract(std::string_view text, Counts& counts) const
+    {
+        counts.fill(0.0);
+        const char* p = text.data();
+        const char* end = p + text.size();
+        while (p < end)
+        {
+            while (p < end && classOf(*p) == kSpace) ++p;
+            const char* start = p;
+            while (p < end && classOf(*p) != kSpace) ++p;
+
+            const char* last = p;
+            while (last > start && classOf(last[-1]) == kPunct) --last;
+            countToken(std::string_view(start, static_cast<size_t>(last - start)), counts);
+        }
+    }
+
+    // false + error if the file cannot be read
+    bool extractFile(const std::string& filename, Counts& counts, std::string& error) const
+    {
+        MappedFile file;
+        if (!file.open(filename, &error))
+        {
+            counts.fill(0.0);
+            return false;
+        }
+        extract(file.view(), counts);
+        return true;
+    }
+
+    // adds 1 to counts[k] for every keyword k found in token (already split
+    // and stripped of trailing punctuation)
+    void countToken(std::string_view token, Counts& counts) const
+    {
+        if constexpr (Match == KeywordMatch::ExactToken)
+        {
+            for (uint64_t hits = exact.lookup(token); hits; hits &= hits - 1)
+                counts[lowestBit(hits)] += 1.0;
+            return;
+        }
+
+        const size_t n = token.size();
+        if (n < minLength) return;
+        const unsigned char* t = reinterpret_cast<const unsigned char*>(token.data());
+        auto at = [&](size_t i) { return i < n ? t[i] : 0; };
+
+        // no keyword can start in the last minLength - 1 bytes; when every
+        // keyword has at least kFilterBytes bytes the lookups stay in bounds
+        uint64_t hits = 0;
+        const size_t starts = n - minLength + 1;
+        for (size_t i = 0; i < starts; ++i)
+        {
+            uint64_t candidates = minLength >= kFilterBytes
+                ? filter[0][t[i]] & filter[1][t[i + 1]] & filter[2][t[i + 2]]
+                : filter[0][t[i]] & filter[1][at(i + 1)] & filter[2][at(i + 2)];
+            candidates &= ~hits;
+            while (candidates)
+            {
+                const unsigned k = lowestBit(candidates);
+                candidates &= candidates - 1;
+                if (matchesAt(token, i, words[k])) hits |= uint64_t(1) << k;
+            }
+        }
+        while (hits)
+        {
+            counts[lowestBit(hits)] += 1.0;
+            hits &= hits - 1;
+        }
+    }
+
+private:
+    static constexpr size_t kFilterBytes = 3;
+    static constexpr uint8_t kSpace = 1;
+    static constexpr uint8_t kPunct = 2;
+
+    uint8_t classOf(char c) const { return classes[static_cast<unsigned char>(c)]; }
+
+    static unsigned lowestBit(uint64_t v)
+    {
+#if defined(_MSC_VER) && !defined(__clang__)
+        unsigned long i;
+        _BitScanForward64(&i, v);
+        return static_cast<unsigned>(i);
+#else
+        return static_cast<unsigned>(__builtin_ctzll(v));
+#endif
+    }
+
+    static constexpr bool hasUpper(std::string_view word)
+    {
+        for (char c : word)
+            if (c >= 'A' && c <= 'Z') return true;
+        return false;
+    }
+
+    static bool matchesAt(std::string_view token, size_t pos, std::string_view word)
+    {
+        if (word.size() > token.size() - pos) return false;
+        for (size_t j = kFilterBytes; j < word.size(); ++j)
+        {
+            unsigned char c = static_cast<unsigned char>(token[pos + j]);
+            if (c >= 'A' && c <= 'Z') c = static_cast<unsigned char>(c - 'A' + 'a');
+            if (c != static_cast<unsigned char>(word[j])) return false;
+        }
+        return true;
+    }
+
+    std::array<std::string_view, N> words;
+    std::array<uint8_t, 256> classes{};                              // kSpace / kPunct / 0
+    std::array<std::array<uint64_t, 256>, kFilterBytes> filter{};   // position -> byte -> keywords
+    size_t minLength = static_cast<size_t>(-1);                      // shortest matchable keyword
+    StaticExactKeywordTable<N> exact;                                // ExactToken only
+};
@@ -0,0 +1,101 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdlib>
+#include <ctime>
+#include <string>
+#include <vector>
+#include "FeatureConfig.h"
+#include "Perceptron.h"
+
+// Perceptron with the input count fixed at compile time, for small keyword
+// models on the low-latency path. Weights live in a std::array inside the
+// object (no heap, no size checks), so score/train compile to straight-line
+// code for the exact N. Pair it with FixedKeywordMatcher<N> for extraction.
+//
+// Same update rule and same model files as Perceptron: anything one saves,
+// the other loads (text, binary or int8, as long as it has exactly N inputs).
+template <size_t N>
+class FixedPerceptron
+{
+public:
+    using Inputs = std::array<double, N>;
+
+    // same initialization as Perceptron: weights and bias uniform in [-0.5, 0.5]
+    explicit FixedPerceptron(double lr = 0.1)
+        : learningRate(lr)
+    {
+        std::srand(static_cast<unsigned>(std::time(nullptr)));
+        bias = (static_cast<double>(std::rand()) / RAND_MAX) - 0.5;
+        for (auto& w : weights) w = (static_cast<double>(std::rand()) / RAND_MAX) - 0.5;
+    }
+
+    static constexpr size_t inputSize() { return N; }
+
+    int activate(double sum) const { return (sum >= 0.0) ? 1 : 0; }
+
+    double score(const Inputs& inputs) const
+    {
+        // four independent partial sums, so the fixed-length loop becomes
+        // SIMD multiply-adds without reassociating a single sum
+        std::array<double, 4> acc{};
+        size_t i = 0;
+        for (; i + 4 <= N; i += 4)
+            for (size_t j = 0; j < 4; ++j) acc[j] += weights[i + j] * inputs[i + j];
+        for (; i < N; ++i) acc[0] += weights[i] * inputs[i];
+        return ((acc[0] + acc[1]) + (acc[2] + acc[3])) + bias;
+    }
+
+    int predict(const Inputs& inputs) const { return activate(score(inputs)); }
+
+    void train(const Inputs& inputs, int expectedOutput)
+    {
+        const double grad = score(inputs) - expectedOutput;
+        const double step = -learningRate * grad;
+        for (size_t i = 0; i < N; ++i) weights[i] += step * inputs[i];
+        bias += step;
+    }
+
+    const std::array<double, N>& getWeights() const { return weights; }
+    double getBias() const { return bias; }
+    double getLearningRate() const { return learningRate; }
+
+    const FeatureConfig& getFeatureConfig() const { return features; }
+    void setFeatureConfig(const FeatureConfig& config) { features = config; }
+
+    // Conversion to and from the dynamic model; assign fails (and leaves this
+    // model unchanged) unless model.inputSize() == N.
+    Perceptron toPerceptron() const
+    {
+        Perceptron p(static_cast<int>(N), learningRate);
+        p.setParameters(std::vector<double>(weights.begin(), weights.end()), bias);
+        p.setFeatureConfig(features);
+        return p;
+    }
+
+    bool assign(const Perceptron& model)
+    {
+        if (model.inputSize() != N) return false;
+        const std::vector<double> w = model.getWeights();
+        for (size_t i = 0; i < N; ++i) weights[i] = w[i];
+        bias = model.getBias();
+        learningRate = model.getLearningRate();
+        features = model.getFeatureConfig();
+        return true;
+    }
+
+    bool saveModel(const std::string& filename) const { return toPerceptron().saveModel(filename); }
+    bool saveModelBinary(const std::string& filename) const { return toPerceptron().saveModelBinary(filename); }
+
+    bool loadModel(const std::string& filename)
+    {
+        Perceptron p(0);
+        return p.loadModel(filename) && assign(p);
+    }
+
+private:
+    std::array<double, N> weights;
+    double learningRate;
+    double bias;
+    FeatureConfig features;
+};
@@ -0,0 +1,122 @@
+#include "HogwildTrainer.h"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <numeric>
+#include <random>
+
+namespace
+{
+    // publish buffered bias updates after this many samples
+    constexpr size_t kBiasFlush = 64;
+
+    // keep per-shard results on separate cache lines
+    struct alignas(64) ShardResult
+    {
+        double loss = 0.0;
+    };
+
+    void atomicAdd(std::atomic<double>& target, double delta)
+    {
+        double cur = target.load(std::memory_order_relaxed);
+        while (!target.compare_exchange_weak(cur, cur + delta, std::memory_order_relaxed)) {}
+    }
+
+    // T is the weight storage type (double or float, following the model)
+    template <class T>
+    double runHogwild(Perceptron& model, const SparseDataset& data,
+        const HogwildOptions& options, ThreadPool* pool)
+    {
+        const size_t dim = model.inputSize();
+        const double lr = model.getLearningRate();
+
+        const std::vector<double> init = model.getWeights();
+        std::unique_ptr<std::atomic<T>[]> w(new std::atomic<T>[dim]);
+        for (size_t j = 0; j < dim; ++j) w[j].store(static_cast<T>(init[j]), std::memory_order_relaxed);
+        std::atomic<double> bias{ model.getBias() };
+
+        std::unique_ptr<ThreadPool> ownPool;
+        unsigned threads = options.threads;
+        if (threads != 1 && !pool)
+        {
+            ownPool.reset(new ThreadPool(threads));
+            pool = ownPool.get();
+        }
+        if (threads == 0 || (pool && threads > pool->size())) threads = pool->size();
+        const size_t biasFlush = (threads == 1) ? 1 : kBiasFlush;
+
+        std::vector<size_t> order(data.rows());
+        std::iota(order.begin(), order.end(), static_cast<size_t>(0));
+        std::mt19937 rng(options.seed);
+        std::vector<ShardResult> shards(threads);
+
+        auto runShard = [&](size_t shard) {
+            const size_t begin = order.size() * shard / threads;
+            const size_t end = order.size() * (shard + 1) / threads;
+            double loss = 0.0;
+            double biasDelta = 0.0;
+            size_t sinceFlush = 0;
+            for (size_t s = begin; s < end; ++s)
+            {
+                const size_t r = order[s];
+                const uint32_t* idx = data.rowIndices(r);
+                const double* val = data.rowValues(r);
+                const size_t n = data.rowNnz(r);
+
+                double yHat = 0.0;
+                for (size_t k = 0; k < n; ++k)
+                    yHat += w[idx[k]].load(std::memory_order_relaxed) * val[k];
+                yHat += bias.load(std::memory_order_relaxed) + biasDelta;
+
+                const double grad = yHat - data.label(r);
+                loss += 0.5 * grad * grad;
+
+                // racy read-modify-write by design: a concurrent update to the
+                // same weight can be lost, never torn
+                const double step = -lr * grad;
+                for (size_t k = 0; k < n; ++k)
+                {
+                    std::atomic<T>& wk = w[idx[k]];
+                    wk.store(static_cast<T>(wk.load(std::memory_order_relaxed) + static_cast<T>(step * val[k])),
+                        std::memory_order_relaxed);
+                }
+
+                biasDelta -= lr * grad;
+                if (++sinceFlush == biasFlush)
+                {
+                    atomicAdd(bias, biasDelta);
+                    biasDelta = 0.0;
+                    sinceFlush = 0;
+                }
+            }
+            if (sinceFlush) atomicAdd(bias, biasDelta);
+            shards[shard].loss = loss;
+        };
+
+        double epochLoss = 0.0;
+        for (int e = 0; e < options.epochs; ++e)
+        {
+            if (options.shuffle) std::shuffle(order.begin(), order.end(), rng);
+            if (threads == 1)
+                runShard(0);
+            else
+                pool->parallelFor(threads, runShard);
+
+            epochLoss = 0.0;
+            for (const auto& s : shards) epochLoss += s.loss;
+        }
+
+        std::vector<double> out(dim);
+        for (size_t j = 0; j < dim; ++j) out[j] = w[j].load(std::memory_order_relaxed);
+        model.setParameters(out, bias.load(std::memory_order_relaxed));
+        return order.empty() ? 0.0 : epochLoss / static_cast<double>(order.size());
+    }
+}
+
+double trainHogwild(Perceptron& model, const SparseDataset& data,
+    const HogwildOptions& options, ThreadPool* pool)
+{
+    if (model.getPrecision() == WeightPrecision::Float)
+        return runHogwild<float>(model, data, options, pool);
+    return runHogwild<double>(model, data, options, pool);
+}
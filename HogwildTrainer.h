@@ -0,0 +1,34 @@
+#pragma once
+#include "Dataset.h"
+#include "Perceptron.h"
+#include "ThreadPool.h"
+
+// Options for trainHogwild
+struct HogwildOptions
+{
+    int epochs = 10;
+    unsigned threads = 0;     // 0 = every worker of the pool; 1 = deterministic serial run
+    bool shuffle = true;      // reshuffle sample order every epoch
+    unsigned seed = 0;        // shuffle seed
+};
+
+// Lock-free parallel SGD (Hogwild): every epoch the shuffled samples are cut
+// into one shard per thread, and all threads update one shared weight vector
+// with no locks.
+//
+// Guarantees in parallel mode:
+//  - weights are atomics accessed with relaxed loads/stores, so there are no
+//    data races in the C++ sense and no torn values;
+//  - two threads updating the same weight at the same time may lose one of the
+//    updates, and a thread may score with slightly stale weights. For sparse
+//    documents collisions are rare and SGD tolerates them (Niu et al. 2011);
+//  - the bias is touched by every sample, so each thread buffers its bias
+//    updates and publishes them every few samples.
+// Results therefore vary slightly from run to run. With threads == 1 the run
+// is fully deterministic and matches calling Perceptron::train on the same
+// sample order.
+//
+// Returns the mean loss 0.5*(score-y)^2 of the last epoch, measured before
+// each update. The model's weights and bias are replaced on return.
+double trainHogwild(Perceptron& model, const SparseDataset& data,
+    const HogwildOptions& options = HogwildOptions(), ThreadPool* pool = nullptr);
@@ -0,0 +1,187 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <array>
+#include <cstdint>
+#include <cctype>
+#include "FeatureConfig.h"
+#include "PerfectHash.h"
+
+// Aho-Corasick automaton over a keyword list.
+// Finds every keyword that occurs as a substring of a text in one pass, so the
+// cost per token no longer grows with the number of keywords.
+// Build it once per keyword set and share it (read-only) across files/threads.
+//
+// With KeywordMatch::ExactToken a keyword only matches a token equal to it;
+// the automaton is not built and each token is looked up in a minimal perfect
+// hash of the keywords instead (ExactKeywordTable).
+class KeywordMatcher
+{
+public:
+    // per-caller scratch used to count each keyword at most once per token
+    struct Scratch
+    {
+        std::vector<uint32_t> lastToken; // token stamp of the last hit, per keyword
+        uint32_t token = 0;
+    };
+
+    KeywordMatcher() = default;
+    explicit KeywordMatcher(const std::vector<std::string>& keywords,
+        KeywordMatch match = KeywordMatch::Substring);
+
+    // number of keywords (= feature vector size), including empty ones
+    size_t size() const { return numKeywords; }
+    KeywordMatch matchMode() const { return match; }
+
+    // Calls onMatch(keywordIndex) for every occurrence of every keyword in text.
+    // Empty keywords never match. Substring mode only (finds nothing in
+    // ExactToken mode). With foldCase the text is matched as if it had
+    // been lowercased with std::tolower first, without touching the bytes.
+    template <class OnMatch>
+    void forEachMatch(std::string_view text, OnMatch&& onMatch, bool foldCase = false) const
+    {
+        const uint32_t* classes = foldCase ? foldedClass.data() : byteClass.data();
+        uint32_t state = 0;
+        for (unsigned char c : text)
+        {
+            state = next[state * numClasses + classes[c]];
+            for (uint32_t s = state; s != kNone; s = outLink[s])
+            {
+                for (uint32_t k = outStart[s]; k < outStart[s + 1]; ++k)
+                    onMatch(outputs[k]);
+            }
+        }
+    }
+
+    // Calls onHit(keywordIndex) once for every distinct keyword found in token,
+    // however often it occurs inside it (ExactToken: every keyword equal to it).
+    template <class OnHit>
+    void forEachTokenHit(std::string_view token, Scratch& scratch, OnHit&& onHit,
+        bool foldCase = false) const
+    {
+        if (match == KeywordMatch::ExactToken)
+        {
+            exact.forEachHit(token, onHit, foldCase);
+            return;
+        }
+        if (scratch.lastToken.size() != numKeywords || ++scratch.token == 0)
+        {
+            scratch.lastToken.assign(numKeywords, 0);
+            scratch.token = 1;
+        }
+        const uint32_t stamp = scratch.token;
+        forEachMatch(token, [&](uint32_t k) {
+            if (scratch.lastToken[k] != stamp)
+            {
+                scratch.lastToken[k] = stamp;
+                onHit(k);
+            }
+        }, foldCase);
+    }
+
+    // Adds 1.0 to counts[i] for every keyword i found in token.
+    // Same semantics as `token.find(keywords[i]) != npos` (ExactToken:
+    // `token == keywords[i]`): a keyword counts at most once per token,
+    // however often it occurs inside it.
+    void countToken(std::string_view token, double* counts, Scratch& scratch,
+        bool foldCase = false) const
+    {
+        forEachTokenHit(token, scratch, [counts](uint32_t k) { counts[k] += 1.0; }, foldCase);
+    }
+
+private:
+    static constexpr uint32_t kNone = 0xFFFFFFFFu;
+
+    size_t numKeywords = 0;
+    KeywordMatch match = KeywordMatch::Substring;
+    ExactKeywordTable exact;                 // ExactToken mode only
+    uint32_t numClasses = 1;                 // class 0 = bytes used by no keyword
+    std::array<uint32_t, 256> byteClass{};   // byte -> alphabet class
+    std::array<uint32_t, 256> foldedClass{}; // byte -> class of std::tolower(byte)
+    std::vector<uint32_t> next{ 0 };         // full DFA: state * numClasses + class
+    std::vector<uint32_t> outLink{ kNone };  // nearest suffix state with outputs
+    std::vector<uint32_t> outStart{ 0, 0 };  // outputs[outStart[s] .. outStart[s+1])
+    std::vector<uint32_t> outputs;           // keyword indices ending at each state
+};
+
+inline KeywordMatcher::KeywordMatcher(const std::vector<std::string>& keywords, KeywordMatch match)
+    : numKeywords(keywords.size()), match(match)
+{
+    if (match == KeywordMatch::ExactToken)
+    {
+        exact = ExactKeywordTable(keywords);
+        return;
+    }
+
+    // compress the alphabet to the bytes that actually appear in keywords
+    byteClass.fill(0);
+    for (const auto& kw : keywords)
+        for (unsigned char c : kw)
+            if (byteClass[c] == 0) byteClass[c] = numClasses++;
+    for (int c = 0; c < 256; ++c)
+        foldedClass[c] = byteClass[static_cast<unsigned char>(std::tolower(c))];
+
+    // 1) trie
+    std::vector<std::vector<uint32_t>> own(1);
+    next.assign(numClasses, kNone);
+    for (size_t i = 0; i < keywords.size(); ++i)
+    {
+        if (keywords[i].empty()) continue;
+        uint32_t s = 0;
+        for (unsigned char c : keywords[i])
+        {
+            uint32_t& t = next[s * numClasses + byteClass[c]];
+            if (t == kNone)
+            {
+                t = static_cast<uint32_t>(own.size());
+                own.emplace_back();
+                next.resize(next.size() + numClasses, kNone);
+            }
+            s = next[s * numClasses + byteClass[c]]; // re-read: resize may move `t`
+        }
+        own[s].push_back(static_cast<uint32_t>(i));
+    }
+    const size_t numStates = own.size();
+
+    // 2) failure links (BFS), turning the trie into a full DFA
+    std::vector<uint32_t> fail(numStates, 0);
+    outLink.assign(numStates, kNone);
+    std::vector<uint32_t> queue;
+    queue.reserve(numStates);
+    for (uint32_t c = 0; c < numClasses; ++c)
+    {
+        uint32_t& t = next[c];
+        if (t == kNone) t = 0;
+        else queue.push_back(t);
+    }
+    for (size_t head = 0; head < queue.size(); ++head)
+    {
+        const uint32_t s = queue[head];
+        const uint32_t f = fail[s];
+        outLink[s] = !own[f].empty() ? f : outLink[f];
+        for (uint32_t c = 0; c < numClasses; ++c)
+        {
+            uint32_t& t = next[s * numClasses + c];
+            if (t == kNone)
+            {
+                t = next[f * numClasses + c];
+            }
+            else
+            {
+                fail[t] = next[f * numClasses + c];
+                queue.push_back(t);
+            }
+        }
+    }
+
+    // 3) flatten per-state outputs
+    outStart.assign(numStates + 1, 0);
+    outputs.clear();
+    for (size_t s = 0; s < numStates; ++s)
+    {
+        outStart[s] = static_cast<uint32_t>(outputs.size());
+        outputs.insert(outputs.end(), own[s].begin(), own[s].end());
+    }
+    outStart[numStates] = static_cast<uint32_t>(outputs.size());
+}
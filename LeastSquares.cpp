@@ -0,0 +1,300 @@
+#include "LeastSquares.h"
+#include "VectorKernels.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    bool fail(std::string* error, const std::string& message)
+    {
+        if (error) *error = message;
+        return false;
+    }
+
+    bool checkDimension(size_t d, std::string* error)
+    {
+        if (d <= kMaxLeastSquaresDimension) return true;
+        return fail(error, "least squares needs a (d+1)^2 matrix; " + std::to_string(d)
+            + " inputs is more than the supported " + std::to_string(kMaxLeastSquaresDimension));
+    }
+
+    // Regularized system as a full symmetric n x n matrix (n = d+1)
+    std::vector<double> normalMatrix(const GramAccumulator& sums, double ridge)
+    {
+        const size_t d = sums.dimension(), n = d + 1;
+        std::vector<double> a(n * n);
+        for (size_t i = 0; i < n; ++i)
+            for (size_t j = i; j < n; ++j)
+                a[i * n + j] = a[j * n + i] = sums.gram(i, j);
+        for (size_t i = 0; i < d; ++i) a[i * n + i] += ridge;   // not the bias
+        return a;
+    }
+
+    // In-place Cholesky A = L L' (row-major, lower triangle); false if A is
+    // not positive definite
+    bool cholesky(std::vector<double>& a, size_t n)
+    {
+        for (size_t j = 0; j < n; ++j)
+        {
+            double* lj = &a[j * n];
+            const double s = lj[j] - kernels::dot(lj, lj, j);
+            if (!(s > 0.0) || !std::isfinite(s)) return false;
+            lj[j] = std::sqrt(s);
+            for (size_t i = j + 1; i < n; ++i)
+            {
+                double* li = &a[i * n];
+                li[j] = (li[j] - kernels::dot(li, lj, j)) / lj[j];
+            }
+        }
+        return true;
+    }
+
+    // solve L L' x = b in place
+    void choleskySolve(const std::vector<double>& l, size_t n, double* b)
+    {
+        for (size_t i = 0; i < n; ++i)
+            b[i] = (b[i] - kernels::dot(&l[i * n], b, i)) / l[i * n + i];
+        for (size_t i = n; i-- > 0;)
+        {
+            double s = b[i];
+            for (size_t k = i + 1; k < n; ++k) s -= l[k * n + i] * b[k];
+            b[i] = s / l[i * n + i];
+        }
+    }
+
+    const char* const kNotPositiveDefinite =
+        "least-squares system is not positive definite (collinear inputs); use a ridge > 0";
+
+    // Shards for the accumulation pass: gramShardCount, at most one per row
+    size_t shardCount(size_t d, size_t rows, const LeastSquaresOptions& options, ThreadPool* pool)
+    {
+        const size_t shards = gramShardCount(d, pool ? (options.threads ? options.threads : pool->size()) : 1);
+        return (std::max)(static_cast<size_t>(1), (std::min)(shards, rows));
+    }
+
+    template <class Data, class AddRow>
+    bool fitRows(Perceptron& model, const Data& data, const LeastSquaresOptions& options, ThreadPool* pool,
+        std::string* error, double* loss, AddRow addRow)
+    {
+        const size_t d = model.inputSize();
+        if (!checkDimension(d, error)) return false;
+        if (data.cols() != d)
+            return fail(error, "dataset has " + std::to_string(data.cols()) + " features, model expects "
+                + std::to_string(d));
+        if (data.empty()) return fail(error, "no samples");
+
+        const size_t shards = shardCount(d, data.rows(), options, pool);
+        std::vector<GramAccumulator> sums(shards, GramAccumulator(d));
+        auto pass = [&](size_t s) {
+            const size_t begin = data.rows() * s / shards, end = data.rows() * (s + 1) / shards;
+            for (size_t r = begin; r < end; ++r) addRow(sums[s], r);
+        };
+        if (pool && shards > 1) pool->parallelFor(shards, pass);
+        else for (size_t s = 0; s < shards; ++s) pass(s);
+        for (size_t s = 1; s < shards; ++s) sums[0].merge(sums[s]);
+
+        std::vector<double> w;
+        double b = 0.0;
+        if (!solveLeastSquares(sums[0], options.ridge, w, b, error, loss)) return false;
+        model.setParameters(w, b);
+        return true;
+    }
+}
+
+size_t gramShardCount(size_t dimension, size_t workers)
+{
+    const size_t bytes = (dimension + 1) * (dimension + 1) * sizeof(double);
+    const size_t cap = (std::max)(static_cast<size_t>(1), (size_t(256) << 20) / bytes);
+    return (std::max)(static_cast<size_t>(1), (std::min)(workers, cap));
+}
+
+GramAccumulator::GramAccumulator(size_t dimension)
+    : dim(dimension), g((dimension + 1) * (dimension + 1), 0.0), xy(dimension + 1, 0.0)
+{
+}
+
+void GramAccumulator::add(const double* x, double y)
+{
+    const size_t n = dim + 1;
+    for (size_t i = 0; i < dim; ++i)
+    {
+        if (x[i] == 0.0) continue;
+        // row i of the upper triangle += x_i * x[i..d)
+        kernels::axpy(x[i], x + i, &g[i * n + i], dim - i);
+        g[i * n + dim] += x[i];
+        xy[i] += x[i] * y;
+    }
+    g[dim * n + dim] += 1.0;
+    xy[dim] += y;
+    yy += y * y;
+    ++count;
+}
+
+void GramAccumulator::add(const SparseVector& x, double y)
+{
+    const size_t n = dim + 1;
+    const size_t nnz = x.nnz();
+    for (size_t a = 0; a < nnz; ++a)
+    {
+        const size_t i = x.indices[a];
+        const double vi = x.values[a];
+        for (size_t b = a; b < nnz; ++b)
+        {
+            const size_t j = x.indices[b];
+            g[(std::min)(i, j) * n + (std::max)(i, j)] += vi * x.values[b];
+        }
+        g[i * n + dim] += vi;
+        xy[i] += vi * y;
+    }
+    g[dim * n + dim] += 1.0;
+    xy[dim] += y;
+    yy += y * y;
+    ++count;
+}
+
+void GramAccumulator::merge(const GramAccumulator& other)
+{
+    for (size_t k = 0; k < g.size(); ++k) g[k] += other.g[k];
+    for (size_t k = 0; k < xy.size(); ++k) xy[k] += other.xy[k];
+    yy += other.yy;
+    count += other.count;
+}
+
+bool solveLeastSquares(const GramAccumulator& sums, double ridge, std::vector<double>& weights, double& bias,
+    std::string* error, double* loss)
+{
+    const size_t d = sums.dimension(), n = d + 1;
+    if (!checkDimension(d, error)) return false;
+    if (sums.samples() == 0) return fail(error, "no samples");
+
+    std::vector<double> l = normalMatrix(sums, ridge);
+    if (!cholesky(l, n)) return fail(error, kNotPositiveDefinite);
+
+    std::vector<double> theta(n);
+    for (size_t i = 0; i < n; ++i) theta[i] = sums.xty(i);
+    choleskySolve(l, n, theta.data());
+
+    if (loss)
+    {
+        // 0.5 * (t'Gt - 2 t'X'y + y'y) / N, from the sums alone
+        double quad = 0.0, lin = 0.0;
+        for (size_t i = 0; i < n; ++i)
+        {
+            double row = sums.gram(i, i) * theta[i];
+            for (size_t j = i + 1; j < n; ++j) row += 2.0 * sums.gram(i, j) * theta[j];
+            quad += theta[i] * row;
+            lin += theta[i] * sums.xty(i);
+        }
+        *loss = (std::max)(0.0, 0.5 * (quad - 2.0 * lin + sums.yty())) / static_cast<double>(sums.samples());
+    }
+
+    bias = theta[d];
+    theta.pop_back();
+    weights = std::move(theta);
+    return true;
+}
+
+bool fitLeastSquares(Perceptron& model, const Dataset& data, const LeastSquaresOptions& options,
+    ThreadPool* pool, std::string* error, double* loss)
+{
+    return fitRows(model, data, options, pool, error, loss,
+        [&](GramAccumulator& sums, size_t r) { sums.add(data.row(r), data.label(r)); });
+}
+
+bool fitLeastSquares(Perceptron& model, const SparseDataset& data, const LeastSquaresOptions& options,
+    ThreadPool* pool, std::string* error, double* loss)
+{
+    return fitRows(model, data, options, pool, error, loss, [&](GramAccumulator& sums, size_t r) {
+        thread_local SparseVector x;
+        x.dimension = data.cols();
+        x.indices.assign(data.rowIndices(r), data.rowIndices(r) + data.rowNnz(r));
+        x.values.assign(data.rowValues(r), data.rowValues(r) + data.rowNnz(r));
+        sums.add(x, data.label(r));
+    });
+}
+
+RecursiveLeastSquares::RecursiveLeastSquares(size_t dimension, double ridge, double forgetting)
+    : dim(dimension), forgetting(forgetting > 0.0 && forgetting <= 1.0 ? forgetting : 1.0),
+      ridge(ridge > 0.0 ? ridge : 1e-3), p((dimension + 1) * (dimension + 1), 0.0), w(dimension + 1, 0.0),
+      px(dimension + 1)
+{
+    // no data yet: P = (ridge I)^-1; the bias gets the same prior until start()
+    for (size_t i = 0; i <= dim; ++i) p[i * (dim + 1) + i] = 1.0 / this->ridge;
+}
+
+bool RecursiveLeastSquares::start(const GramAccumulator& sums, std::string* error)
+{
+    const size_t n = dim + 1;
+    if (sums.dimension() != dim)
+        return fail(error, "sums have dimension " + std::to_string(sums.dimension()) + ", expected "
+            + std::to_string(dim));
+    if (sums.samples() == 0) return true;
+
+    std::vector<double> l = normalMatrix(sums, ridge);
+    if (!cholesky(l, n)) return fail(error, kNotPositiveDefinite);
+
+    // P = A^-1 column by column, then the weights
+    std::vector<double> col(n);
+    for (size_t j = 0; j < n; ++j)
+    {
+        std::fill(col.begin(), col.end(), 0.0);
+        col[j] = 1.0;
+        choleskySolve(l, n, col.data());
+        for (size_t i = 0; i < n; ++i) p[i * n + j] = col[i];
+    }
+    for (size_t i = 0; i < n; ++i) w[i] = sums.xty(i);
+    choleskySolve(l, n, w.data());
+    return true;
+}
+
+void RecursiveLeastSquares::update(const SparseVector& x, double y)
+{
+    const size_t n = dim + 1;
+    // px = P [x 1] (P is symmetric, so rows stand in for columns)
+    std::copy(&p[dim * n], &p[dim * n] + n, px.begin());
+    double prediction = w[dim];
+    for (size_t k = 0; k < x.nnz(); ++k)
+    {
+        kernels::axpy(x.values[k], &p[x.indices[k] * n], px.data(), n);
+        prediction += w[x.indices[k]] * x.values[k];
+    }
+    double xpx = px[dim];
+    for (size_t k = 0; k < x.nnz(); ++k) xpx += x.values[k] * px[x.indices[k]];
+    updateWith(px, xpx, y - prediction);
+}
+
+void RecursiveLeastSquares::update(const std::vector<double>& x, double y)
+{
+    const size_t n = dim + 1;
+    const size_t m = (std::min)(x.size(), dim);
+    std::copy(&p[dim * n], &p[dim * n] + n, px.begin());
+    double prediction = w[dim];
+    for (size_t i = 0; i < m; ++i)
+    {
+        if (x[i] == 0.0) continue;
+        kernels::axpy(x[i], &p[i * n], px.data(), n);
+        prediction += w[i] * x[i];
+    }
+    const double xpx = kernels::dot(x.data(), px.data(), m) + px[dim];
+    updateWith(px, xpx, y - prediction);
+}
+
+void RecursiveLeastSquares::updateWith(const std::vector<double>& pxv, double xpx, double error)
+{
+    // gain k = Px / (f + x'Px); w += k e; P = (P - k (Px)') / f
+    const size_t n = dim + 1;
+    const double denom = forgetting + xpx;
+    for (size_t i = 0; i < n; ++i) w[i] += pxv[i] * (error / denom);
+    for (size_t i = 0; i < n; ++i)
+    {
+        double* row = &p[i * n];
+        kernels::axpy(-pxv[i] / denom, pxv.data(), row, n);
+        if (forgetting != 1.0)
+            for (size_t j = 0; j < n; ++j) row[j] /= forgetting;
+    }
+}
+
+void RecursiveLeastSquares::apply(Perceptron& model) const
+{
+    model.setParameters(std::vector<double>(w.begin(), w.begin() + static_cast<std::ptrdiff_t>(dim)), w[dim]);
+}
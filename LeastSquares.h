@@ -0,0 +1,110 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "Dataset.h"
+#include "Featurizer.h"
+#include "Perceptron.h"
+#include "SparseVector.h"
+#include "ThreadPool.h"
+
+// Direct solvers for the objective Perceptron::train descends on:
+//   minimize sum 0.5*(w.x + b - y)^2 + 0.5*ridge*|w|^2
+// Instead of many epochs of LMS steps, one pass accumulates the normal
+// equations [X 1]'[X 1] and [X 1]'y, and a Cholesky factorization solves them.
+// The bias column is not regularized. Memory and solve time grow with
+// (inputSize+1)^2 and (inputSize+1)^3, so this is meant for keyword-sized
+// models (kMaxLeastSquaresDimension), not for hashed features.
+
+constexpr size_t kMaxLeastSquaresDimension = 4096;
+
+struct LeastSquaresOptions
+{
+    double ridge = 1e-3;      // L2 penalty on the weights; > 0 keeps the system solvable
+    unsigned threads = 0;     // shards for the accumulation pass; 0 = every worker of the pool
+};
+
+// Accumulators to use for a parallel pass on `workers` threads: one each,
+// fewer if their matrices would take more than ~256 MB together. At least 1.
+size_t gramShardCount(size_t dimension, size_t workers);
+
+// Normal-equation sums for inputs of a fixed dimension d: the upper triangle
+// of the (d+1)x(d+1) Gram matrix (the last row/column is the bias input, 1),
+// X'y and y'y. Accumulators over disjoint samples can be merged, so each
+// thread fills its own and they are added up at the end.
+class GramAccumulator
+{
+public:
+    GramAccumulator() = default;
+    explicit GramAccumulator(size_t dimension);
+
+    size_t dimension() const { return dim; }
+    size_t samples() const { return count; }
+
+    // O(d^2) for a dense row, O(nnz^2) for a sparse one
+    void add(const double* x, double y);
+    void add(const SparseVector& x, double y);
+    void merge(const GramAccumulator& other);
+
+    // element (i, j) of [X 1]'[X 1] for i <= j
+    double gram(size_t i, size_t j) const { return g[i * (dim + 1) + j]; }
+    double xty(size_t i) const { return xy[i]; }
+    double yty() const { return yy; }
+
+private:
+    size_t dim = 0;
+    size_t count = 0;
+    std::vector<double> g;     // (d+1)^2, row-major, upper triangle used
+    std::vector<double> xy;    // d+1
+    double yy = 0.0;
+};
+
+// Ridge solution of the accumulated system. false + error if it is not
+// positive definite (only possible with ridge == 0 and collinear inputs).
+// loss (optional) receives the mean training loss 0.5*(score-y)^2.
+bool solveLeastSquares(const GramAccumulator& sums, double ridge, std::vector<double>& weights, double& bias,
+    std::string* error = nullptr, double* loss = nullptr);
+
+// One parallel pass over data, then the solve; the model's weights and bias
+// are replaced. pool == nullptr runs the pass on the calling thread. Returns
+// false + error if the model is too large or the system cannot be solved;
+// the model is unchanged then.
+bool fitLeastSquares(Perceptron& model, const Dataset& data, const LeastSquaresOptions& options = LeastSquaresOptions(),
+    ThreadPool* pool = nullptr, std::string* error = nullptr, double* loss = nullptr);
+bool fitLeastSquares(Perceptron& model, const SparseDataset& data, const LeastSquaresOptions& options = LeastSquaresOptions(),
+    ThreadPool* pool = nullptr, std::string* error = nullptr, double* loss = nullptr);
+
+// Incremental (recursive) least squares: keeps the inverse of the regularized
+// Gram matrix, so each new sample updates the exact solution in O(d^2)
+// without a full retrain. Start it from nothing, or from the sums of an
+// earlier pass to continue where fitLeastSquares left off.
+class RecursiveLeastSquares
+{
+public:
+    // forgetting < 1 discounts old samples by that factor per update (drift)
+    explicit RecursiveLeastSquares(size_t dimension, double ridge = 1e-3, double forgetting = 1.0);
+
+    // Replace the state with the solution of sums (same ridge). false + error
+    // if the system is not positive definite.
+    bool start(const GramAccumulator& sums, std::string* error = nullptr);
+
+    void update(const SparseVector& x, double y);
+    void update(const std::vector<double>& x, double y);
+
+    size_t dimension() const { return dim; }
+    const std::vector<double>& getWeights() const { return w; }   // last entry is the bias
+    double getBias() const { return w[dim]; }
+
+    // copy weights and bias into the model (inputSize() must match)
+    void apply(Perceptron& model) const;
+
+private:
+    void updateWith(const std::vector<double>& px, double xpx, double error);
+
+    size_t dim;
+    double forgetting;
+    double ridge;
+    std::vector<double> p;     // (d+1)^2 inverse of the regularized Gram matrix, symmetric
+    std::vector<double> w;     // d weights + bias
+    std::vector<double> px;    // scratch: P x
+};
@@ -0,0 +1,72 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Bounded, thread-safe log of text lines: a ring that keeps the newest
+// `capacity` lines. write() never waits for the reader and never grows memory;
+// when the ring is full the oldest undrained line is overwritten and counted
+// in dropped(). A writer (e.g. a training thread) logs while a reader (the UI)
+// polls drain() at its own pace.
+class LogSink
+{
+public:
+    explicit LogSink(size_t capacity = 4096) : lines(capacity ? capacity : 1) {}
+
+    LogSink(const LogSink&) = delete;
+    LogSink& operator=(const LogSink&) = delete;
+
+    size_t capacity() const { return lines.size(); }
+
+    void write(std::string line)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (head - tail == lines.size())
+        {
+            ++tail;
+            ++droppedCount;
+        }
+        lines[head % lines.size()] = std::move(line);
+        ++head;
+    }
+
+    // appends every line written since the last drain to out; returns how many
+    size_t drain(std::vector<std::string>& out)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        const size_t n = static_cast<size_t>(head - tail);
+        for (; tail < head; ++tail)
+            out.push_back(std::move(lines[tail % lines.size()]));
+        return n;
+    }
+
+    // lines written so far / lines overwritten before they were drained
+    uint64_t written() const
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return head;
+    }
+    uint64_t dropped() const
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return droppedCount;
+    }
+
+    // discards undrained lines and resets dropped()
+    void clear()
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        tail = head;
+        droppedCount = 0;
+    }
+
+private:
+    mutable std::mutex lock;
+    std::vector<std::string> lines;   // ring; line i lives at i % capacity
+    uint64_t head = 0;                // lines written
+    uint64_t tail = 0;                // first line not yet drained
+    uint64_t droppedCount = 0;
+};
@@ -0,0 +1,193 @@
+#include "MappedFile.h"
+#include "Metrics.h"
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if (this != &other)
+    {
+        close();
+        data = other.data;
+        length = other.length;
+        mapped = other.mapped;
+        buffer = std::move(other.buffer); // heap block moves, so `data` stays valid
+        other.data = nullptr;
+        other.length = 0;
+        other.mapped = false;
+    }
+    return *this;
+}
+
+void MappedFile::close()
+{
+    if (mapped && data)
+    {
+#ifdef _WIN32
+        UnmapViewOfFile(data);
+#else
+        munmap(const_cast<char*>(data), length);
+#endif
+    }
+    data = nullptr;
+    length = 0;
+    mapped = false;
+    buffer.clear();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& filename, std::string* error, bool sequential)
+{
+    close();
+
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+        OPEN_EXISTING, sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        if (error) *error = "cannot open '" + filename + "' (error " + std::to_string(GetLastError()) + ")";
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize))
+    {
+        if (error) *error = "cannot stat '" + filename + "' (error " + std::to_string(GetLastError()) + ")";
+        CloseHandle(file);
+        return false;
+    }
+    const size_t n = static_cast<size_t>(fileSize.QuadPart);
+
+    bool ok = true;
+    std::string reason; // why !ok, captured before CloseHandle() can change the last error
+    if (n >= kMapThreshold)
+    {
+        HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+        if (!view) reason = "error " + std::to_string(GetLastError());
+        if (mapping) CloseHandle(mapping); // the view keeps the mapping alive
+        if (view)
+        {
+            data = static_cast<const char*>(view);
+            length = n;
+            mapped = true;
+        }
+        else ok = false;
+    }
+    else if (n > 0)
+    {
+        buffer.resize(n);
+        DWORD got = 0;
+        if (!ReadFile(file, buffer.data(), static_cast<DWORD>(n), &got, NULL))
+            reason = "error " + std::to_string(GetLastError());
+        else if (got != n)
+            reason = "file changed size while reading";
+        ok = reason.empty();
+        data = buffer.data();
+        length = n;
+    }
+    CloseHandle(file);
+
+    if (!ok)
+    {
+        if (error) *error = "cannot read '" + filename + "': " + reason;
+        close();
+    }
+    if (ok) METRIC_ADD(BytesRead, length);
+    return ok;
+}
+
+#else
+
+bool MappedFile::open(const std::string& filename, std::string* error, bool sequential)
+{
+    close();
+
+    int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        if (error) *error = "cannot open '" + filename + "': " + std::strerror(errno);
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        if (error) *error = "cannot stat '" + filename + "': " + std::strerror(errno);
+        ::close(fd);
+        return false;
+    }
+    if (!S_ISREG(st.st_mode))
+    {
+        if (error) *error = "'" + filename + "' is not a regular file";
+        ::close(fd);
+        return false;
+    }
+    const size_t n = static_cast<size_t>(st.st_size);
+
+    bool ok = true;
+    std::string reason; // why !ok, captured before close() can change errno
+    if (n >= kMapThreshold)
+    {
+        void* view = mmap(nullptr, n, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (view != MAP_FAILED)
+        {
+            madvise(view, n, sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+            data = static_cast<const char*>(view);
+            length = n;
+            mapped = true;
+        }
+        else
+        {
+            ok = false;
+            reason = std::strerror(errno);
+        }
+    }
+    else if (n > 0)
+    {
+        // single read() for small files; loop only on short reads
+        buffer.resize(n);
+        size_t got = 0;
+        while (got < n)
+        {
+            ssize_t r = ::read(fd, buffer.data() + got, n - got);
+            if (r < 0 && errno == EINTR) continue;
+            if (r < 0) reason = std::strerror(errno);
+            else if (r == 0) reason = "file changed size while reading";
+            if (r <= 0) break;
+            got += static_cast<size_t>(r);
+        }
+        ok = (got == n);
+        data = buffer.data();
+        length = n;
+    }
+    ::close(fd);
+
+    if (!ok)
+    {
+        if (error) *error = "cannot read '" + filename + "': " + reason;
+        close();
+    }
+    if (ok) METRIC_ADD(BytesRead, length);
+    return ok;
+}
+
+#endif
@@ -0,0 +1,39 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+
+// Read-only view of a whole file.
+// Large files are memory-mapped and used in place; small files are pulled in
+// with a single read() because mapping costs more than copying a few KB.
+class MappedFile
+{
+public:
+    // files at least this big are mapped instead of read
+    static constexpr size_t kMapThreshold = 64 * 1024;
+
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    // Opens filename; on failure returns false and fills *error (if given).
+    // sequential hints the OS to read ahead (documents); pass false for files
+    // accessed at random, such as mapped model weights.
+    bool open(const std::string& filename, std::string* error = nullptr, bool sequential = true);
+    void close();
+
+    std::string_view view() const { return std::string_view(data, length); }
+    size_t size() const { return length; }
+    bool isMapped() const { return mapped; }
+
+private:
+    const char* data = nullptr;
+    size_t length = 0;
+    bool mapped = false;
+    std::vector<char> buffer;   // small-file fallback storage
+};
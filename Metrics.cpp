@@ -0,0 +1,243 @@
+#include "Metrics.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+    using metrics::Snapshot;
+    using metrics::ThreadSlot;
+
+    // live slots plus what finished threads left behind
+    struct Registry
+    {
+        std::mutex lock;
+        std::vector<ThreadSlot*> live;
+        Snapshot retired;
+        Snapshot baseline;    // subtracted by snapshot(); set by reset()
+    };
+
+    // never destroyed: worker threads of static pools can exit after main()
+    Registry& registry()
+    {
+        static Registry* r = new Registry;
+        return *r;
+    }
+
+    uint64_t get(const std::atomic<uint64_t>& v) { return v.load(std::memory_order_relaxed); }
+
+    void addSlot(Snapshot& s, const ThreadSlot& slot)
+    {
+        for (size_t c = 0; c < metrics::kCounters; ++c) s.counters[c] += get(slot.counters[c]);
+        for (size_t t = 0; t < metrics::kTimers; ++t)
+        {
+            metrics::TimerStats& ts = s.timers[t];
+            ts.count += get(slot.timed[t]);
+            ts.sumNs += get(slot.sumNs[t]);
+            ts.maxNs = (std::max)(ts.maxNs, get(slot.maxNs[t]));
+            for (size_t b = 0; b < metrics::kBuckets; ++b) ts.buckets[b] += get(slot.buckets[t][b]);
+        }
+    }
+
+    bool fail(std::string* error, const std::string& message)
+    {
+        if (error) *error = message;
+        return false;
+    }
+
+    const char* const kCounterNames[metrics::kCounters] = {
+        "bytes_read", "documents", "tokens", "keyword_hits", "scores", "train_steps"
+    };
+    const char* const kTimerNames[metrics::kTimers] = {
+        "extract", "tokenize", "match", "score", "train", "model_save", "model_load"
+    };
+    const double kQuantiles[] = { 0.5, 0.9, 0.99, 0.999 };
+}
+
+namespace metrics
+{
+    ThreadSlot::ThreadSlot()
+    {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> guard(r.lock);
+        r.live.push_back(this);
+    }
+
+    ThreadSlot::~ThreadSlot()
+    {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> guard(r.lock);
+        addSlot(r.retired, *this);
+        r.live.erase(std::remove(r.live.begin(), r.live.end(), this), r.live.end());
+    }
+
+    ThreadSlot& createLocal()
+    {
+        thread_local ThreadSlot slot;
+        return slot;
+    }
+
+    void record(Timer t, uint64_t ns)
+    {
+        ThreadSlot& slot = local();
+        const size_t i = static_cast<size_t>(t);
+        bump(slot.timed[i], 1);
+        bump(slot.sumNs[i], ns);
+        bump(slot.buckets[i][bucketOf(ns)], 1);
+        if (ns > get(slot.maxNs[i])) slot.maxNs[i].store(ns, std::memory_order_relaxed);
+    }
+
+    void setSampleInterval(uint32_t interval)
+    {
+        uint32_t p = 1;
+        while (p < interval && p < (1u << 31)) p <<= 1;
+        sampleMask.store(p - 1, std::memory_order_relaxed);
+    }
+
+    uint32_t sampleInterval() { return sampleMask.load(std::memory_order_relaxed) + 1; }
+
+    double TimerStats::percentileNs(double q) const
+    {
+        if (count == 0) return 0.0;
+        const double rank = q * static_cast<double>(count);
+        uint64_t seen = 0;
+        for (size_t b = 0; b < kBuckets; ++b)
+        {
+            seen += buckets[b];
+            if (buckets[b] && static_cast<double>(seen) >= rank)
+            {
+                const double low = static_cast<double>(bucketLow(b));
+                const double high = b + 1 < kBuckets ? static_cast<double>(bucketLow(b + 1)) : low * 1.25;
+                return (std::min)((low + high) / 2.0, static_cast<double>(maxNs));
+            }
+        }
+        return static_cast<double>(maxNs);
+    }
+
+    const char* counterName(Counter c) { return kCounterNames[static_cast<size_t>(c)]; }
+    const char* timerName(Timer t) { return kTimerNames[static_cast<size_t>(t)]; }
+
+    bool enabled()
+    {
+#ifdef PERCEPTRON_METRICS
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    Snapshot snapshot()
+    {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> guard(r.lock);
+        Snapshot s = r.retired;
+        for (const ThreadSlot* slot : r.live) addSlot(s, *slot);
+
+        // maxNs is kept since process start; everything else counts from reset()
+        for (size_t c = 0; c < kCounters; ++c) s.counters[c] -= r.baseline.counters[c];
+        for (size_t t = 0; t < kTimers; ++t)
+        {
+            s.timers[t].count -= r.baseline.timers[t].count;
+            s.timers[t].sumNs -= r.baseline.timers[t].sumNs;
+            for (size_t b = 0; b < kBuckets; ++b) s.timers[t].buckets[b] -= r.baseline.timers[t].buckets[b];
+        }
+        return s;
+    }
+
+    void reset()
+    {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> guard(r.lock);
+        Snapshot s = r.retired;
+        for (const ThreadSlot* slot : r.live) addSlot(s, *slot);
+        r.baseline = s;
+    }
+
+    std::string toJson(const Snapshot& s)
+    {
+        std::string out = "{\"counters\":{";
+        char buf[256];
+        for (size_t c = 0; c < kCounters; ++c)
+        {
+            std::snprintf(buf, sizeof(buf), "%s\"%s\":%llu", c ? "," : "", kCounterNames[c],
+                static_cast<unsigned long long>(s.counters[c]));
+            out += buf;
+        }
+        out += "},\"timers\":{";
+        for (size_t t = 0; t < kTimers; ++t)
+        {
+            const TimerStats& ts = s.timers[t];
+            std::snprintf(buf, sizeof(buf),
+                "%s\"%s\":{\"count\":%llu,\"sum_ns\":%llu,\"max_ns\":%llu,"
+                "\"p50_ns\":%.0f,\"p90_ns\":%.0f,\"p99_ns\":%.0f,\"p999_ns\":%.0f}",
+                t ? "," : "", kTimerNames[t], static_cast<unsigned long long>(ts.count),
+                static_cast<unsigned long long>(ts.sumNs), static_cast<unsigned long long>(ts.maxNs),
+                ts.percentileNs(0.5), ts.percentileNs(0.9), ts.percentileNs(0.99), ts.percentileNs(0.999));
+            out += buf;
+        }
+        out += "}}\n";
+        return out;
+    }
+
+    std::string toPrometheus(const Snapshot& s)
+    {
+        std::string out;
+        char buf[256];
+        for (size_t c = 0; c < kCounters; ++c)
+        {
+            std::snprintf(buf, sizeof(buf), "# TYPE perceptron_%s_total counter\nperceptron_%s_total %llu\n",
+                kCounterNames[c], kCounterNames[c], static_cast<unsigned long long>(s.counters[c]));
+            out += buf;
+        }
+        for (size_t t = 0; t < kTimers; ++t)
+        {
+            const TimerStats& ts = s.timers[t];
+            const char* name = kTimerNames[t];
+            std::snprintf(buf, sizeof(buf), "# TYPE perceptron_%s_seconds summary\n", name);
+            out += buf;
+            for (double q : kQuantiles)
+            {
+                std::snprintf(buf, sizeof(buf), "perceptron_%s_seconds{quantile=\"%g\"} %.9g\n",
+                    name, q, ts.percentileNs(q) * 1e-9);
+                out += buf;
+            }
+            std::snprintf(buf, sizeof(buf),
+                "perceptron_%s_seconds_sum %.9g\nperceptron_%s_seconds_count %llu\n"
+                "# TYPE perceptron_%s_seconds_max gauge\nperceptron_%s_seconds_max %.9g\n",
+                name, static_cast<double>(ts.sumNs) * 1e-9, name, static_cast<unsigned long long>(ts.count),
+                name, name, static_cast<double>(ts.maxNs) * 1e-9);
+            out += buf;
+        }
+        return out;
+    }
+
+    bool writeSnapshot(const std::string& filename, Format format, std::string* error)
+    {
+        if (!enabled())
+            return fail(error, "metrics are compiled out (build with PERCEPTRON_METRICS)");
+
+        const Snapshot s = snapshot();
+        const std::string text = format == Format::Json ? toJson(s) : toPrometheus(s);
+
+        // write next to the target, then rename over it, so scrapers never see half a file
+        const std::string tmp = filename + ".tmp";
+        {
+            std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+            if (!out) return fail(error, "cannot create '" + tmp + "'");
+            out.write(text.data(), static_cast<std::streamsize>(text.size()));
+            out.flush();
+            if (!out) return fail(error, "cannot write '" + tmp + "'");
+        }
+#ifdef _WIN32
+        std::remove(filename.c_str()); // rename does not replace on Windows
+#endif
+        if (std::rename(tmp.c_str(), filename.c_str()) != 0)
+        {
+            std::remove(tmp.c_str());
+            return fail(error, "cannot rename '" + tmp + "' to '" + filename + "'");
+        }
+        return true;
+    }
+}
@@ -0,0 +1,194 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Hot-path instrumentation: per-thread counters and latency histograms.
+//
+// Built only with PERCEPTRON_METRICS defined (CMake option of the same name).
+// Without it the METRIC_* macros expand to nothing and no timing code is
+// compiled in; snapshot() then returns zeros and writeSnapshot() fails.
+//
+// Every thread updates its own slot with plain relaxed stores, so recording
+// takes no lock and shares no cache line with other threads. snapshot() sums
+// the slots of live threads plus the totals left behind by finished ones.
+//
+// Timers that wrap very cheap calls (Score, Train) only time one call in
+// sampleInterval(); their histograms describe latency, while the matching
+// counters (Scores, TrainSteps) count every call. Extraction is split into
+// Tokenize and Match by extracting one document in sampleInterval() in two
+// passes (see FeatureExtractor.h).
+namespace metrics
+{
+    enum class Counter
+    {
+        BytesRead,       // bytes of every file opened through MappedFile
+        Documents,       // documents extracted
+        Tokens,          // tokens produced by the tokenizer
+        KeywordHits,     // keyword matches (sum of keyword counts)
+        Scores,          // score() calls, including the one inside each train()
+        TrainSteps,      // samples trained
+        Count
+    };
+
+    enum class Timer
+    {
+        Extract,         // one document, tokenizing + matching
+        Tokenize,        // sampled: tokenizer pass alone
+        Match,           // sampled: keyword lookup over the tokens alone
+        Score,           // sampled
+        Train,           // sampled
+        ModelSave,
+        ModelLoad,
+        Count
+    };
+
+    constexpr size_t kCounters = static_cast<size_t>(Counter::Count);
+    constexpr size_t kTimers = static_cast<size_t>(Timer::Count);
+
+    // Log-linear latency buckets: 4 per power of two, so a percentile read
+    // from the histogram is within 12.5% of the true value. Values 0..3 ns
+    // get exact buckets; the last bucket ends at 2^64 ns.
+    constexpr size_t kBuckets = 252;
+
+    inline size_t bucketOf(uint64_t ns)
+    {
+        if (ns < 4) return static_cast<size_t>(ns);
+        unsigned e = 63;
+        while (!(ns >> e)) --e;
+        return 4 * (e - 1) + static_cast<size_t>((ns >> (e - 2)) & 3);
+    }
+
+    // smallest value that falls into bucket b
+    inline uint64_t bucketLow(size_t b)
+    {
+        if (b < 4) return b;
+        const unsigned e = static_cast<unsigned>(b / 4 + 1);
+        return (4 + (b & 3)) << (e - 2);
+    }
+
+    struct TimerStats
+    {
+        uint64_t count = 0;          // timed calls
+        uint64_t sumNs = 0;
+        uint64_t maxNs = 0;
+        std::array<uint64_t, kBuckets> buckets{};
+
+        // q in [0, 1]; midpoint of the bucket holding the q-quantile
+        double percentileNs(double q) const;
+    };
+
+    struct Snapshot
+    {
+        std::array<uint64_t, kCounters> counters{};
+        std::array<TimerStats, kTimers> timers{};
+    };
+
+    const char* counterName(Counter c);
+    const char* timerName(Timer t);
+
+    // One thread's metrics. Only the owning thread writes; snapshot() reads
+    // the atomics from other threads.
+    struct ThreadSlot
+    {
+        std::array<std::atomic<uint64_t>, kCounters> counters{};
+        std::array<std::atomic<uint64_t>, kTimers> timed{};
+        std::array<std::atomic<uint64_t>, kTimers> sumNs{};
+        std::array<std::atomic<uint64_t>, kTimers> maxNs{};
+        std::array<std::array<std::atomic<uint64_t>, kBuckets>, kTimers> buckets{};
+        std::array<uint32_t, kTimers> calls{};   // for sampling; owner only
+
+        ThreadSlot();    // registers with snapshot()
+        ~ThreadSlot();   // folds this thread's numbers into the retired totals
+    };
+
+    ThreadSlot& createLocal();   // first use on a thread
+
+    inline ThreadSlot& local()
+    {
+        // a plain pointer needs no TLS init guard, so the hot path is one load
+        thread_local ThreadSlot* slot = nullptr;
+        if (!slot) slot = &createLocal();
+        return *slot;
+    }
+
+    inline void bump(std::atomic<uint64_t>& v, uint64_t n)
+    {
+        v.store(v.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    inline void add(Counter c, uint64_t n = 1)
+    {
+        bump(local().counters[static_cast<size_t>(c)], n);
+    }
+
+    void record(Timer t, uint64_t ns);
+
+    // Time one call in this many for Tokenize/Match/Score/Train (default 64,
+    // rounded up to a power of two). Other timers time every call.
+    void setSampleInterval(uint32_t interval);
+    uint32_t sampleInterval();
+
+    inline std::atomic<uint32_t> sampleMask{ 63 };   // sampleInterval() - 1
+
+    // true if this call of t should be timed
+    inline bool sampled(Timer t)
+    {
+        if (t == Timer::Extract || t == Timer::ModelSave || t == Timer::ModelLoad) return true;
+        uint32_t& calls = local().calls[static_cast<size_t>(t)];
+        return (++calls & sampleMask.load(std::memory_order_relaxed)) == 0;
+    }
+
+    class ScopedTimer
+    {
+    public:
+        explicit ScopedTimer(Timer t) : timer(t), active(sampled(t))
+        {
+            if (active) start = std::chrono::steady_clock::now();
+        }
+        ~ScopedTimer()
+        {
+            if (active) record(timer, elapsedNs(start));
+        }
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+        static uint64_t elapsedNs(std::chrono::steady_clock::time_point since)
+        {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - since).count());
+        }
+
+    private:
+        Timer timer;
+        bool active;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    // true when built with PERCEPTRON_METRICS
+    bool enabled();
+
+    // Sum over all threads, live and finished
+    Snapshot snapshot();
+    // Zero every counter and histogram
+    void reset();
+
+    enum class Format { Json, Prometheus };
+    std::string toJson(const Snapshot& s);
+    std::string toPrometheus(const Snapshot& s);
+
+    // Write a snapshot to a local file (temporary file + rename). False with
+    // *error if metrics are compiled out or the file cannot be written.
+    bool writeSnapshot(const std::string& filename, Format format, std::string* error = nullptr);
+}
+
+#ifdef PERCEPTRON_METRICS
+#define METRIC_ADD(counter, n) ::metrics::add(::metrics::Counter::counter, static_cast<uint64_t>(n))
+#define METRIC_TIME(timer) ::metrics::ScopedTimer metricTimer##timer(::metrics::Timer::timer)
+#else
+#define METRIC_ADD(counter, n) ((void)0)
+#define METRIC_TIME(timer) ((void)0)
+#endif
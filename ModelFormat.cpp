@@ -0,0 +1,289 @@
+#include "ModelFormat.h"
+#include "Metrics.h"
+#include "Quantization.h"
+#include "VectorKernels.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace
+{
+    bool hostIsLittleEndian()
+    {
+        const uint16_t probe = 1;
+        unsigned char first;
+        std::memcpy(&first, &probe, 1);
+        return first == 1;
+    }
+
+    size_t weightBytes(ModelWeightType type)
+    {
+        if (type == ModelWeightType::Int8) return sizeof(int8_t);
+        return type == ModelWeightType::Float32 ? sizeof(float) : sizeof(double);
+    }
+
+    // checksum of the header with both checksum fields zeroed, then the keyword table
+    uint64_t metaChecksumOf(ModelFileHeader h, const char* keywords)
+    {
+        h.metaChecksum = 0;
+        h.weightsChecksum = 0;
+        uint64_t c = modelChecksum(&h, sizeof(h));
+        return modelChecksum(keywords, static_cast<size_t>(h.keywordsSize), c);
+    }
+
+    bool fail(std::string* error, const std::string& msg)
+    {
+        if (error) *error = msg;
+        return false;
+    }
+
+}
+
+uint64_t modelChecksum(const void* data, size_t size, uint64_t seed)
+{
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    uint64_t h = 14695981039346656037ull ^ seed;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8)
+    {
+        uint64_t word;
+        std::memcpy(&word, p + i, 8);
+        h = (h ^ word) * 1099511628211ull;
+        h ^= h >> 29;
+    }
+    for (; i < size; ++i)
+        h = (h ^ p[i]) * 1099511628211ull;
+    return h ^ (h >> 32);
+}
+
+bool isBinaryModelFile(const std::string& filename)
+{
+    std::ifstream in(filename, std::ios::binary);
+    char magic[sizeof(kModelMagic)] = {};
+    in.read(magic, sizeof(magic));
+    return in && std::memcmp(magic, kModelMagic, sizeof(magic)) == 0;
+}
+
+namespace
+{
+    // shared by writeModelFile and writeQuantizedModelFile
+    bool writeModel(const std::string& filename, const void* weights, size_t dimension,
+        ModelWeightType weightType, float weightScale, double learningRate, double bias,
+        const FeatureConfig& features, std::string* error)
+    {
+        if (!hostIsLittleEndian())
+            return fail(error, "binary models are only supported on little-endian hosts");
+
+        // keyword table
+        std::string keywords;
+        if (features.mode == FeatureMode::Keywords)
+        {
+            for (const auto& k : features.keywords)
+            {
+                const uint32_t len = static_cast<uint32_t>(k.size());
+                keywords.append(reinterpret_cast<const char*>(&len), sizeof(len));
+                keywords.append(k);
+            }
+        }
+
+        ModelFileHeader h{};
+        std::memcpy(h.magic, kModelMagic, sizeof(h.magic));
+        const bool exact = features.mode == FeatureMode::Keywords && features.match == KeywordMatch::ExactToken;
+        h.version = exact ? 2 : 1;
+        h.headerSize = sizeof(ModelFileHeader);
+        h.dimension = dimension;
+        h.learningRate = learningRate;
+        h.bias = bias;
+        h.weightType = static_cast<uint32_t>(weightType);
+        h.featureMode = static_cast<uint32_t>(features.mode);
+        h.hashBits = features.hashing.bits;
+        h.hashSeed = features.hashing.seed;
+        h.featureFlags = (features.hashing.signedHash ? kFeatureSignedHash : 0) | (exact ? kFeatureExactTokens : 0);
+        h.weightScale = weightScale;
+        h.keywordsOffset = sizeof(ModelFileHeader);
+        h.keywordsSize = keywords.size();
+        h.weightsOffset = (h.keywordsOffset + h.keywordsSize + kModelWeightAlign - 1) / kModelWeightAlign * kModelWeightAlign;
+        h.weightsSize = dimension * weightBytes(weightType);
+        h.weightsChecksum = modelChecksum(weights, static_cast<size_t>(h.weightsSize));
+        h.metaChecksum = metaChecksumOf(h, keywords.data());
+
+        // write next to the target, then rename over it
+        const std::string tmp = filename + ".tmp";
+        {
+            std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+            if (!out) return fail(error, "cannot create '" + tmp + "'");
+
+            const std::string padding(static_cast<size_t>(h.weightsOffset - h.keywordsOffset - h.keywordsSize), '\0');
+            const uint64_t tailEnd = (h.weightsSize + kI8WeightPadding + kModelWeightAlign - 1) / kModelWeightAlign * kModelWeightAlign;
+            const std::string tail(weightType == ModelWeightType::Int8 ? static_cast<size_t>(tailEnd - h.weightsSize) : 0, '\0');
+            out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+            out.write(keywords.data(), static_cast<std::streamsize>(keywords.size()));
+            out.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+            out.write(static_cast<const char*>(weights), static_cast<std::streamsize>(h.weightsSize));
+            out.write(tail.data(), static_cast<std::streamsize>(tail.size()));
+            out.flush();
+            if (!out) return fail(error, "cannot write '" + tmp + "'");
+        }
+#ifdef _WIN32
+        std::remove(filename.c_str()); // rename does not replace on Windows
+#endif
+        if (std::rename(tmp.c_str(), filename.c_str()) != 0)
+        {
+            std::remove(tmp.c_str());
+            return fail(error, "cannot rename '" + tmp + "' to '" + filename + "'");
+        }
+        return true;
+    }
+}
+
+bool writeModelFile(const std::string& filename, const void* weights, size_t dimension,
+    ModelWeightType weightType, double learningRate, double bias,
+    const FeatureConfig& features, std::string* error)
+{
+    if (weightType == ModelWeightType::Int8)
+        return fail(error, "int8 weights need a scale: use writeQuantizedModelFile");
+    return writeModel(filename, weights, dimension, weightType, 0.0f, learningRate, bias, features, error);
+}
+
+bool writeQuantizedModelFile(const std::string& filename, const int8_t* weights, size_t dimension,
+    float weightScale, double learningRate, double bias,
+    const FeatureConfig& features, std::string* error)
+{
+    return writeModel(filename, weights, dimension, ModelWeightType::Int8, weightScale, learningRate, bias,
+        features, error);
+}
+
+bool MappedModel::open(const std::string& filename, std::string* error, bool verifyWeights)
+{
+    METRIC_TIME(ModelLoad);
+    // drop the previous model first: a failed open leaves nothing behind
+    *this = MappedModel();
+    if (!hostIsLittleEndian())
+        return fail(error, "binary models are only supported on little-endian hosts");
+
+    MappedFile f;
+    if (!f.open(filename, error, /*sequential=*/false))
+        return false;
+
+    const std::string_view bytes = f.view();
+    ModelFileHeader h;
+    if (bytes.size() < sizeof(h))
+        return fail(error, "'" + filename + "' is too small to be a model");
+    std::memcpy(&h, bytes.data(), sizeof(h));
+
+    if (std::memcmp(h.magic, kModelMagic, sizeof(h.magic)) != 0)
+        return fail(error, "'" + filename + "' is not a binary model");
+    if (h.version == 0 || h.version > kModelVersion || h.headerSize != sizeof(ModelFileHeader))
+        return fail(error, "'" + filename + "' has unsupported model version " + std::to_string(h.version));
+    if (h.weightType > static_cast<uint32_t>(ModelWeightType::Int8)
+        || h.featureMode > static_cast<uint32_t>(FeatureMode::Hashing))
+        return fail(error, "'" + filename + "' has an unknown weight type or feature mode");
+    const uint64_t wordBytes = weightBytes(static_cast<ModelWeightType>(h.weightType));
+    if (h.keywordsOffset > bytes.size() || h.keywordsSize > bytes.size() - h.keywordsOffset
+        || h.weightsOffset > bytes.size() || h.weightsSize > bytes.size() - h.weightsOffset
+        || h.weightsSize / wordBytes != h.dimension || h.weightsSize % wordBytes != 0)
+        return fail(error, "'" + filename + "' is truncated or has inconsistent sections");
+    // the weights are read in place as float/double
+    if (reinterpret_cast<uintptr_t>(bytes.data() + h.weightsOffset) % wordBytes != 0)
+        return fail(error, "'" + filename + "' has a misaligned weight block");
+    if (h.weightType == static_cast<uint32_t>(ModelWeightType::Int8)
+        && (bytes.size() - h.weightsOffset - h.weightsSize < kI8WeightPadding || !(h.weightScale >= 0.0f)))
+        return fail(error, "'" + filename + "' has a truncated or invalid int8 weight block");
+
+    const char* kw = bytes.data() + h.keywordsOffset;
+    if (metaChecksumOf(h, kw) != h.metaChecksum)
+        return fail(error, "'" + filename + "': header checksum mismatch");
+    const char* w = bytes.data() + h.weightsOffset;
+    if (verifyWeights && modelChecksum(w, static_cast<size_t>(h.weightsSize)) != h.weightsChecksum)
+        return fail(error, "'" + filename + "': weight checksum mismatch");
+
+    FeatureConfig config;
+    if (static_cast<FeatureMode>(h.featureMode) == FeatureMode::Hashing)
+    {
+        HashingConfig hc;
+        hc.bits = h.hashBits;
+        hc.seed = h.hashSeed;
+        hc.signedHash = (h.featureFlags & kFeatureSignedHash) != 0;
+        if (hc.bits == 0 || hc.bits > kMaxHashBits)
+            return fail(error, "'" + filename + "' has invalid hashing bits");
+        config = FeatureConfig::forHashing(hc);
+    }
+    else
+    {
+        size_t pos = 0;
+        while (pos < h.keywordsSize)
+        {
+            uint32_t len;
+            if (h.keywordsSize - pos < sizeof(len))
+                return fail(error, "'" + filename + "' has a corrupt keyword table");
+            std::memcpy(&len, kw + pos, sizeof(len));
+            pos += sizeof(len);
+            if (h.keywordsSize - pos < len)
+                return fail(error, "'" + filename + "' has a corrupt keyword table");
+            config.keywords.emplace_back(kw + pos, len);
+            pos += len;
+        }
+        if (h.featureFlags & kFeatureExactTokens)
+            config.match = KeywordMatch::ExactToken;
+    }
+    if (config.dimension() != h.dimension && !(config.mode == FeatureMode::Keywords && config.keywords.empty()))
+        return fail(error, "'" + filename + "': feature config does not match the weight count");
+
+    file = std::move(f);
+    header = h;
+    features = std::move(config);
+    weights = w;
+    return true;
+}
+
+std::vector<double> MappedModel::getWeights() const
+{
+    const size_t n = dimension();
+    if (weightType() == ModelWeightType::Int8)
+    {
+        const int8_t* w = static_cast<const int8_t*>(weights);
+        std::vector<double> out(n);
+        for (size_t i = 0; i < n; ++i) out[i] = w[i] * static_cast<double>(header.weightScale);
+        return out;
+    }
+    if (weightType() == ModelWeightType::Float32)
+    {
+        const float* w = static_cast<const float*>(weights);
+        return std::vector<double>(w, w + n);
+    }
+    const double* w = static_cast<const double*>(weights);
+    return std::vector<double>(w, w + n);
+}
+
+double MappedModel::score(const std::vector<double>& inputs) const
+{
+    METRIC_ADD(Scores, 1);
+    METRIC_TIME(Score);
+    if (weightType() == ModelWeightType::Int8)
+        return quantizedScore(static_cast<const int8_t*>(weights), header.weightScale, header.bias, inputs);
+    const size_t n = dimension();
+    double s = (weightType() == ModelWeightType::Float32)
+        ? kernels::dot(static_cast<const float*>(weights), inputs.data(), n)
+        : kernels::dot(static_cast<const double*>(weights), inputs.data(), n);
+    return s + header.bias;
+}
+
+double MappedModel::score(const SparseVector& inputs) const
+{
+    METRIC_ADD(Scores, 1);
+    METRIC_TIME(Score);
+    if (weightType() == ModelWeightType::Int8)
+        return quantizedScore(static_cast<const int8_t*>(weights), header.weightScale, header.bias, inputs);
+    double s = 0.0;
+    if (weightType() == ModelWeightType::Float32)
+    {
+        const float* w = static_cast<const float*>(weights);
+        for (size_t k = 0; k < inputs.nnz(); ++k) s += w[inputs.indices[k]] * inputs.values[k];
+    }
+    else
+    {
+        const double* w = static_cast<const double*>(weights);
+        for (size_t k = 0; k < inputs.nnz(); ++k) s += w[inputs.indices[k]] * inputs.values[k];
+    }
+    return s + header.bias;
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "FeatureConfig.h"
+#include "MappedFile.h"
+#include "SparseVector.h"
+
+// Versioned binary model file (little-endian):
+//
+//   [ModelFileHeader][keyword table][padding][weights, 64-byte aligned]
+//
+// The keyword table is, per keyword, a uint32 byte length followed by the
+// bytes. Weights are stored raw so the file can be memory-mapped and scored in
+// place (MappedModel). metaChecksum covers the header and the keyword table;
+// weightsChecksum covers the weight block and is only checked on request,
+// because hashing a large weight block costs more than mapping it.
+//
+// Int8 models (see Quantization.h) store weight = int8 * weightScale and pad
+// the weight block with zeros to the next 64 bytes so the gather kernels can
+// read a few bytes past the last weight.
+//
+// Version 2 adds kFeatureExactTokens. Models without it are still written as
+// version 1, so older readers keep loading them and reject exact-token models
+// instead of silently matching substrings.
+enum class ModelWeightType : uint32_t { Float64 = 0, Float32 = 1, Int8 = 2 };
+
+struct ModelFileHeader
+{
+    char magic[8];            // kModelMagic
+    uint32_t version;         // kModelVersion
+    uint32_t headerSize;      // sizeof(ModelFileHeader)
+    uint64_t dimension;       // number of weights
+    double learningRate;
+    double bias;
+    uint32_t weightType;      // ModelWeightType
+    uint32_t featureMode;     // FeatureMode
+    uint32_t hashBits;
+    uint32_t hashSeed;
+    uint32_t featureFlags;    // kFeatureSignedHash | kFeatureExactTokens
+    float weightScale;        // Int8 only; 0 otherwise
+    uint64_t keywordsOffset;
+    uint64_t keywordsSize;
+    uint64_t weightsOffset;
+    uint64_t weightsSize;
+    uint64_t metaChecksum;
+    uint64_t weightsChecksum;
+};
+static_assert(sizeof(ModelFileHeader) == 112, "ModelFileHeader layout is part of the file format");
+
+constexpr char kModelMagic[8] = { 'P', 'C', 'P', 'T', 'M', 'O', 'D', 'L' };
+constexpr uint32_t kModelVersion = 2;         // newest version this build reads
+constexpr uint32_t kFeatureSignedHash = 1;    // HashingConfig::signedHash
+constexpr uint32_t kFeatureExactTokens = 2;   // KeywordMatch::ExactToken (version 2)
+constexpr size_t kModelWeightAlign = 64;
+
+// true if the file starts with the binary model magic
+bool isBinaryModelFile(const std::string& filename);
+
+// 64-bit checksum used by the format (word-at-a-time FNV-1a variant)
+uint64_t modelChecksum(const void* data, size_t size, uint64_t seed = 0);
+
+// Write a binary model file. Writes to a temporary file and renames it into
+// place, so readers never observe a half-written model.
+bool writeModelFile(const std::string& filename, const void* weights, size_t dimension,
+    ModelWeightType weightType, double learningRate, double bias,
+    const FeatureConfig& features, std::string* error = nullptr);
+
+// Same for an int8-quantized weight vector (weight = weights[i] * weightScale).
+bool writeQuantizedModelFile(const std::string& filename, const int8_t* weights, size_t dimension,
+    float weightScale, double learningRate, double bias,
+    const FeatureConfig& features, std::string* error = nullptr);
+
+// Read-only model backed by a memory-mapped binary model file.
+// The weights are used in place; nothing is copied, so opening is O(header +
+// keyword table) regardless of the weight count.
+class MappedModel
+{
+public:
+    MappedModel() = default;
+
+    // Map and validate filename. verifyWeights also checks the weight block
+    // checksum (touches every page). Any previously opened model is released;
+    // on failure the object is empty (dimension() == 0, no weights).
+    bool open(const std::string& filename, std::string* error = nullptr, bool verifyWeights = false);
+
+    size_t dimension() const { return header.dimension; }
+    double getBias() const { return header.bias; }
+    double getLearningRate() const { return header.learningRate; }
+    ModelWeightType weightType() const { return static_cast<ModelWeightType>(header.weightType); }
+    float weightScale() const { return header.weightScale; }
+    const FeatureConfig& getFeatureConfig() const { return features; }
+
+    // raw weight block (double*, float* or int8_t* depending on weightType())
+    const void* weightData() const { return weights; }
+    // weights converted to double (copies; Int8 weights are dequantized)
+    std::vector<double> getWeights() const;
+
+    double score(const std::vector<double>& inputs) const;
+    double score(const SparseVector& inputs) const;
+    int predict(const std::vector<double>& inputs) const { return score(inputs) >= 0.0 ? 1 : 0; }
+    int predict(const SparseVector& inputs) const { return score(inputs) >= 0.0 ? 1 : 0; }
+
+private:
+    MappedFile file;
+    ModelFileHeader header{};
+    FeatureConfig features;
+    const void* weights = nullptr;
+};
@@ -0,0 +1,149 @@
+#include "ModelRegistry.h"
+#include <chrono>
+#include <cmath>
+#include <utility>
+
+ModelRegistry::~ModelRegistry()
+{
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    if (loader.joinable()) loader.join();
+}
+
+bool ModelRegistry::load(const std::string& filename, std::string* error)
+{
+    const ReloadResult r = loadAndPublish(filename);
+    if (!r.ok && error) *error = r.error;
+    return r.ok;
+}
+
+ModelRegistry::ReloadResult ModelRegistry::loadAndPublish(const std::string& filename)
+{
+    const auto t0 = std::chrono::steady_clock::now();
+    ReloadResult r;
+    r.filename = filename;
+
+    std::shared_ptr<Classifier> model = std::make_shared<Classifier>();
+    if (!model->load(filename, options.fallback, r.error, /*verify=*/true))
+        return r;
+    if (model->getFeaturizer().dimension() != model->dimension())
+    {
+        r.error = "model '" + filename + "' has no feature config matching its "
+            + std::to_string(model->dimension()) + " weights";
+        return r;
+    }
+
+    // score the probes once: catches NaN/inf weights and faults the pages in
+    // before the first real request sees the model
+    Featurizer::Scratch scratch;
+    SparseVector x;
+    for (const std::string& doc : options.probeDocuments)
+    {
+        model->getFeaturizer().extract(doc, x, scratch);
+        if (!std::isfinite(model->classify(x).score))
+        {
+            r.error = "model '" + filename + "' gives a non-finite score on a probe document";
+            return r;
+        }
+    }
+    if (options.validator && !options.validator(*model, r.error))
+    {
+        if (r.error.empty()) r.error = "model '" + filename + "' rejected by validator";
+        return r;
+    }
+
+    publish(std::move(model));
+    r.ok = true;
+    r.version = version();
+    r.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    return r;
+}
+
+void ModelRegistry::publish(Snapshot model)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    Snapshot old = std::atomic_exchange_explicit(&live, std::move(model), std::memory_order_acq_rel);
+    published.fetch_add(1, std::memory_order_release);
+    if (old)
+    {
+        retired.push_back(std::move(old));
+        startLoader();
+        wake.notify_all();
+    }
+}
+
+void ModelRegistry::reloadAsync(const std::string& filename, std::function<void(const ReloadResult&)> onDone)
+{
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        jobs.push_back({ filename, std::move(onDone) });
+        startLoader();
+    }
+    wake.notify_all();
+}
+
+size_t ModelRegistry::retiredCount() const
+{
+    std::lock_guard<std::mutex> guard(lock);
+    return retired.size();
+}
+
+void ModelRegistry::startLoader()
+{
+    if (!loader.joinable() && !stopping)
+        loader = std::thread([this] { loaderLoop(); });
+}
+
+void ModelRegistry::collectRetired()
+{
+    std::vector<Snapshot> free;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        for (size_t i = 0; i < retired.size();)
+        {
+            // no longer current, so nobody can pick it up again: a count of
+            // one means the last reader is gone
+            if (retired[i].use_count() == 1)
+            {
+                free.push_back(std::move(retired[i]));
+                retired[i] = std::move(retired.back());
+                retired.pop_back();
+            }
+            else ++i;
+        }
+    }
+    // destructors (munmap, vectors) run here, outside the lock
+}
+
+void ModelRegistry::loaderLoop()
+{
+    std::unique_lock<std::mutex> guard(lock);
+    for (;;)
+    {
+        // poll retired models while some are still in use
+        const auto poll = std::chrono::milliseconds(10);
+        if (retired.empty())
+            wake.wait(guard, [&] { return stopping || !jobs.empty() || !retired.empty(); });
+        else
+            wake.wait_for(guard, poll, [&] { return stopping || !jobs.empty(); });
+        if (stopping) break;
+
+        if (!jobs.empty())
+        {
+            std::vector<Job> batch;
+            batch.swap(jobs);
+            guard.unlock();
+            const ReloadResult r = loadAndPublish(batch.back().filename);
+            for (const Job& job : batch)
+                if (job.onDone) job.onDone(r);
+            guard.lock();
+        }
+
+        guard.unlock();
+        collectRetired();
+        guard.lock();
+    }
+}
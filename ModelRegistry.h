@@ -0,0 +1,132 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Classifier.h"
+
+// Holds the model that is currently serving and replaces it without pausing
+// predictions (read-copy-update):
+//
+//  - a new model is loaded and validated off to the side (reloadAsync() does
+//    it on the registry's own thread), then published with one atomic
+//    pointer swap;
+//  - readers take a snapshot (a shared_ptr) and keep using it until they are
+//    done, so a prediction never sees a mix of two models;
+//  - the replaced model is retired and freed on the registry thread once the
+//    last reader has let go of it, never on a reader's hot path.
+//
+// current() costs an atomic shared_ptr load; take it once per batch. For a
+// per-call loop, Reader caches the snapshot and only reloads when version()
+// has moved, so the steady state is a single atomic integer load.
+class ModelRegistry
+{
+public:
+    using Snapshot = std::shared_ptr<const Classifier>;
+
+    // Extra check run on a freshly loaded model before it is published;
+    // false + message rejects it.
+    using Validator = std::function<bool(const Classifier&, std::string&)>;
+
+    struct Options
+    {
+        FeatureConfig fallback;                 // for models saved without a feature config
+        std::vector<std::string> probeDocuments; // must score to finite values; also warm the model
+        Validator validator;
+    };
+
+    // Result of a reload, passed to the reloadAsync callback
+    struct ReloadResult
+    {
+        bool ok = false;
+        std::string filename;
+        std::string error;
+        uint64_t version = 0;   // version published (ok only)
+        double seconds = 0.0;   // load + validation
+    };
+
+    ModelRegistry() = default;
+    explicit ModelRegistry(Options options) : options(std::move(options)) {}
+    ~ModelRegistry();   // finishes a reload in progress; queued ones are dropped
+
+    ModelRegistry(const ModelRegistry&) = delete;
+    ModelRegistry& operator=(const ModelRegistry&) = delete;
+
+    // Load, validate and publish on the calling thread. On failure the
+    // current model stays in place.
+    bool load(const std::string& filename, std::string* error = nullptr);
+
+    // Same as load() on the registry thread; returns at once. onDone (may be
+    // empty) runs on that thread. Requests that pile up while a load is
+    // running are merged: only the newest file is loaded and every waiting
+    // onDone gets that result.
+    void reloadAsync(const std::string& filename, std::function<void(const ReloadResult&)> onDone = {});
+
+    // Publish an already loaded model (no validation)
+    void publish(Snapshot model);
+
+    // The serving model; null until the first successful load
+    Snapshot current() const { return std::atomic_load_explicit(&live, std::memory_order_acquire); }
+
+    // bumped by every publish
+    uint64_t version() const { return published.load(std::memory_order_acquire); }
+
+    // models replaced but still held by a reader
+    size_t retiredCount() const;
+
+    // Per-thread cached view of the registry; not thread-safe itself.
+    class Reader
+    {
+    public:
+        explicit Reader(const ModelRegistry& registry) : registry(registry) {}
+
+        // The newest model as of this call, or null. The pointer stays valid
+        // until the next get() on this Reader (or its destruction).
+        const Classifier* get()
+        {
+            const uint64_t v = registry.version();
+            if (v != seen || !snapshot)
+            {
+                snapshot = registry.current();
+                seen = v;
+            }
+            return snapshot.get();
+        }
+
+        // drop the snapshot so a retired model can be freed
+        void release() { snapshot.reset(); }
+
+    private:
+        const ModelRegistry& registry;
+        Snapshot snapshot;
+        uint64_t seen = 0;
+    };
+
+private:
+    struct Job
+    {
+        std::string filename;
+        std::function<void(const ReloadResult&)> onDone;
+    };
+
+    ReloadResult loadAndPublish(const std::string& filename);
+    void startLoader();   // lock held
+    void loaderLoop();
+    void collectRetired();
+
+    Options options;
+    Snapshot live;                          // only touched through atomic_load/atomic_store
+    std::atomic<uint64_t> published{ 0 };
+
+    mutable std::mutex lock;                // guards everything below
+    std::condition_variable wake;
+    std::vector<Snapshot> retired;
+    std::vector<Job> jobs;
+    std::thread loader;                     // started by the first reloadAsync/publish
+    bool stopping = false;
+};
@@ -0,0 +1,205 @@
+#include "MulticlassPerceptron.h"
+#include "Metrics.h"
+#include "VectorKernels.h"
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <limits>
+
+namespace
+{
+    // per-thread padded score buffer
+    double* scratchScores(size_t stride)
+    {
+        thread_local std::vector<double, AlignedAllocator<double, 64>> buffer;
+        if (buffer.size() < stride) buffer.resize(stride);
+        return buffer.data();
+    }
+
+    int argmax(const double* s, size_t n)
+    {
+        return static_cast<int>(std::max_element(s, s + n) - s);
+    }
+}
+
+MulticlassPerceptron::MulticlassPerceptron(int inputSize, int numClasses, double lr)
+    : numInputs(static_cast<size_t>(inputSize)),
+      classCount(static_cast<size_t>(numClasses)),
+      classStride((static_cast<size_t>(numClasses) + Dataset::kRowAlign - 1) / Dataset::kRowAlign * Dataset::kRowAlign),
+      learningRate(lr)
+{
+    std::srand(static_cast<unsigned>(std::time(nullptr)));
+
+    // same [-0.5, 0.5] init as Perceptron; padding columns stay 0
+    weights.assign(numInputs * classStride, 0.0);
+    bias.assign(classStride, 0.0);
+    for (size_t c = 0; c < classCount; ++c)
+        bias[c] = (static_cast<double>(std::rand()) / RAND_MAX) - 0.5;
+    for (size_t f = 0; f < numInputs; ++f)
+        for (size_t c = 0; c < classCount; ++c)
+            weights[f * classStride + c] = (static_cast<double>(std::rand()) / RAND_MAX) - 0.5;
+}
+
+void MulticlassPerceptron::scoreSparse(const SparseVector& inputs, double* acc) const
+{
+    METRIC_ADD(Scores, 1);
+    METRIC_TIME(Score);
+    std::copy(bias.begin(), bias.end(), acc);
+    kernels::gatherRows(weights.data(), classStride, inputs.indices.data(), inputs.values.data(), inputs.nnz(), acc);
+}
+
+void MulticlassPerceptron::scoreDense(const std::vector<double>& inputs, double* acc) const
+{
+    METRIC_ADD(Scores, 1);
+    METRIC_TIME(Score);
+    std::copy(bias.begin(), bias.end(), acc);
+    const size_t n = std::min(inputs.size(), numInputs);
+    for (size_t f = 0; f < n; ++f)
+        if (inputs[f] != 0.0) kernels::axpy(inputs[f], &weights[f * classStride], acc, classStride);
+}
+
+void MulticlassPerceptron::scores(const SparseVector& inputs, std::vector<double>& out) const
+{
+    double* acc = scratchScores(classStride);
+    scoreSparse(inputs, acc);
+    out.assign(acc, acc + classCount);
+}
+
+void MulticlassPerceptron::scores(const std::vector<double>& inputs, std::vector<double>& out) const
+{
+    double* acc = scratchScores(classStride);
+    scoreDense(inputs, acc);
+    out.assign(acc, acc + classCount);
+}
+
+int MulticlassPerceptron::predict(const SparseVector& inputs) const
+{
+    double* acc = scratchScores(classStride);
+    scoreSparse(inputs, acc);
+    return argmax(acc, classCount);
+}
+
+int MulticlassPerceptron::predict(const std::vector<double>& inputs) const
+{
+    double* acc = scratchScores(classStride);
+    scoreDense(inputs, acc);
+    return argmax(acc, classCount);
+}
+
+void MulticlassPerceptron::toStep(double* acc, int label)
+{
+    for (size_t c = 0; c < classCount; ++c)
+    {
+        const double grad = acc[c] - (static_cast<int>(c) == label ? 1.0 : 0.0);
+        acc[c] = -learningRate * grad;
+        bias[c] += acc[c];
+    }
+    for (size_t c = classCount; c < classStride; ++c) acc[c] = 0.0; // keep padding at 0
+}
+
+void MulticlassPerceptron::train(const SparseVector& inputs, int label)
+{
+    METRIC_ADD(TrainSteps, 1);
+    METRIC_TIME(Train);
+    double* acc = scratchScores(classStride);
+    scoreSparse(inputs, acc);
+    toStep(acc, label);
+    // each non-zero feature moves its whole class row at once
+    kernels::scatterRows(weights.data(), classStride, inputs.indices.data(), inputs.values.data(), inputs.nnz(), acc);
+}
+
+void MulticlassPerceptron::train(const std::vector<double>& inputs, int label)
+{
+    METRIC_ADD(TrainSteps, 1);
+    METRIC_TIME(Train);
+    double* acc = scratchScores(classStride);
+    scoreDense(inputs, acc);
+    toStep(acc, label);
+    const size_t n = std::min(inputs.size(), numInputs);
+    for (size_t f = 0; f < n; ++f)
+        if (inputs[f] != 0.0) kernels::axpy(inputs[f], acc, &weights[f * classStride], classStride);
+}
+
+std::vector<double> MulticlassPerceptron::getWeights(int cls) const
+{
+    std::vector<double> w(numInputs);
+    for (size_t f = 0; f < numInputs; ++f) w[f] = weights[f * classStride + static_cast<size_t>(cls)];
+    return w;
+}
+
+bool MulticlassPerceptron::saveModel(const std::string& filename) const
+{
+    METRIC_TIME(ModelSave);
+    std::ofstream out(filename);
+    if (!out) return false;
+    out.precision(17);
+
+    out << "multiclass " << numInputs << ' ' << classCount << ' ' << learningRate << '\n';
+    for (size_t c = 0; c < classCount; ++c)
+        out << (c < classNames.size() ? classNames[c] : std::string()) << '\n';
+    for (size_t c = 0; c < classCount; ++c) out << bias[c] << ' ';
+    out << '\n';
+    for (size_t f = 0; f < numInputs; ++f)
+    {
+        for (size_t c = 0; c < classCount; ++c) out << weights[f * classStride + c] << ' ';
+        out << '\n';
+    }
+    writeFeatureSection(out, features);
+    return static_cast<bool>(out);
+}
+
+bool MulticlassPerceptron::isMulticlassModelFile(const std::string& filename)
+{
+    std::ifstream in(filename);
+    std::string tag;
+    return (in >> tag) && tag == "multiclass";
+}
+
+bool MulticlassPerceptron::loadModel(const std::string& filename)
+{
+    METRIC_TIME(ModelLoad);
+    std::ifstream in(filename, std::ios::ate);
+    if (!in) return false;
+    const std::streamoff fileSize = in.tellg();
+    in.seekg(0);
+
+    std::string tag;
+    size_t n = 0, classes = 0;
+    double lr = 0.0;
+    in >> tag >> n >> classes >> lr;
+    if (!in || tag != "multiclass" || classes == 0) return false;
+    // the constructor takes ints, and every bias and weight needs at least a
+    // digit and a separator: a header the file cannot back is rejected
+    // before anything is allocated
+    if (n > INT_MAX || classes > INT_MAX || fileSize <= 0) return false;
+    if (n + 1 > static_cast<size_t>(fileSize) / 2 / classes) return false;
+    in.ignore((std::numeric_limits<std::streamsize>::max)(), '\n');
+
+    std::vector<std::string> names(classes);
+    for (auto& name : names)
+    {
+        if (!std::getline(in, name)) return false;
+        if (!name.empty() && name.back() == '\r') name.pop_back();
+    }
+
+    MulticlassPerceptron m(static_cast<int>(n), static_cast<int>(classes), lr);
+    for (size_t c = 0; c < m.classCount && in; ++c) in >> m.bias[c];
+    for (size_t f = 0; f < m.numInputs && in; ++f)
+        for (size_t c = 0; c < m.classCount && in; ++c) in >> m.weights[f * m.classStride + c];
+    if (!in) return false;
+
+    m.features = features;
+    bool hasSection = false;
+    if (!readFeatureSection(in, m.features, hasSection)) return false;
+    if (hasSection && m.features.dimension() != n) return false;
+
+    // drop the names if none were given
+    if (std::all_of(names.begin(), names.end(), [](const std::string& s) { return s.empty(); })) names.clear();
+    m.classNames = std::move(names);
+
+    // commit only once the whole file parsed
+    *this = std::move(m);
+    return true;
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "Dataset.h"
+#include "FeatureConfig.h"
+#include "SparseVector.h"
+
+// Multi-class linear model: one score per class, prediction = argmax.
+//
+// Weights are stored feature-major: row f holds the weights of feature f for
+// every class, padded to a multiple of 8 doubles. Scoring a sparse document is
+// then one axpy per non-zero feature across all classes at once (SIMD over
+// classes), instead of one pass over the features per class.
+//
+// The update is the multi-output form of Perceptron::train: squared loss
+// against a one-hot target, so each non-zero feature moves its whole class
+// row by -lr * x_f * (scores - onehot). With two classes it behaves like two
+// coupled binary perceptrons.
+class MulticlassPerceptron
+{
+public:
+    MulticlassPerceptron(int inputSize, int numClasses, double lr = 0.1);
+
+    size_t inputSize() const { return numInputs; }
+    size_t numClasses() const { return classCount; }
+
+    // scores for every class; out is resized to numClasses()
+    void scores(const SparseVector& inputs, std::vector<double>& out) const;
+    void scores(const std::vector<double>& inputs, std::vector<double>& out) const;
+
+    // index of the highest-scoring class
+    int predict(const SparseVector& inputs) const;
+    int predict(const std::vector<double>& inputs) const;
+
+    // one update towards class `label` (0 <= label < numClasses())
+    void train(const SparseVector& inputs, int label);
+    void train(const std::vector<double>& inputs, int label);
+
+    // weights of one class (copied out of the feature-major matrix)
+    std::vector<double> getWeights(int cls) const;
+    double getBias(int cls) const { return bias[static_cast<size_t>(cls)]; }
+    double getLearningRate() const { return learningRate; }
+
+    // optional display names, one per class (e.g. queue names); saved with the model
+    const std::vector<std::string>& getClassNames() const { return classNames; }
+    void setClassNames(const std::vector<std::string>& names) { classNames = names; }
+
+    const FeatureConfig& getFeatureConfig() const { return features; }
+    void setFeatureConfig(const FeatureConfig& config) { features = config; }
+
+    // Text format:
+    //   multiclass <inputs> <classes> <learningRate>
+    //   <class names, one per line; empty line if unnamed>
+    //   <biases>
+    //   <one line per feature: its weight for every class>
+    //   [features section, see FeatureConfig.h]
+    bool saveModel(const std::string& filename) const;
+    bool loadModel(const std::string& filename);
+
+    // true if filename starts with the "multiclass" tag
+    static bool isMulticlassModelFile(const std::string& filename);
+
+private:
+    using AlignedVector = std::vector<double, AlignedAllocator<double, 64>>;
+
+    // bias + all class scores into acc (classStride entries, padding stays 0)
+    void scoreSparse(const SparseVector& inputs, double* acc) const;
+    void scoreDense(const std::vector<double>& inputs, double* acc) const;
+    // turn class scores in acc into the per-class step -lr * (score - onehot)
+    // and apply it to the biases
+    void toStep(double* acc, int label);
+
+    size_t numInputs;
+    size_t classCount;
+    size_t classStride;            // classCount rounded up to 8
+    double learningRate;
+    AlignedVector weights;         // numInputs x classStride, feature-major
+    AlignedVector bias;            // classStride
+    std::vector<std::string> classNames;
+    FeatureConfig features;
+};
@@ -1,9 +1,17 @@
 ﻿#include "Perceptron.h"
+#include "VectorKernels.h"
+#include "ModelFormat.h"
+#include "Metrics.h"
+#include "Quantization.h"
 #include <cstdlib>
 #include <ctime>
 #include <fstream>
+#include <numeric>
+#include <random>
+#include <algorithm>
 
-Perceptron::Perceptron(int inputSize, double lr)
+Perceptron::Perceptron(int inputSize, double lr, WeightPrecision precision)
+    : precision(precision)
 {
     // seed BEFORE generating random values
     std::srand(static_cast<unsigned>(std::time(nullptr)));
@@ -14,6 +22,29 @@ Perceptron::Perceptron(int inputSize, double lr)
     weights.resize(static_cast<size_t>(inputSize));
     for (int i = 0; i < inputSize; ++i)
         weights[static_cast<size_t>(i)] = (static_cast<double>(std::rand()) / RAND_MAX) - 0.5;
+
+    if (precision == WeightPrecision::Float)
+    {
+        weights32.assign(weights.begin(), weights.end());
+        weights.clear();
+        weights.shrink_to_fit();
+    }
+}
+
+std::vector<double> Perceptron::getWeights() const
+{
+    if (precision == WeightPrecision::Float)
+        return std::vector<double>(weights32.begin(), weights32.end());
+    return weights;
+}
+
+void Perceptron::setParameters(const std::vector<double>& w, double b)
+{
+    if (precision == WeightPrecision::Float)
+        weights32.assign(w.begin(), w.end());
+    else
+        weights = w;
+    bias = b;
 }
 
 int Perceptron::activate(double sum)
@@ -23,9 +54,12 @@ int Perceptron::activate(double sum)
 
 double Perceptron::score(const std::vector<double>& inputs) const
 {
-    double s = 0.0;
-    for (size_t i = 0; i < weights.size(); ++i)
-        s += weights[i] * inputs[i];
+    METRIC_ADD(Scores, 1);
+    METRIC_TIME(Score);
+    // SIMD dot product (see VectorKernels.h)
+    double s = (precision == WeightPrecision::Float)
+        ? kernels::dot(weights32.data(), inputs.data(), weights32.size())
+        : kernels::dot(weights.data(), inputs.data(), weights.size());
     s += bias;
     return s;
 }
@@ -35,41 +69,238 @@ int Perceptron::predict(const std::vector<double>& inputs)
     return activate(score(inputs));
 }
 
-void Perceptron::train(const std::vector<double>& inputs, int expectedOutput)
+double Perceptron::train(const std::vector<double>& inputs, int expectedOutput)
 {
+    METRIC_ADD(TrainSteps, 1);
+    METRIC_TIME(Train);
     double yHat = score(inputs); // raw output before threshold
     double grad = yHat - expectedOutput; // derivative of loss w.r.t output
 
-    // update weights using gradient
-    for (size_t i = 0; i < weights.size(); ++i)
-        weights[i] -= learningRate * grad * inputs[i]; // subtract gradient * LR
+    // update weights using gradient: w -= LR * grad * x, as one fused axpy
+    if (precision == WeightPrecision::Float)
+        kernels::axpy(-learningRate * grad, inputs.data(), weights32.data(), weights32.size());
+    else
+        kernels::axpy(-learningRate * grad, inputs.data(), weights.data(), weights.size());
 
     // update bias
     bias -= learningRate * grad;
+    return 0.5 * grad * grad;
 }
 
+double Perceptron::score(const SparseVector& inputs) const
+{
+    METRIC_ADD(Scores, 1);
+    METRIC_TIME(Score);
+    const size_t n = inputs.nnz();
+    const uint32_t* idx = inputs.indices.data();
+    const double* val = inputs.values.data();
+
+    double s = 0.0;
+    if (precision == WeightPrecision::Float)
+    {
+        for (size_t k = 0; k < n; ++k) s += weights32[idx[k]] * val[k];
+    }
+    else
+    {
+        for (size_t k = 0; k < n; ++k) s += weights[idx[k]] * val[k];
+    }
+    s += bias;
+    return s;
+}
+
+int Perceptron::predict(const SparseVector& inputs)
+{
+    return activate(score(inputs));
+}
+
+double Perceptron::train(const SparseVector& inputs, int expectedOutput)
+{
+    METRIC_ADD(TrainSteps, 1);
+    METRIC_TIME(Train);
+    double yHat = score(inputs);
+    double grad = yHat - expectedOutput;
+
+    // zero features have a zero gradient, so only the non-zeros move
+    const double step = -learningRate * grad;
+    const size_t n = inputs.nnz();
+    if (precision == WeightPrecision::Float)
+    {
+        for (size_t k = 0; k < n; ++k)
+            weights32[inputs.indices[k]] += static_cast<float>(step * inputs.values[k]);
+    }
+    else
+    {
+        for (size_t k = 0; k < n; ++k)
+            weights[inputs.indices[k]] += step * inputs.values[k];
+    }
+
+    bias -= learningRate * grad;
+    return 0.5 * grad * grad;
+}
 
 bool Perceptron::saveModel(const std::string& filename) const
 {
+    METRIC_TIME(ModelSave);
     std::ofstream out(filename);
     if (!out) return false;
 
-    out << weights.size() << ' ' << learningRate << ' ' << bias << '\n';
-    for (double w : weights) out << w << ' ';
+    out << inputSize() << ' ' << learningRate << ' ' << bias << '\n';
+    for (double w : getWeights()) out << w << ' ';
     out << '\n';
-    return true;
+
+    // optional trailing section describing the feature extractor
+    writeFeatureSection(out, features);
+    return static_cast<bool>(out);
+}
+
+double Perceptron::trainBatch(const Dataset& data, const size_t* rows, size_t count)
+{
+    if (count == 0) return 0.0;
+    METRIC_ADD(TrainSteps, count);
+    METRIC_TIME(Train);
+    const size_t n = inputSize();
+
+    thread_local std::vector<const double*> rowPtr;
+    thread_local std::vector<double> residual;
+    rowPtr.resize(count);
+    residual.resize(count);
+    for (size_t j = 0; j < count; ++j) rowPtr[j] = data.row(rows[j]);
+
+    // 1) residuals r_j = w.x_j + b - y_j for the whole batch (GEMV)
+    if (precision == WeightPrecision::Float)
+    {
+        for (size_t j = 0; j < count; ++j)
+            residual[j] = kernels::dot(weights32.data(), rowPtr[j], n);
+    }
+    else
+    {
+        kernels::dotRows(rowPtr.data(), count, weights.data(), n, residual.data());
+    }
+    double loss = 0.0, residualSum = 0.0;
+    for (size_t j = 0; j < count; ++j)
+    {
+        residual[j] += bias - data.label(rows[j]);
+        loss += 0.5 * residual[j] * residual[j];
+        residualSum += residual[j];
+    }
+
+    // 2) w -= lr/count * X^T r (transposed GEMV)
+    const double step = -learningRate / static_cast<double>(count);
+    if (precision == WeightPrecision::Float)
+    {
+        thread_local std::vector<double> grad;
+        grad.assign(n, 0.0);
+        kernels::axpyRows(residual.data(), rowPtr.data(), count, grad.data(), n);
+        kernels::axpy(step, grad.data(), weights32.data(), n);
+    }
+    else
+    {
+        for (size_t j = 0; j < count; ++j) residual[j] *= step;
+        kernels::axpyRows(residual.data(), rowPtr.data(), count, weights.data(), n);
+    }
+    bias += step * residualSum;
+    return loss;
+}
+
+double Perceptron::fit(const Dataset& data, const FitOptions& options)
+{
+    std::vector<size_t> order(data.rows());
+    std::iota(order.begin(), order.end(), static_cast<size_t>(0));
+    std::mt19937 rng(options.seed);
+    const size_t batch = (std::max)(static_cast<size_t>(1), options.batchSize);
+
+    double epochLoss = 0.0;
+    for (int e = 0; e < options.epochs; ++e)
+    {
+        if (options.shuffle) std::shuffle(order.begin(), order.end(), rng);
+
+        epochLoss = 0.0;
+        for (size_t start = 0; start < order.size(); start += batch)
+        {
+            const size_t count = (std::min)(batch, order.size() - start);
+            epochLoss += trainBatch(data, order.data() + start, count);
+        }
+    }
+    return order.empty() ? 0.0 : epochLoss / static_cast<double>(order.size());
+}
+
+bool Perceptron::saveModelBinary(const std::string& filename) const
+{
+    METRIC_TIME(ModelSave);
+    if (precision == WeightPrecision::Float)
+        return writeModelFile(filename, weights32.data(), weights32.size(), ModelWeightType::Float32,
+            learningRate, bias, features);
+    return writeModelFile(filename, weights.data(), weights.size(), ModelWeightType::Float64,
+        learningRate, bias, features);
+}
+
+bool Perceptron::saveModelQuantized(const std::string& filename) const
+{
+    METRIC_TIME(ModelSave);
+    const std::vector<double> w = getWeights();
+    std::vector<int8_t> q(w.size());
+    const float scale = quantizeWeights(w.data(), w.size(), q.data());
+    return writeQuantizedModelFile(filename, q.data(), q.size(), scale, learningRate, bias, features);
 }
 
 bool Perceptron::loadModel(const std::string& filename)
 {
+    if (isBinaryModelFile(filename))
+    {
+        MappedModel model;
+        if (!model.open(filename, nullptr, /*verifyWeights=*/true)) return false;
+
+        learningRate = model.getLearningRate();
+        bias = model.getBias();
+        if (model.getFeatureConfig().dimension() == model.dimension())
+            features = model.getFeatureConfig();
+        if (precision == WeightPrecision::Float && model.weightType() == ModelWeightType::Float32)
+        {
+            const float* w = static_cast<const float*>(model.weightData());
+            weights32.assign(w, w + model.dimension());
+        }
+        else if (precision == WeightPrecision::Float)
+        {
+            auto w = model.getWeights();
+            weights32.assign(w.begin(), w.end());
+        }
+        else
+        {
+            weights = model.getWeights();
+        }
+        return true;
+    }
+
+    METRIC_TIME(ModelLoad); // the binary branch is timed by MappedModel::open
     std::ifstream in(filename);
     if (!in) return false;
 
     size_t n = 0;
-    in >> n >> learningRate >> bias;
+    double lr = 0.0, b = 0.0;
+    in >> n >> lr >> b;
+    if (!in) return false;
+
+    std::vector<double> w(n, 0.0);
+    for (size_t i = 0; i < n; ++i) in >> w[i];
     if (!in) return false;
 
-    weights.assign(n, 0.0);
-    for (size_t i = 0; i < n; ++i) in >> weights[i];
-    return static_cast<bool>(in);
+    FeatureConfig config = features;
+    bool hasSection = false;
+    if (!readFeatureSection(in, config, hasSection)) return false;
+    if (hasSection && config.dimension() != n) return false;
+
+    // commit only once the whole file parsed
+    learningRate = lr;
+    bias = b;
+    features = std::move(config);
+    if (precision == WeightPrecision::Float)
+    {
+        weights32.assign(w.begin(), w.end());
+        weights.clear();
+    }
+    else
+    {
+        weights = std::move(w);
+    }
+    return true;
 }
@@ -2,17 +2,37 @@
 #include <vector>
 #include <string>
 #include <iostream>
+#include "SparseVector.h"
+#include "FeatureConfig.h"
+#include "Dataset.h"
+
+// Storage type for the weight vector. Float halves memory traffic and doubles
+// the SIMD width of score/train, at float precision.
+enum class WeightPrecision { Double, Float };
+
+// Options for Perceptron::fit
+struct FitOptions
+{
+    int epochs = 10;
+    size_t batchSize = 1;     // samples per update; 1 = plain per-sample training
+    bool shuffle = true;      // reshuffle sample order every epoch
+    unsigned seed = 0;        // shuffle seed (same seed -> same order)
+};
 
 class Perceptron
 {
 private:
-    std::vector<double> weights;   // weights for each input
+    std::vector<double> weights;   // weights for each input (Double mode)
+    std::vector<float> weights32;  // weights for each input (Float mode)
+    WeightPrecision precision;
     double learningRate;           // step size for weight updates
     double bias;                   // bias term
+    FeatureConfig features;        // how inputs are extracted; saved with the model
 
 public:
     // Constructor: number of inputs and learning rate
-    Perceptron(int inputSize, double lr = 0.1);
+    Perceptron(int inputSize, double lr = 0.1,
+        WeightPrecision precision = WeightPrecision::Double);
 
     // Activation function (step function)
     int activate(double sum);
@@ -20,17 +40,57 @@ public:
     // Feedforward: compute output for given inputs
     int predict(const std::vector<double>& inputs);
 
-    // Train on a single sample
-    void train(const std::vector<double>& inputs, int expectedOutput);
+    // Train on a single sample. Returns its loss 0.5*(score-y)^2 measured
+    // before the update, so callers tracking the loss need not score again.
+    double train(const std::vector<double>& inputs, int expectedOutput);
 
     // (Optional) raw score (weighted sum + bias), useful for debugging
     double score(const std::vector<double>& inputs) const;
 
+    // Sparse versions: only the non-zero features are touched, so the cost is
+    // O(nnz) instead of O(inputSize). Indices must be < inputSize().
+    int predict(const SparseVector& inputs);
+    double train(const SparseVector& inputs, int expectedOutput);
+    double score(const SparseVector& inputs) const;
+
+    // One mini-batch step over the given rows of data: the squared-loss
+    // gradient is averaged over the batch and applied once. With a single row
+    // this is exactly train(). Returns the batch's summed loss 0.5*(score-y)^2
+    // measured before the update.
+    double trainBatch(const Dataset& data, const size_t* rows, size_t count);
+
+    // Run options.epochs epochs of mini-batch training over data.
+    // Returns the mean loss of the last epoch (measured before each update).
+    double fit(const Dataset& data, const FitOptions& options = FitOptions());
+
     // Accessors
-    std::vector<double> getWeights() const { return weights; }
+    std::vector<double> getWeights() const;
+    double getWeight(size_t i) const { return precision == WeightPrecision::Float ? weights32[i] : weights[i]; }
     double getBias() const { return bias; }
+    double getLearningRate() const { return learningRate; }
+    size_t inputSize() const { return precision == WeightPrecision::Float ? weights32.size() : weights.size(); }
+    WeightPrecision getPrecision() const { return precision; }
+
+    // Replace weights and bias (e.g. with the result of an external trainer).
+    // w.size() must equal inputSize(); in Float mode the values are rounded.
+    void setParameters(const std::vector<double>& w, double b);
+
+    // Feature extraction settings (keyword list or hashing params) stored in
+    // the model file, so serving can rebuild the exact same extractor.
+    const FeatureConfig& getFeatureConfig() const { return features; }
+    void setFeatureConfig(const FeatureConfig& config) { features = config; }
 
-    // Persist model
+    // Persist model. loadModel keeps the current FeatureConfig when the file
+    // has no features section (models saved before it existed).
     bool saveModel(const std::string& filename) const;
     bool loadModel(const std::string& filename);
+
+    // Versioned, checksummed binary format (ModelFormat.h). Lossless and much
+    // faster than the text format; loadModel detects it automatically.
+    bool saveModelBinary(const std::string& filename) const;
+
+    // Int8 export for serving (Quantization.h): one scale for the whole weight
+    // vector, 1 byte per weight. MappedModel scores it in place; loadModel
+    // reads it back dequantized.
+    bool saveModelQuantized(const std::string& filename) const;
 };
\ No newline at end of file
@@ -0,0 +1,320 @@
+// Headless command-line classifier (portable, no windows.h).
+//
+//   perceptron-cli --model spam.bin [--manifest files.txt] [--format tsv|jsonl]
+//                  [--threads N] [--chunk N] [--keywords FILE] [--cache FILE]
+//                  [--metrics FILE]
+//
+// Loads the model once, reads one path per line from the manifest (or stdin;
+// only the first tab-separated field is used, so training manifests work as
+// is) and writes one result per path, in input order. Paths are processed in
+// chunks: while the pool extracts chunk k, the main thread writes chunk k-1.
+// --keywords (one keyword per line) is only needed for old text models that
+// were saved without their feature config. --cache keeps extracted features
+// on disk (FeatureCache) so reruns over unchanged files skip parsing.
+// --metrics writes counters and latency percentiles at exit (Prometheus text
+// format if FILE ends in .prom, JSON otherwise).
+#include "BoundedQueue.h"
+#include "Classifier.h"
+#include "FeatureCache.h"
+#include "Featurizer.h"
+#include "Metrics.h"
+#include "ThreadPool.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    enum class OutputFormat { Tsv, Jsonl };
+
+    struct CliOptions
+    {
+        std::string modelPath;
+        std::string manifestPath;     // empty = stdin
+        std::string keywordsPath;     // fallback keyword list
+        std::string cachePath;        // feature cache; empty = none
+        std::string metricsPath;      // metrics snapshot at exit; empty = none
+        OutputFormat format = OutputFormat::Tsv;
+        unsigned threads = 0;
+        size_t chunk = 1024;          // paths per pipeline stage
+    };
+
+    struct Result
+    {
+        std::string path;
+        int label = 0;
+        double score = 0.0;           // binary: raw score; multi-class: winning class score
+        std::string error;            // empty = ok
+    };
+
+    using Chunk = std::vector<Result>;
+
+    void usage()
+    {
+        std::fprintf(stderr,
+            "usage: perceptron-cli --model FILE [--manifest FILE] [--format tsv|jsonl]\n"
+            "                      [--threads N] [--chunk N] [--keywords FILE] [--cache FILE]\n"
+            "                      [--metrics FILE.json|FILE.prom]\n"
+            "Reads file paths (one per line) from the manifest or stdin and prints\n"
+            "path, label and score for each, in input order.\n");
+    }
+
+    bool parseArgs(int argc, char** argv, CliOptions& opt)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string arg = argv[i];
+            const bool hasValue = i + 1 < argc;
+            if (arg == "--model" && hasValue) opt.modelPath = argv[++i];
+            else if (arg == "--manifest" && hasValue) opt.manifestPath = argv[++i];
+            else if (arg == "--keywords" && hasValue) opt.keywordsPath = argv[++i];
+            else if (arg == "--cache" && hasValue) opt.cachePath = argv[++i];
+            else if (arg == "--metrics" && hasValue) opt.metricsPath = argv[++i];
+            else if (arg == "--format" && hasValue)
+            {
+                const std::string f = argv[++i];
+                if (f == "tsv") opt.format = OutputFormat::Tsv;
+                else if (f == "jsonl") opt.format = OutputFormat::Jsonl;
+                else return false;
+            }
+            else if (arg == "--threads" && hasValue) opt.threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+            else if (arg == "--chunk" && hasValue) opt.chunk = std::strtoul(argv[++i], nullptr, 10);
+            else return false;
+        }
+        if (opt.chunk == 0) opt.chunk = 1;
+        return !opt.modelPath.empty();
+    }
+
+    void setPrediction(Result& r, const Prediction& p)
+    {
+        r.label = p.label;
+        r.score = p.score;
+    }
+
+    // minimal JSON string escaping
+    void appendJsonString(std::string& out, const std::string& s)
+    {
+        out += '"';
+        for (unsigned char c : s)
+        {
+            switch (c)
+            {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (c < 0x20)
+                {
+                    char buf[8];
+                    std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    out += buf;
+                }
+                else out += static_cast<char>(c);
+            }
+        }
+        out += '"';
+    }
+
+    void formatResult(std::string& out, const Result& r, const std::string& label, OutputFormat format)
+    {
+        char num[32];
+        std::snprintf(num, sizeof(num), "%.9g", r.score);
+
+        if (format == OutputFormat::Tsv)
+        {
+            out += r.path;
+            if (r.error.empty())
+            {
+                out += '\t'; out += label;
+                out += '\t'; out += num;
+            }
+            else
+            {
+                out += "\terror\t";
+                out += r.error;
+            }
+            out += '\n';
+            return;
+        }
+
+        out += "{\"path\":";
+        appendJsonString(out, r.path);
+        if (r.error.empty())
+        {
+            out += ",\"label\":";
+            if (label.find_first_not_of("0123456789") == std::string::npos) out += label;
+            else appendJsonString(out, label);
+            out += ",\"score\":"; out += num;
+        }
+        else
+        {
+            out += ",\"error\":";
+            appendJsonString(out, r.error);
+        }
+        out += "}\n";
+    }
+
+    bool readPath(std::istream& in, std::string& path)
+    {
+        std::string line;
+        while (std::getline(in, line))
+        {
+            const size_t tab = line.find('\t');
+            if (tab != std::string::npos) line.resize(tab);
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (line.empty()) continue;
+            path = std::move(line);
+            return true;
+        }
+        return false;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    CliOptions opt;
+    if (!parseArgs(argc, argv, opt))
+    {
+        usage();
+        return 1;
+    }
+
+    FeatureConfig fallback;
+    if (!opt.keywordsPath.empty())
+    {
+        std::ifstream kw(opt.keywordsPath);
+        if (!kw)
+        {
+            std::fprintf(stderr, "perceptron-cli: cannot open keyword list '%s'\n", opt.keywordsPath.c_str());
+            return 1;
+        }
+        std::vector<std::string> keywords;
+        std::string line;
+        while (std::getline(kw, line))
+        {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (!line.empty()) keywords.push_back(line);
+        }
+        fallback = FeatureConfig::forKeywords(std::move(keywords));
+    }
+
+    Classifier model;
+    std::string error;
+    if (!model.load(opt.modelPath, fallback, error))
+    {
+        std::fprintf(stderr, "perceptron-cli: %s\n", error.c_str());
+        return 1;
+    }
+    if (model.getFeaturizer().dimension() != model.dimension())
+    {
+        std::fprintf(stderr, "perceptron-cli: model '%s' has no feature config matching its %zu weights"
+            " (pass --keywords)\n",
+            opt.modelPath.c_str(), model.dimension());
+        return 1;
+    }
+
+    std::ios::sync_with_stdio(false);
+    std::ifstream manifest;
+    if (!opt.manifestPath.empty())
+    {
+        manifest.open(opt.manifestPath);
+        if (!manifest)
+        {
+            std::fprintf(stderr, "perceptron-cli: cannot open manifest '%s'\n", opt.manifestPath.c_str());
+            return 1;
+        }
+    }
+    std::istream& in = opt.manifestPath.empty() ? std::cin : manifest;
+
+    FeatureCache cache;
+    if (!opt.cachePath.empty() && !cache.open(opt.cachePath, model.getFeaturizer().getConfig(), &error))
+        std::fprintf(stderr, "perceptron-cli: ignoring feature cache: %s\n", error.c_str());
+    FeatureCache* cachePtr = opt.cachePath.empty() ? nullptr : &cache;
+
+    ThreadPool pool(opt.threads);
+    BoundedQueue<Chunk> queue(2);   // extracted chunks waiting to be written
+    const Featurizer& featurizer = model.getFeaturizer();
+
+    // stage 1: read paths and extract + score one chunk at a time
+    std::thread producer([&] {
+        std::string path;
+        bool more = true;
+        while (more)
+        {
+            Chunk chunk;
+            chunk.reserve(opt.chunk);
+            while (chunk.size() < opt.chunk && (more = readPath(in, path)))
+            {
+                chunk.emplace_back();
+                chunk.back().path = std::move(path);
+            }
+            if (chunk.empty()) break;
+
+            pool.parallelFor(chunk.size(), [&](size_t i) {
+                thread_local Featurizer::Scratch scratch;
+                thread_local SparseVector features;
+                Result& r = chunk[i];
+                try
+                {
+                    FileStamp stamp;
+                    if (cachePtr && cachePtr->lookup(r.path, features, stamp))
+                        setPrediction(r, model.classify(features));
+                    else if (featurizer.extractFile(r.path, features, scratch, r.error))
+                    {
+                        setPrediction(r, model.classify(features));
+                        if (cachePtr) cachePtr->insert(r.path, stamp, features);
+                    }
+                }
+                catch (const std::exception& ex)
+                {
+                    r.error = ex.what();
+                }
+            });
+            queue.push(std::move(chunk));
+        }
+        queue.close();
+    });
+
+    // stage 2: format and write, in input order
+    size_t total = 0, failed = 0;
+    Chunk chunk;
+    std::string out;
+    while (queue.pop(chunk))
+    {
+        out.clear();
+        for (const auto& r : chunk)
+        {
+            formatResult(out, r, r.error.empty() ? model.labelName(r.label) : std::string(), opt.format);
+            if (!r.error.empty()) ++failed;
+        }
+        total += chunk.size();
+        std::fwrite(out.data(), 1, out.size(), stdout);
+    }
+    producer.join();
+    std::fflush(stdout);
+
+    if (cachePtr)
+    {
+        std::fprintf(stderr, "perceptron-cli: feature cache %zu hits, %zu misses\n", cache.hits(), cache.misses());
+        if (cache.misses() && !cache.save(&error))
+            std::fprintf(stderr, "perceptron-cli: cannot save feature cache: %s\n", error.c_str());
+    }
+
+    if (!opt.metricsPath.empty())
+    {
+        const std::string& m = opt.metricsPath;
+        const bool prom = m.size() >= 5 && m.compare(m.size() - 5, 5, ".prom") == 0;
+        if (!metrics::writeSnapshot(m, prom ? metrics::Format::Prometheus : metrics::Format::Json, &error))
+            std::fprintf(stderr, "perceptron-cli: cannot write metrics: %s\n", error.c_str());
+    }
+
+    if (failed)
+        std::fprintf(stderr, "perceptron-cli: %zu of %zu files could not be read\n", failed, total);
+    return failed ? 2 : 0;
+}
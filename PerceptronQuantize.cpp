@@ -0,0 +1,218 @@
+// Exports a trained model as an int8 model and measures what quantization
+// costs on a held-out set.
+//
+//   perceptron-quantize --model spam.bin --out spam.q8.bin
+//                       [--eval heldout.txt] [--threads N]
+//
+// --eval takes a training-style manifest ("path<TAB>label" per line). Every
+// document is scored by both models; the report gives each model's accuracy,
+// the accuracy delta, how often the two predictions agree, the score error and
+// the scoring time per document. Documents are extracted and scored in chunks,
+// so the held-out set does not have to fit in memory.
+#include "Featurizer.h"
+#include "ModelFormat.h"
+#include "Perceptron.h"
+#include "StreamingTrainer.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace
+{
+    struct Options
+    {
+        std::string modelPath;
+        std::string outPath;
+        std::string evalPath;      // empty = export only
+        unsigned threads = 0;
+    };
+
+    void usage()
+    {
+        std::fprintf(stderr,
+            "usage: perceptron-quantize --model FILE --out FILE [--eval MANIFEST] [--threads N]\n"
+            "Writes an int8 copy of the model. With --eval, compares both models on a\n"
+            "'path<TAB>label' manifest.\n");
+    }
+
+    bool parseArgs(int argc, char** argv, Options& opt)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string arg = argv[i];
+            const bool hasValue = i + 1 < argc;
+            if (arg == "--model" && hasValue) opt.modelPath = argv[++i];
+            else if (arg == "--out" && hasValue) opt.outPath = argv[++i];
+            else if (arg == "--eval" && hasValue) opt.evalPath = argv[++i];
+            else if (arg == "--threads" && hasValue) opt.threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+            else return false;
+        }
+        return !opt.modelPath.empty() && !opt.outPath.empty();
+    }
+
+    struct EvalStats
+    {
+        size_t documents = 0;
+        size_t skipped = 0;
+        size_t correctFloat = 0;
+        size_t correctInt8 = 0;
+        size_t agree = 0;
+        double sumAbsError = 0.0;
+        double maxAbsError = 0.0;
+        double floatNs = 0.0;       // total scoring time
+        double int8Ns = 0.0;
+    };
+
+    struct Doc
+    {
+        std::string path;
+        int label = 0;
+        SparseVector features;
+        bool ok = false;
+    };
+
+    // time fn(doc) over every readable document in the chunk
+    template <class Fn>
+    double timeScoring(const std::vector<Doc>& docs, std::vector<double>& scores, Fn&& fn)
+    {
+        const auto t0 = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < docs.size(); ++i)
+            if (docs[i].ok) scores[i] = fn(docs[i].features);
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+    }
+
+    bool evaluate(const Perceptron& full, const MappedModel& quantized, const std::string& manifest,
+        unsigned threads, EvalStats& stats, std::string& error)
+    {
+        ManifestReader reader;
+        if (!reader.open(manifest, &error)) return false;
+
+        const Featurizer featurizer(full.getFeatureConfig());
+        ThreadPool pool(threads);
+        const size_t chunkSize = 4096;
+        std::vector<Doc> docs;
+        std::vector<double> floatScores, int8Scores;
+        std::string path, problem;
+        int label = 0;
+        bool more = true;
+        while (more)
+        {
+            docs.clear();
+            while (docs.size() < chunkSize && (more = reader.next(path, label, problem)))
+            {
+                if (!problem.empty())
+                {
+                    ++stats.skipped;
+                    continue;
+                }
+                docs.emplace_back();
+                docs.back().path = path;
+                docs.back().label = label;
+            }
+            if (docs.empty()) break;
+
+            pool.parallelFor(docs.size(), [&](size_t i) {
+                thread_local Featurizer::Scratch scratch;
+                std::string readError;
+                docs[i].ok = featurizer.extractFile(docs[i].path, docs[i].features, scratch, readError);
+            });
+
+            floatScores.assign(docs.size(), 0.0);
+            int8Scores.assign(docs.size(), 0.0);
+            stats.floatNs += timeScoring(docs, floatScores, [&](const SparseVector& x) { return full.score(x); });
+            stats.int8Ns += timeScoring(docs, int8Scores, [&](const SparseVector& x) { return quantized.score(x); });
+
+            for (size_t i = 0; i < docs.size(); ++i)
+            {
+                if (!docs[i].ok)
+                {
+                    ++stats.skipped;
+                    continue;
+                }
+                const int pf = floatScores[i] >= 0.0 ? 1 : 0;
+                const int pq = int8Scores[i] >= 0.0 ? 1 : 0;
+                const double err = std::fabs(floatScores[i] - int8Scores[i]);
+                ++stats.documents;
+                stats.correctFloat += pf == docs[i].label;
+                stats.correctInt8 += pq == docs[i].label;
+                stats.agree += pf == pq;
+                stats.sumAbsError += err;
+                stats.maxAbsError = (std::max)(stats.maxAbsError, err);
+            }
+        }
+        return true;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options opt;
+    if (!parseArgs(argc, argv, opt))
+    {
+        usage();
+        return 1;
+    }
+
+    Perceptron full(0);
+    if (!full.loadModel(opt.modelPath))
+    {
+        std::fprintf(stderr, "perceptron-quantize: cannot load model '%s'\n", opt.modelPath.c_str());
+        return 1;
+    }
+    if (!full.saveModelQuantized(opt.outPath))
+    {
+        std::fprintf(stderr, "perceptron-quantize: cannot write '%s'\n", opt.outPath.c_str());
+        return 1;
+    }
+
+    MappedModel quantized;
+    std::string error;
+    if (!quantized.open(opt.outPath, &error, /*verifyWeights=*/true))
+    {
+        std::fprintf(stderr, "perceptron-quantize: %s\n", error.c_str());
+        return 1;
+    }
+
+    const size_t n = full.inputSize();
+    std::printf("weights          %zu\n", n);
+    std::printf("weight bytes     %zu -> %zu\n", n * sizeof(double), n);
+    std::printf("weight scale     %.9g\n", quantized.weightScale());
+    if (opt.evalPath.empty()) return 0;
+
+    if (full.getFeatureConfig().dimension() != n)
+    {
+        std::fprintf(stderr, "perceptron-quantize: model '%s' has no feature config; cannot evaluate\n",
+            opt.modelPath.c_str());
+        return 1;
+    }
+
+    EvalStats stats;
+    if (!evaluate(full, quantized, opt.evalPath, opt.threads, stats, error))
+    {
+        std::fprintf(stderr, "perceptron-quantize: %s\n", error.c_str());
+        return 1;
+    }
+    if (stats.documents == 0)
+    {
+        std::fprintf(stderr, "perceptron-quantize: no readable documents in '%s'\n", opt.evalPath.c_str());
+        return 1;
+    }
+
+    const double docs = static_cast<double>(stats.documents);
+    const double accFloat = stats.correctFloat / docs;
+    const double accInt8 = stats.correctInt8 / docs;
+    std::printf("documents        %zu (%zu skipped)\n", stats.documents, stats.skipped);
+    std::printf("accuracy float   %.4f\n", accFloat);
+    std::printf("accuracy int8    %.4f\n", accInt8);
+    std::printf("accuracy delta   %+.4f\n", accInt8 - accFloat);
+    std::printf("agreement        %.4f\n", stats.agree / docs);
+    std::printf("score error      mean %.3g, max %.3g\n", stats.sumAbsError / docs, stats.maxAbsError);
+    std::printf("ns/doc float     %.1f\n", stats.floatNs / docs);
+    std::printf("ns/doc int8      %.1f\n", stats.int8Ns / docs);
+    return 0;
+}
@@ -0,0 +1,253 @@
+// k-fold cross-validation over a grid of learning rates, epoch counts and
+// training modes.
+//
+//   perceptron-search --manifest train.txt [--folds K] [--rates 0.001,0.01,0.1]
+//                     [--epochs 5,10,20] [--modes sgd,averaged,ls] [--ridges 1e-3]
+//                     [--model FILE | --hash-bits N] [--threads N] [--seed N]
+//                     [--format tsv|jsonl] [--ingest auto|io_uring|threads]
+//
+// The manifest ("path<TAB>label" per line) is extracted once; every
+// configuration is then trained and scored on the same in-memory features
+// (CrossValidation.h), all (configuration, fold) runs in parallel. Features
+// come from --model (its saved feature config), --hash-bits, or the default
+// keyword set; ls configurations are skipped when there are more than
+// kMaxLeastSquaresDimension features (e.g. hashing). Documents are read
+// through CorpusIngest (io_uring where available). Results are printed best
+// first: mean accuracy over the folds and its spread, precision/recall/F1 of
+// the pooled held-out predictions, and the time the configuration took across
+// all folds.
+#include "CrossValidation.h"
+#include "DefaultKeywords.h"
+#include "Featurizer.h"
+#include "LeastSquares.h"
+#include "Perceptron.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    enum class OutputFormat { Tsv, Jsonl };
+
+    struct SearchOptions
+    {
+        std::string manifestPath;
+        std::string modelPath;        // feature config source; empty = default keywords
+        unsigned hashBits = 0;        // > 0: hashing features instead
+        SearchGrid grid;
+        CrossValidationOptions cv;
+        unsigned threads = 0;
+        OutputFormat format = OutputFormat::Tsv;
+        IngestOptions ingest;
+    };
+
+    void usage()
+    {
+        std::fprintf(stderr,
+            "usage: perceptron-search --manifest FILE [--folds K] [--rates LIST] [--epochs LIST]\n"
+            "                         [--modes sgd,averaged,ls] [--ridges LIST]\n"
+            "                         [--model FILE | --hash-bits N] [--threads N] [--seed N]\n"
+            "                         [--format tsv|jsonl] [--ingest auto|io_uring|threads]\n"
+            "Cross-validates every combination of mode, learning rate and epoch count on a\n"
+            "'path<TAB>label' manifest; LIST is comma-separated. --hash-bits takes 1..%u;\n"
+            "ls is skipped when there are more than %zu features.\n", kMaxHashBits, kMaxLeastSquaresDimension);
+    }
+
+    template <class T, class Parse>
+    bool parseList(const std::string& text, std::vector<T>& out, Parse parse)
+    {
+        out.clear();
+        std::stringstream in(text);
+        std::string item;
+        while (std::getline(in, item, ','))
+        {
+            T value;
+            if (item.empty() || !parse(item, value)) return false;
+            out.push_back(value);
+        }
+        return !out.empty();
+    }
+
+    bool parseNumber(const std::string& s, double& v)
+    {
+        char* end = nullptr;
+        v = std::strtod(s.c_str(), &end);
+        return *end == '\0';
+    }
+
+    bool parseInt(const std::string& s, int& v)
+    {
+        char* end = nullptr;
+        v = static_cast<int>(std::strtol(s.c_str(), &end, 10));
+        return *end == '\0' && v >= 0;
+    }
+
+    bool parseArgs(int argc, char** argv, SearchOptions& opt)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string arg = argv[i];
+            const bool hasValue = i + 1 < argc;
+            if (arg == "--manifest" && hasValue) opt.manifestPath = argv[++i];
+            else if (arg == "--model" && hasValue) opt.modelPath = argv[++i];
+            else if (arg == "--hash-bits" && hasValue)
+            {
+                char* end = nullptr;
+                const unsigned long bits = std::strtoul(argv[++i], &end, 10);
+                if (*end != '\0' || bits == 0 || bits > kMaxHashBits) return false;
+                opt.hashBits = static_cast<unsigned>(bits);
+            }
+            else if (arg == "--folds" && hasValue) opt.cv.folds = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+            else if (arg == "--seed" && hasValue) opt.cv.seed = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+            else if (arg == "--threads" && hasValue) opt.threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+            else if (arg == "--rates" && hasValue)
+            {
+                if (!parseList(argv[++i], opt.grid.learningRates, parseNumber)) return false;
+            }
+            else if (arg == "--ridges" && hasValue)
+            {
+                if (!parseList(argv[++i], opt.grid.ridges, parseNumber)) return false;
+            }
+            else if (arg == "--epochs" && hasValue)
+            {
+                if (!parseList(argv[++i], opt.grid.epochs, parseInt)) return false;
+            }
+            else if (arg == "--modes" && hasValue)
+            {
+                if (!parseList(argv[++i], opt.grid.modes, parseTrainingMode)) return false;
+            }
+            else if (arg == "--ingest" && hasValue)
+            {
+                if (!parseIngestBackend(argv[++i], opt.ingest.backend)) return false;
+            }
+            else if (arg == "--format" && hasValue)
+            {
+                const std::string f = argv[++i];
+                if (f == "tsv") opt.format = OutputFormat::Tsv;
+                else if (f == "jsonl") opt.format = OutputFormat::Jsonl;
+                else return false;
+            }
+            else return false;
+        }
+        return !opt.manifestPath.empty() && (opt.modelPath.empty() || opt.hashBits == 0);
+    }
+
+    bool featureConfig(const SearchOptions& opt, FeatureConfig& config)
+    {
+        if (opt.hashBits > 0)
+        {
+            HashingConfig h;
+            h.bits = opt.hashBits;
+            config = FeatureConfig::forHashing(h);
+            return true;
+        }
+        if (opt.modelPath.empty())
+        {
+            config = FeatureConfig::forKeywords(std::vector<std::string>(kDefaultKeywords.begin(), kDefaultKeywords.end()));
+            return true;
+        }
+        Perceptron model(0);
+        if (!model.loadModel(opt.modelPath) || model.getFeatureConfig().dimension() != model.inputSize())
+        {
+            std::fprintf(stderr, "perceptron-search: cannot take a feature config from '%s'\n", opt.modelPath.c_str());
+            return false;
+        }
+        config = model.getFeatureConfig();
+        return true;
+    }
+
+    void printResult(const ConfigResult& r, OutputFormat format)
+    {
+        const TrainingConfig& c = r.config;
+        const bool ls = c.mode == TrainingMode::LeastSquares;
+        if (format == OutputFormat::Jsonl)
+        {
+            std::printf("{\"mode\":\"%s\",\"learning_rate\":%.6g,\"epochs\":%d,\"ridge\":%.6g,"
+                "\"accuracy\":%.6f,\"accuracy_stddev\":%.6f,\"precision\":%.6f,\"recall\":%.6f,"
+                "\"f1\":%.6f,\"seconds\":%.6f}\n",
+                trainingModeName(c.mode), ls ? 0.0 : c.learningRate, ls ? 1 : c.epochs, ls ? c.ridge : 0.0,
+                r.accuracyMean, r.accuracyStddev, r.counts.precision(), r.counts.recall(), r.counts.f1(), r.seconds);
+            return;
+        }
+        char lr[32] = "-", epochs[16] = "-", ridge[32] = "-";
+        if (ls) std::snprintf(ridge, sizeof(ridge), "%g", c.ridge);
+        else
+        {
+            std::snprintf(lr, sizeof(lr), "%g", c.learningRate);
+            std::snprintf(epochs, sizeof(epochs), "%d", c.epochs);
+        }
+        std::printf("%s\t%s\t%s\t%s\t%.4f\t%.4f\t%.4f\t%.4f\t%.4f\t%.3f\n", trainingModeName(c.mode), lr, epochs,
+            ridge, r.accuracyMean, r.accuracyStddev, r.counts.precision(), r.counts.recall(), r.counts.f1(),
+            r.seconds);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    SearchOptions opt;
+    if (!parseArgs(argc, argv, opt))
+    {
+        usage();
+        return 1;
+    }
+
+    FeatureConfig config;
+    if (!featureConfig(opt, config)) return 1;
+    const Featurizer featurizer(config);
+    ThreadPool pool(opt.threads);
+
+    // extract once; every configuration reads this matrix
+    const auto t0 = std::chrono::steady_clock::now();
+    SparseDataset data;
+    StreamingStats extracted;
+    std::string error;
+    if (!extractManifest(featurizer, opt.manifestPath, pool, data, &extracted, &error, opt.ingest))
+    {
+        std::fprintf(stderr, "perceptron-search: %s\n", error.c_str());
+        return 1;
+    }
+    const double extractSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    for (const auto& p : extracted.problems) std::fprintf(stderr, "perceptron-search: skipped: %s\n", p.c_str());
+    std::fprintf(stderr, "perceptron-search: %zu documents (%zu skipped), %zu features, extracted in %.3f s\n",
+        data.rows(), extracted.skipped, data.cols(), extractSeconds);
+
+    // least squares needs a (d+1)^2 system: leave it out for hashed features
+    std::vector<TrainingConfig> configs = expandGrid(opt.grid);
+    if (data.cols() > kMaxLeastSquaresDimension)
+    {
+        const size_t before = configs.size();
+        configs.erase(std::remove_if(configs.begin(), configs.end(),
+            [](const TrainingConfig& c) { return c.mode == TrainingMode::LeastSquares; }), configs.end());
+        if (configs.size() != before)
+            std::fprintf(stderr, "perceptron-search: skipped %zu least-squares configuration(s): %zu features, "
+                "at most %zu supported\n", before - configs.size(), data.cols(), kMaxLeastSquaresDimension);
+        if (configs.empty())
+        {
+            std::fprintf(stderr, "perceptron-search: no configuration left to run\n");
+            return 1;
+        }
+    }
+    CrossValidationReport report;
+    if (!crossValidate(data, configs, pool, opt.cv, report, &error))
+    {
+        std::fprintf(stderr, "perceptron-search: %s\n", error.c_str());
+        return 1;
+    }
+
+    std::vector<ConfigResult> ranked = report.results;
+    std::stable_sort(ranked.begin(), ranked.end(), [](const ConfigResult& a, const ConfigResult& b) {
+        return a.accuracyMean > b.accuracyMean;
+    });
+    if (opt.format == OutputFormat::Tsv)
+        std::printf("mode\tlr\tepochs\tridge\taccuracy\tstddev\tprecision\trecall\tf1\tseconds\n");
+    for (const ConfigResult& r : ranked) printResult(r, opt.format);
+
+    std::fprintf(stderr, "perceptron-search: %zu configurations x %u folds (%zu training runs) on %u threads"
+        " in %.3f s\n", configs.size(), report.folds, report.tasks, pool.size(), report.wallSeconds);
+    return 0;
+}
@@ -0,0 +1,140 @@
+// Resident classifier on a Unix domain socket (POSIX only).
+//
+//   perceptron-serve --model spam.bin --socket /tmp/perceptron.sock
+//                    [--threads N] [--max-batch N] [--max-wait-us N]
+//                    [--probe FILE] [--metrics FILE]
+//
+// Loads the model once and answers requests until SIGINT/SIGTERM; see
+// ClassifierServer.h for the protocol and bench/ServeLoadGen.cpp for a load
+// generator. SIGHUP reloads the model file in the background and swaps it in
+// once it has loaded and validated (ModelRegistry); requests keep being
+// served by the old model meanwhile, and a bad file leaves it in place.
+// Replace the model file by renaming a new file over it (saveModelBinary
+// does); rewriting a mapped binary model in place would change it under the
+// model that is serving. --probe names a document every new model must score
+// to a finite value.
+// --metrics writes a snapshot at shutdown, like perceptron-cli.
+#include "Classifier.h"
+#include "ClassifierServer.h"
+#include "Metrics.h"
+#include "MappedFile.h"
+#include "ModelRegistry.h"
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <pthread.h>
+
+namespace
+{
+    struct ServeOptions
+    {
+        std::string modelPath;
+        std::string metricsPath;
+        std::string probePath;
+        ServerOptions server;
+    };
+
+    void usage()
+    {
+        std::fprintf(stderr,
+            "usage: perceptron-serve --model FILE --socket PATH [--threads N]\n"
+            "                        [--max-batch N] [--max-wait-us N] [--probe FILE]\n"
+            "                        [--metrics FILE.json|FILE.prom]\n"
+            "SIGHUP reloads the model file without interrupting requests.\n");
+    }
+
+    bool parseArgs(int argc, char** argv, ServeOptions& opt)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string arg = argv[i];
+            const bool hasValue = i + 1 < argc;
+            if (arg == "--model" && hasValue) opt.modelPath = argv[++i];
+            else if (arg == "--socket" && hasValue) opt.server.socketPath = argv[++i];
+            else if (arg == "--metrics" && hasValue) opt.metricsPath = argv[++i];
+            else if (arg == "--probe" && hasValue) opt.probePath = argv[++i];
+            else if (arg == "--threads" && hasValue) opt.server.workers = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+            else if (arg == "--max-batch" && hasValue) opt.server.maxBatch = std::strtoul(argv[++i], nullptr, 10);
+            else if (arg == "--max-wait-us" && hasValue) opt.server.maxWaitUs = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+            else return false;
+        }
+        return !opt.modelPath.empty() && !opt.server.socketPath.empty();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    ServeOptions opt;
+    if (!parseArgs(argc, argv, opt))
+    {
+        usage();
+        return 1;
+    }
+
+    ModelRegistry::Options registryOptions;
+    std::string error;
+    if (!opt.probePath.empty())
+    {
+        MappedFile probe;
+        if (!probe.open(opt.probePath, &error))
+        {
+            std::fprintf(stderr, "perceptron-serve: %s\n", error.c_str());
+            return 1;
+        }
+        registryOptions.probeDocuments.emplace_back(probe.view());
+    }
+    ModelRegistry models(std::move(registryOptions));
+    if (!models.load(opt.modelPath, &error))
+    {
+        std::fprintf(stderr, "perceptron-serve: %s\n", error.c_str());
+        return 1;
+    }
+
+    // block the signals in every thread; the main thread waits for them
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    sigaddset(&signals, SIGHUP);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    ClassifierServer server(models, opt.server);
+    if (!server.start(&error))
+    {
+        std::fprintf(stderr, "perceptron-serve: %s\n", error.c_str());
+        return 1;
+    }
+    std::fprintf(stderr, "perceptron-serve: listening on %s\n", opt.server.socketPath.c_str());
+
+    int signal = 0;
+    while (sigwait(&signals, &signal) == 0 && signal == SIGHUP)
+    {
+        models.reloadAsync(opt.modelPath, [](const ModelRegistry::ReloadResult& r) {
+            if (r.ok)
+                std::fprintf(stderr, "perceptron-serve: reloaded '%s' (version %llu, %.3f s)\n",
+                    r.filename.c_str(), static_cast<unsigned long long>(r.version), r.seconds);
+            else
+                std::fprintf(stderr, "perceptron-serve: reload failed, keeping the current model: %s\n",
+                    r.error.c_str());
+        });
+    }
+    server.stop();
+
+    const ServerStats s = server.stats();
+    std::fprintf(stderr, "perceptron-serve: %llu connections, %llu requests (%llu errors) in %llu batches,"
+        " mean batch %.2f, largest %llu\n",
+        static_cast<unsigned long long>(s.connections), static_cast<unsigned long long>(s.requests),
+        static_cast<unsigned long long>(s.errors), static_cast<unsigned long long>(s.batches),
+        s.batches ? static_cast<double>(s.requests) / static_cast<double>(s.batches) : 0.0,
+        static_cast<unsigned long long>(s.largestBatch));
+
+    if (!opt.metricsPath.empty())
+    {
+        const std::string& m = opt.metricsPath;
+        const bool prom = m.size() >= 5 && m.compare(m.size() - 5, 5, ".prom") == 0;
+        if (!metrics::writeSnapshot(m, prom ? metrics::Format::Prometheus : metrics::Format::Json, &error))
+            std::fprintf(stderr, "perceptron-serve: cannot write metrics: %s\n", error.c_str());
+    }
+    return 0;
+}
@@ -0,0 +1,200 @@
+// Headless trainer: streams a labeled manifest into a model and saves it.
+//
+//   perceptron-train --manifest train.txt --out spam.bin
+//                    [--hash-bits N [--hash-seed N] [--signed-hash]]
+//                    [--keywords FILE [--exact]] [--init MODEL]
+//                    [--epochs N] [--rate LR] [--average] [--ls [--ridge R]]
+//                    [--batch N] [--shuffle N] [--seed N] [--threads N]
+//
+// The manifest has one "path<TAB>label" per line (ManifestReader). Documents
+// are extracted on the pool while the previous batch trains
+// (trainFromManifest), so the corpus does not have to fit in memory.
+//
+// Features: --hash-bits trains over every token hashed into 2^N buckets, with
+// the bit count, seed and sign mode saved in the model; --keywords (one per
+// line, --exact for whole-token matching) counts a keyword list; the default is
+// the built-in keyword set. --init continues training a saved model with the
+// feature config it was saved with. --out ending in .bin writes the binary
+// format, anything else the text format (as the GUI does).
+#include "DefaultKeywords.h"
+#include "Featurizer.h"
+#include "Perceptron.h"
+#include "StreamingTrainer.h"
+#include "ThreadPool.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    struct TrainOptions
+    {
+        std::string manifestPath;
+        std::string outPath;
+        std::string keywordsPath;     // keyword list; empty = default keywords
+        std::string initPath;         // model to continue training; empty = new model
+        bool exact = false;           // keywords: whole-token matching
+        unsigned hashBits = 0;        // > 0: hashing features instead of keywords
+        uint32_t hashSeed = 0;
+        bool signedHash = false;
+        double learningRate = 0.001;
+        unsigned threads = 0;
+        StreamingOptions streaming;
+    };
+
+    void usage()
+    {
+        std::fprintf(stderr,
+            "usage: perceptron-train --manifest FILE --out FILE\n"
+            "                        [--hash-bits N [--hash-seed N] [--signed-hash]]\n"
+            "                        [--keywords FILE [--exact]] [--init MODEL]\n"
+            "                        [--epochs N] [--rate LR] [--average] [--ls [--ridge R]]\n"
+            "                        [--batch N] [--shuffle N] [--seed N] [--threads N]\n"
+            "Trains on a 'path<TAB>label' manifest and saves the model (*.bin = binary,\n"
+            "otherwise text). --hash-bits takes 1..%u.\n", kMaxHashBits);
+    }
+
+    bool parseArgs(int argc, char** argv, TrainOptions& opt)
+    {
+        opt.streaming.epochs = 10;
+        opt.streaming.shuffleBuffer = 4096;
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string arg = argv[i];
+            const bool hasValue = i + 1 < argc;
+            if (arg == "--manifest" && hasValue) opt.manifestPath = argv[++i];
+            else if (arg == "--out" && hasValue) opt.outPath = argv[++i];
+            else if (arg == "--keywords" && hasValue) opt.keywordsPath = argv[++i];
+            else if (arg == "--init" && hasValue) opt.initPath = argv[++i];
+            else if (arg == "--exact") opt.exact = true;
+            else if (arg == "--hash-bits" && hasValue)
+            {
+                char* end = nullptr;
+                const unsigned long bits = std::strtoul(argv[++i], &end, 10);
+                if (*end != '\0' || bits == 0 || bits > kMaxHashBits) return false;
+                opt.hashBits = static_cast<unsigned>(bits);
+            }
+            else if (arg == "--hash-seed" && hasValue) opt.hashSeed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+            else if (arg == "--signed-hash") opt.signedHash = true;
+            else if (arg == "--epochs" && hasValue) opt.streaming.epochs = std::atoi(argv[++i]);
+            else if (arg == "--rate" && hasValue) opt.learningRate = std::strtod(argv[++i], nullptr);
+            else if (arg == "--average") opt.streaming.average = true;
+            else if (arg == "--ls") opt.streaming.leastSquares = true;
+            else if (arg == "--ridge" && hasValue) opt.streaming.ridge = std::strtod(argv[++i], nullptr);
+            else if (arg == "--batch" && hasValue) opt.streaming.batchSize = std::strtoul(argv[++i], nullptr, 10);
+            else if (arg == "--shuffle" && hasValue) opt.streaming.shuffleBuffer = std::strtoul(argv[++i], nullptr, 10);
+            else if (arg == "--seed" && hasValue) opt.streaming.seed = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+            else if (arg == "--threads" && hasValue) opt.threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+            else return false;
+        }
+        if (opt.streaming.batchSize == 0) opt.streaming.batchSize = 1;
+        const int featureSources = (opt.hashBits > 0) + !opt.keywordsPath.empty() + !opt.initPath.empty();
+        return !opt.manifestPath.empty() && !opt.outPath.empty() && opt.streaming.epochs > 0
+            && featureSources <= 1;
+    }
+
+    bool readKeywords(const std::string& path, std::vector<std::string>& keywords)
+    {
+        std::ifstream in(path);
+        if (!in) return false;
+        std::string line;
+        while (std::getline(in, line))
+        {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (!line.empty()) keywords.push_back(line);
+        }
+        return true;
+    }
+
+    // the model to train: loaded from --init, or new for the chosen features
+    bool makeModel(const TrainOptions& opt, Perceptron& model)
+    {
+        if (!opt.initPath.empty())
+        {
+            if (!model.loadModel(opt.initPath) || model.getFeatureConfig().dimension() != model.inputSize())
+            {
+                std::fprintf(stderr, "perceptron-train: cannot continue '%s' (unreadable, or no feature config)\n",
+                    opt.initPath.c_str());
+                return false;
+            }
+            return true;
+        }
+
+        FeatureConfig config;
+        if (opt.hashBits > 0)
+        {
+            HashingConfig h;
+            h.bits = opt.hashBits;
+            h.seed = opt.hashSeed;
+            h.signedHash = opt.signedHash;
+            config = FeatureConfig::forHashing(h);
+        }
+        else
+        {
+            std::vector<std::string> keywords;
+            if (opt.keywordsPath.empty())
+                keywords.assign(kDefaultKeywords.begin(), kDefaultKeywords.end());
+            else if (!readKeywords(opt.keywordsPath, keywords) || keywords.empty())
+            {
+                std::fprintf(stderr, "perceptron-train: no keywords in '%s'\n", opt.keywordsPath.c_str());
+                return false;
+            }
+            config = FeatureConfig::forKeywords(std::move(keywords),
+                opt.exact ? KeywordMatch::ExactToken : KeywordMatch::Substring);
+        }
+        model = Perceptron(static_cast<int>(config.dimension()), opt.learningRate);
+        model.setFeatureConfig(config);
+        return true;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    TrainOptions opt;
+    if (!parseArgs(argc, argv, opt))
+    {
+        usage();
+        return 1;
+    }
+
+    Perceptron model(0);
+    if (!makeModel(opt, model)) return 1;
+    const Featurizer featurizer(model.getFeatureConfig());
+    ThreadPool pool(opt.threads);
+
+    const auto t0 = std::chrono::steady_clock::now();
+    StreamingStats stats;
+    std::string error;
+    const bool ok = trainFromManifest(model, featurizer, opt.manifestPath, pool, opt.streaming, &stats, &error,
+        [](int epoch, const StreamingStats& s) {
+            std::fprintf(stderr, "perceptron-train: epoch %d: %zu samples, mean loss %.6g, %zu skipped\n",
+                epoch + 1, s.samples, s.meanLoss, s.skipped);
+            return true;
+        });
+    if (!ok)
+    {
+        std::fprintf(stderr, "perceptron-train: %s\n", error.c_str());
+        return 1;
+    }
+    for (const auto& p : stats.problems) std::fprintf(stderr, "perceptron-train: skipped: %s\n", p.c_str());
+    if (stats.samples == 0)
+    {
+        std::fprintf(stderr, "perceptron-train: no readable samples in '%s'\n", opt.manifestPath.c_str());
+        return 1;
+    }
+
+    const std::string& out = opt.outPath;
+    const bool binary = out.size() >= 4 && out.compare(out.size() - 4, 4, ".bin") == 0;
+    if (!(binary ? model.saveModelBinary(out) : model.saveModel(out)))
+    {
+        std::fprintf(stderr, "perceptron-train: cannot write '%s'\n", out.c_str());
+        return 1;
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    std::fprintf(stderr, "perceptron-train: %zu features, %zu samples, saved '%s' in %.3f s\n",
+        model.inputSize(), stats.samples, out.c_str(), seconds);
+    return 0;
+}
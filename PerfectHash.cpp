@@ -0,0 +1,110 @@
+#include "PerfectHash.h"
+#include <algorithm>
+#include <numeric>
+#include <utility>
+
+ExactKeywordTable::ExactKeywordTable(const std::vector<std::string>& keywords)
+    : words(keywords), lowercase(keywords.size(), 0)
+{
+    // group keyword indices by their case-folded form; empty keywords never match
+    std::vector<std::pair<std::string, uint32_t>> folded;
+    for (size_t i = 0; i < keywords.size(); ++i)
+    {
+        if (keywords[i].empty()) continue;
+        std::string key = keywords[i];
+        for (auto& c : key) c = static_cast<char>(PerfectHash::fold(static_cast<unsigned char>(c)));
+        lowercase[i] = key == keywords[i] ? 1 : 0;
+        folded.emplace_back(std::move(key), static_cast<uint32_t>(i));
+    }
+    std::sort(folded.begin(), folded.end());
+
+    std::vector<std::string> keys;
+    std::vector<uint32_t> keyStart;
+    for (size_t i = 0; i < folded.size(); ++i)
+    {
+        if (i == 0 || folded[i].first != folded[i - 1].first)
+        {
+            keys.push_back(folded[i].first);
+            keyStart.push_back(static_cast<uint32_t>(i));
+        }
+    }
+    keyStart.push_back(static_cast<uint32_t>(folded.size()));
+    if (keys.empty()) return;
+
+    numSlots = static_cast<uint32_t>(keys.size());
+    numBuckets = PerfectHash::bucketsFor(keys.size());
+    while (!build(keys, seed)) ++seed;
+
+    // lay the keyword indices out in slot order
+    std::vector<uint32_t> slotOfKey(keys.size());
+    for (uint32_t i = 0; i < numSlots; ++i)
+    {
+        const uint64_t h = PerfectHash::hash(keys[i], seed);
+        slotOfKey[i] = PerfectHash::slot(h, displacements[PerfectHash::bucket(h, numBuckets)], numSlots);
+    }
+    slotKeys.assign(numSlots, std::string());
+    slotStart.assign(numSlots + 1, 0);
+    for (uint32_t i = 0; i < numSlots; ++i)
+        slotStart[slotOfKey[i] + 1] = keyStart[i + 1] - keyStart[i];
+    std::partial_sum(slotStart.begin(), slotStart.end(), slotStart.begin());
+    entries.resize(folded.size());
+    for (uint32_t i = 0; i < numSlots; ++i)
+    {
+        const uint32_t s = slotOfKey[i];
+        slotKeys[s] = std::move(keys[i]);
+        for (uint32_t j = keyStart[i]; j < keyStart[i + 1]; ++j)
+            entries[slotStart[s] + (j - keyStart[i])] = folded[j].second;
+    }
+}
+
+bool ExactKeywordTable::build(const std::vector<std::string>& keys, uint64_t hashSeed)
+{
+    std::vector<uint64_t> hashes(keys.size());
+    std::vector<uint32_t> bucketStart(numBuckets + 1, 0);
+    for (size_t i = 0; i < keys.size(); ++i)
+    {
+        hashes[i] = PerfectHash::hash(keys[i], hashSeed);
+        ++bucketStart[PerfectHash::bucket(hashes[i], numBuckets) + 1];
+    }
+    std::partial_sum(bucketStart.begin(), bucketStart.end(), bucketStart.begin());
+
+    // keys grouped by bucket
+    std::vector<uint32_t> members(keys.size());
+    std::vector<uint32_t> fill(bucketStart.begin(), bucketStart.end() - 1);
+    for (size_t i = 0; i < keys.size(); ++i)
+        members[fill[PerfectHash::bucket(hashes[i], numBuckets)]++] = static_cast<uint32_t>(i);
+
+    // largest buckets first: they are the hardest to place
+    std::vector<uint32_t> order(numBuckets);
+    std::iota(order.begin(), order.end(), 0u);
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return bucketStart[a + 1] - bucketStart[a] > bucketStart[b + 1] - bucketStart[b];
+    });
+
+    displacements.assign(numBuckets, 0);
+    std::vector<uint8_t> taken(numSlots, 0);
+    std::vector<uint32_t> placed;
+    for (uint32_t b : order)
+    {
+        const uint32_t first = bucketStart[b], last = bucketStart[b + 1];
+        if (first == last) break; // the rest are empty too
+        uint32_t d = 0;
+        for (; d < PerfectHash::kMaxDisplacement; ++d)
+        {
+            placed.clear();
+            bool fits = true;
+            for (uint32_t m = first; m < last && fits; ++m)
+            {
+                const uint32_t s = PerfectHash::slot(hashes[members[m]], d, numSlots);
+                fits = !taken[s] && std::find(placed.begin(), placed.end(), s) == placed.end();
+                placed.push_back(s);
+            }
+            if (fits) break;
+        }
+        if (d == PerfectHash::kMaxDisplacement) return false;
+
+        displacements[b] = d;
+        for (uint32_t s : placed) taken[s] = 1;
+    }
+    return true;
+}
@@ -0,0 +1,227 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Minimal perfect hashing of a keyword list for exact-token matching
+// (KeywordMatch::ExactToken). Built with hash-and-displace: keys are spread
+// over about n/2 buckets, and each bucket, largest first, gets the smallest
+// displacement that moves all of its keys onto free slots. The n distinct keys
+// end up on n slots, so a lookup is one hash, one bucket read and one compare
+// against the single key that can live in that slot.
+//
+// Keys are hashed case-folded (ASCII), so a token hashes the same whether or
+// not the caller has lowercased it yet.
+struct PerfectHash
+{
+    static constexpr unsigned char fold(unsigned char c)
+    {
+        return c >= 'A' && c <= 'Z' ? static_cast<unsigned char>(c - 'A' + 'a') : c;
+    }
+
+    static constexpr uint64_t mix(uint64_t h)
+    {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdull;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ull;
+        h ^= h >> 33;
+        return h;
+    }
+
+    // FNV-1a of the case-folded bytes + final avalanche
+    static constexpr uint64_t hash(std::string_view s, uint64_t seed)
+    {
+        uint64_t h = 1469598103934665603ull ^ (seed * 0x9E3779B97F4A7C15ull);
+        for (char c : s)
+        {
+            h ^= fold(static_cast<unsigned char>(c));
+            h *= 1099511628211ull;
+        }
+        return mix(h);
+    }
+
+    // x * n / 2^32: maps a 32-bit value onto [0, n) without a division
+    static constexpr uint32_t reduce(uint32_t x, uint32_t n)
+    {
+        return static_cast<uint32_t>((static_cast<uint64_t>(x) * n) >> 32);
+    }
+
+    static constexpr uint32_t bucket(uint64_t h, uint32_t buckets)
+    {
+        return reduce(static_cast<uint32_t>(h >> 32), buckets);
+    }
+
+    static constexpr uint32_t slot(uint64_t h, uint32_t displacement, uint32_t slots)
+    {
+        return reduce(static_cast<uint32_t>(mix(h + displacement * 0x9E3779B97F4A7C15ull)), slots);
+    }
+
+    static constexpr uint32_t bucketsFor(size_t keys) { return static_cast<uint32_t>(keys / 2 + 1); }
+
+    // true if the case-folded token equals key (key is already folded)
+    static constexpr bool equalsFolded(std::string_view token, std::string_view key)
+    {
+        if (token.size() != key.size()) return false;
+        for (size_t i = 0; i < key.size(); ++i)
+            if (fold(static_cast<unsigned char>(token[i])) != static_cast<unsigned char>(key[i])) return false;
+        return true;
+    }
+
+    static constexpr bool isFolded(std::string_view s)
+    {
+        for (char c : s)
+            if (fold(static_cast<unsigned char>(c)) != static_cast<unsigned char>(c)) return false;
+        return true;
+    }
+
+    // displacements tried per bucket before a build retries with a new seed
+    static constexpr uint32_t kMaxDisplacement = 1u << 16;
+};
+
+// Exact-token keyword table built at load time (KeywordMatcher's ExactToken
+// mode). A keyword matches a token only if they are equal; empty keywords
+// never match, and a keyword listed twice reports both of its indices.
+class ExactKeywordTable
+{
+public:
+    ExactKeywordTable() = default;
+    explicit ExactKeywordTable(const std::vector<std::string>& keywords);
+
+    // number of distinct (case-folded) keys
+    size_t slots() const { return slotKeys.size(); }
+
+    // Calls onHit(keywordIndex) for every keyword equal to token. With
+    // foldCase the token is compared as if lowercased first, like
+    // KeywordMatcher::forEachMatch.
+    template <class OnHit>
+    void forEachHit(std::string_view token, OnHit&& onHit, bool foldCase = false) const
+    {
+        if (slotKeys.empty()) return;
+        const uint64_t h = PerfectHash::hash(token, seed);
+        const uint32_t s = PerfectHash::slot(h, displacements[PerfectHash::bucket(h, numBuckets)], numSlots);
+        if (!PerfectHash::equalsFolded(token, slotKeys[s])) return;
+        for (uint32_t e = slotStart[s]; e < slotStart[s + 1]; ++e)
+        {
+            const uint32_t k = entries[e];
+            if (foldCase ? lowercase[k] != 0 : words[k] == token) onHit(k);
+        }
+    }
+
+private:
+    // places every key; false if some bucket found no displacement
+    bool build(const std::vector<std::string>& keys, uint64_t hashSeed);
+
+    uint64_t seed = 0;
+    uint32_t numBuckets = 0;
+    uint32_t numSlots = 0;
+    std::vector<uint32_t> displacements; // per bucket
+    std::vector<std::string> slotKeys;   // case-folded key stored in each slot
+    std::vector<uint32_t> slotStart;     // entries[slotStart[s] .. slotStart[s+1])
+    std::vector<uint32_t> entries;       // keyword indices whose folded form is the slot's key
+    std::vector<std::string> words;      // keywords as given, for case-sensitive lookups
+    std::vector<uint8_t> lowercase;      // per keyword: already case-folded (can match folded text)
+};
+
+// Compile-time variant for a fixed list of at most 64 keywords (used by
+// FixedKeywordMatcher). Matches case-insensitively like FixedKeywordMatcher:
+// keywords that are empty or contain uppercase letters never match. A slot
+// holds the bitmask of keyword indices sharing its key.
+template <size_t N>
+class StaticExactKeywordTable
+{
+    static_assert(N > 0 && N <= 64, "StaticExactKeywordTable handles 1 to 64 keywords");
+
+public:
+    constexpr StaticExactKeywordTable() = default;
+
+    constexpr explicit StaticExactKeywordTable(const std::array<std::string_view, N>& keywords)
+    {
+        for (size_t k = 0; k < N; ++k)
+        {
+            const std::string_view w = keywords[k];
+            if (w.empty() || !PerfectHash::isFolded(w)) continue;
+            size_t i = 0;
+            while (i < numSlots && keys[i] != w) ++i;
+            if (i == numSlots) keys[numSlots++] = w;
+            masks[i] |= uint64_t(1) << k;
+        }
+        if (numSlots == 0) return;
+
+        numBuckets = PerfectHash::bucketsFor(numSlots);
+        while (!build()) ++seed;
+    }
+
+    // bitmask of the keywords equal to the case-folded token
+    constexpr uint64_t lookup(std::string_view token) const
+    {
+        if (numSlots == 0) return 0;
+        const uint64_t h = PerfectHash::hash(token, seed);
+        const uint32_t s = PerfectHash::slot(h, displacements[PerfectHash::bucket(h, numBuckets)], numSlots);
+        return PerfectHash::equalsFolded(token, slotKeys[s]) ? slotMasks[s] : 0;
+    }
+
+private:
+    constexpr bool build()
+    {
+        std::array<uint64_t, N> hashes{};
+        std::array<uint32_t, N> bucketOf{};
+        std::array<uint32_t, N> bucketSize{};
+        for (uint32_t i = 0; i < numSlots; ++i)
+        {
+            hashes[i] = PerfectHash::hash(keys[i], seed);
+            bucketOf[i] = PerfectHash::bucket(hashes[i], numBuckets);
+            ++bucketSize[bucketOf[i]];
+        }
+
+        std::array<bool, N> taken{};
+        std::array<uint32_t, N> placed{};
+        for (uint32_t size = numSlots; size > 0; --size)
+        {
+            for (uint32_t b = 0; b < numBuckets; ++b)
+            {
+                if (bucketSize[b] != size) continue;
+                uint32_t d = 0;
+                for (; d < PerfectHash::kMaxDisplacement; ++d)
+                {
+                    bool fits = true;
+                    uint32_t count = 0;
+                    for (uint32_t i = 0; i < numSlots && fits; ++i)
+                    {
+                        if (bucketOf[i] != b) continue;
+                        const uint32_t s = PerfectHash::slot(hashes[i], d, numSlots);
+                        fits = !taken[s];
+                        for (uint32_t j = 0; j < count && fits; ++j)
+                            fits = placed[j] != s;
+                        placed[count++] = s;
+                    }
+                    if (fits) break;
+                }
+                if (d == PerfectHash::kMaxDisplacement) return false;
+
+                displacements[b] = d;
+                for (uint32_t i = 0; i < numSlots; ++i)
+                {
+                    if (bucketOf[i] != b) continue;
+                    const uint32_t s = PerfectHash::slot(hashes[i], d, numSlots);
+                    taken[s] = true;
+                    slotKeys[s] = keys[i];
+                    slotMasks[s] = masks[i];
+                }
+            }
+        }
+        return true;
+    }
+
+    uint64_t seed = 0;
+    uint32_t numBuckets = 0;
+    uint32_t numSlots = 0;                          // distinct keys
+    std::array<std::string_view, N> keys{};         // distinct keys, in first-seen order
+    std::array<uint64_t, N> masks{};                // keyword indices per distinct key
+    std::array<uint32_t, N> displacements{};        // per bucket (numBuckets <= N)
+    std::array<std::string_view, N> slotKeys{};
+    std::array<uint64_t, N> slotMasks{};
+};
@@ -0,0 +1,63 @@
+#include "Quantization.h"
+#include "VectorKernels.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    double maxAbs(const double* v, size_t n)
+    {
+        double m = 0.0;
+        for (size_t i = 0; i < n; ++i) m = (std::max)(m, std::fabs(v[i]));
+        return m;
+    }
+
+    // round half away from zero; |v * inv| <= 127.5 by construction of inv
+    void quantize(const double* v, size_t n, double inv, int8_t* out)
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+            const double t = v[i] * inv;
+            const int q = static_cast<int>(t + (t < 0.0 ? -0.5 : 0.5));
+            out[i] = static_cast<int8_t>(q > 127 ? 127 : (q < -127 ? -127 : q));
+        }
+    }
+}
+
+float quantizeWeights(const double* w, size_t n, int8_t* out)
+{
+    const double m = maxAbs(w, n);
+    const float scale = m > 0.0 ? static_cast<float>(m / 127.0) : 1.0f;
+    quantize(w, n, 1.0 / scale, out);
+    return scale;
+}
+
+float quantizeInputs(const double* x, size_t n, int8_t* out)
+{
+    // counts convert exactly
+    if (kernels::toInt8Exact(x, n, out)) return 1.0f;
+
+    const double m = maxAbs(x, n);
+    const float scale = static_cast<float>(m / 127.0);
+    quantize(x, n, 1.0 / scale, out);
+    return scale;
+}
+
+double quantizedScore(const int8_t* w, float wScale, double bias, const std::vector<double>& inputs)
+{
+    thread_local std::vector<int8_t> q;
+    q.resize(inputs.size());
+    const float xScale = quantizeInputs(inputs.data(), inputs.size(), q.data());
+    const int64_t dot = kernels::dotI8(w, q.data(), q.size());
+    return bias + static_cast<double>(wScale) * xScale * static_cast<double>(dot);
+}
+
+double quantizedScore(const int8_t* w, float wScale, double bias, const SparseVector& inputs)
+{
+    thread_local std::vector<int8_t> q;
+    const size_t n = inputs.nnz();
+    q.resize(n);
+    const float xScale = quantizeInputs(inputs.values.data(), n, q.data());
+    const int64_t dot = kernels::gatherDotI8(w, inputs.indices.data(), q.data(), n);
+    return bias + static_cast<double>(wScale) * xScale * static_cast<double>(dot);
+}
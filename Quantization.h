@@ -0,0 +1,27 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "SparseVector.h"
+
+// Int8 quantization for serving (symmetric, zero point 0).
+//
+// Weights get one scale per model: w ~= q * scale, q in [-127, 127]. Inputs
+// are quantized per document the same way, except that integer inputs within
+// [-127, 127] (keyword and token counts) are kept exact with scale 1. The
+// score is then bias + wScale * xScale * sum(qw * qx), with the sum taken
+// exactly in integers (kernels::dotI8 / kernels::gatherDotI8).
+
+// int8 weight arrays must stay readable this many bytes past the last weight
+constexpr size_t kI8WeightPadding = 3;
+
+// Quantize n weights into out; returns the scale (1 if all are zero).
+float quantizeWeights(const double* w, size_t n, int8_t* out);
+
+// Quantize n inputs into out; returns the scale (1 for small integers).
+float quantizeInputs(const double* x, size_t n, int8_t* out);
+
+// bias + dequantized dot product. Dense inputs must have as many entries as
+// there are weights; sparse indices must be in range. Thread-safe.
+double quantizedScore(const int8_t* w, float wScale, double bias, const std::vector<double>& inputs);
+double quantizedScore(const int8_t* w, float wScale, double bias, const SparseVector& inputs);
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// Sparse feature vector: only the non-zero (index, value) pairs are stored.
+// Indices are strictly increasing and smaller than `dimension`.
+struct SparseVector
+{
+    std::vector<uint32_t> indices;
+    std::vector<double> values;
+    size_t dimension = 0;   // size of the equivalent dense vector
+
+    size_t nnz() const { return indices.size(); }
+
+    void clear()
+    {
+        indices.clear();
+        values.clear();
+    }
+
+    // append an entry; index must be larger than the last one
+    void push(uint32_t index, double value)
+    {
+        indices.push_back(index);
+        values.push_back(value);
+    }
+
+    std::vector<double> toDense() const
+    {
+        std::vector<double> dense(dimension, 0.0);
+        for (size_t k = 0; k < indices.size(); ++k) dense[indices[k]] = values[k];
+        return dense;
+    }
+
+    static SparseVector fromDense(const std::vector<double>& dense)
+    {
+        SparseVector sv;
+        sv.dimension = dense.size();
+        for (size_t i = 0; i < dense.size(); ++i)
+            if (dense[i] != 0.0) sv.push(static_cast<uint32_t>(i), dense[i]);
+        return sv;
+    }
+};
@@ -0,0 +1,216 @@
+#include "StreamingTrainer.h"
+#include "AveragedPerceptron.h"
+#include "BoundedQueue.h"
+#include "LeastSquares.h"
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <thread>
+
+namespace
+{
+    struct Sample
+    {
+        SparseVector features;
+        int label = 0;
+    };
+
+    struct Batch
+    {
+        std::vector<Sample> samples;
+        std::vector<std::string> problems;   // skipped lines / unreadable files
+    };
+}
+
+bool ManifestReader::open(const std::string& filename, std::string* error)
+{
+    in.close();
+    in.clear();
+    in.open(filename);
+    name = filename;
+    line = 0;
+    if (!in)
+    {
+        if (error) *error = "cannot open manifest '" + filename + "'";
+        return false;
+    }
+    return true;
+}
+
+bool ManifestReader::next(std::string& path, int& label, std::string& problem)
+{
+    problem.clear();
+    std::string text;
+    while (std::getline(in, text))
+    {
+        ++line;
+        if (!text.empty() && text.back() == '\r') text.pop_back();
+        if (text.empty() || text[0] == '#') continue;
+
+        size_t sep = text.rfind('\t');
+        if (sep == std::string::npos) sep = text.rfind(' ');
+        const std::string value = sep == std::string::npos ? std::string() : text.substr(sep + 1);
+        if (sep == 0 || (value != "0" && value != "1"))
+        {
+            problem = name + ":" + std::to_string(line) + ": expected 'path<TAB>label' with label 0 or 1";
+            return true;
+        }
+        path = text.substr(0, sep);
+        label = value[0] - '0';
+        return true;
+    }
+    return false;
+}
+
+bool trainFromManifest(Perceptron& model, const Featurizer& featurizer, const std::string& manifest,
+    ThreadPool& pool, const StreamingOptions& options, StreamingStats* stats, std::string* error,
+    const EpochCallback& onEpoch)
+{
+    if (featurizer.dimension() != model.inputSize())
+    {
+        if (error) *error = "feature dimension " + std::to_string(featurizer.dimension())
+            + " does not match the model's " + std::to_string(model.inputSize()) + " inputs";
+        return false;
+    }
+
+    const size_t batchSize = (std::max)(static_cast<size_t>(1), options.batchSize);
+    std::mt19937 rng(options.seed);
+    std::vector<Sample> shuffle;
+    shuffle.reserve(options.shuffleBuffer);
+
+    // least squares: one pass into the normal equations instead of updates,
+    // summed by the extraction workers into one accumulator per shard
+    std::vector<GramAccumulator> sums;
+    if (options.leastSquares)
+    {
+        if (model.inputSize() > kMaxLeastSquaresDimension)
+        {
+            if (error) *error = "least squares supports at most " + std::to_string(kMaxLeastSquaresDimension)
+                + " inputs, the model has " + std::to_string(model.inputSize());
+            return false;
+        }
+        sums.assign(gramShardCount(model.inputSize(), pool.size()), GramAccumulator(model.inputSize()));
+    }
+    const int epochs = options.leastSquares ? 1 : options.epochs;
+
+    std::unique_ptr<AveragedPerceptron> averager;
+    if (options.average && !options.leastSquares) averager.reset(new AveragedPerceptron(model));
+
+    StreamingStats epochStats;
+    for (int epoch = 0; epoch < epochs; ++epoch)
+    {
+        ManifestReader reader;
+        if (!reader.open(manifest, error)) return false;
+
+        epochStats = StreamingStats();
+        double lossSum = 0.0;
+        auto trainOne = [&](const Sample& s) {
+            ++epochStats.samples;
+            if (options.leastSquares) return;   // already summed by the producer
+            lossSum += averager ? averager->train(s.features, s.label) : model.train(s.features, s.label);
+        };
+
+        // stage 1 (own thread): read the manifest and extract one batch at a time on the pool
+        BoundedQueue<Batch> queue(options.prefetch);
+        std::thread producer([&] {
+            std::string path, problem;
+            int label = 0;
+            bool more = true;
+            while (more)
+            {
+                Batch batch;
+                std::vector<std::string> paths;
+                while (paths.size() < batchSize && (more = reader.next(path, label, problem)))
+                {
+                    if (!problem.empty())
+                    {
+                        batch.problems.push_back(std::move(problem));
+                        continue;
+                    }
+                    paths.push_back(std::move(path));
+                    batch.samples.emplace_back();
+                    batch.samples.back().label = label;
+                }
+                if (paths.empty() && batch.problems.empty()) break;
+
+                std::vector<std::string> errors(paths.size());
+                auto extract = [&](size_t i) {
+                    thread_local Featurizer::Scratch scratch;
+                    Sample& s = batch.samples[i];
+                    if (!featurizer.extractFile(paths[i], s.features, scratch, errors[i]))
+                        s.label = -1; // marks a failed read
+                    return s.label >= 0;
+                };
+                if (options.leastSquares)
+                {
+                    // shard k extracts its slice of the batch and sums it into
+                    // sums[k]; only the labels go on to the consumer
+                    const size_t n = paths.size(), shards = sums.size();
+                    pool.parallelFor(shards, [&](size_t k) {
+                        for (size_t i = n * k / shards; i < n * (k + 1) / shards; ++i)
+                        {
+                            if (!extract(i)) continue;
+                            sums[k].add(batch.samples[i].features, batch.samples[i].label);
+                            batch.samples[i].features = SparseVector();
+                        }
+                    });
+                }
+                else
+                {
+                    pool.parallelFor(paths.size(), [&](size_t i) { extract(i); });
+                }
+                for (auto& e : errors)
+                    if (!e.empty()) batch.problems.push_back(std::move(e));
+
+                if (!queue.push(std::move(batch))) break;
+            }
+            queue.close();
+        });
+
+        // stage 2 (this thread): train, optionally through the shuffle buffer
+        Batch batch;
+        while (queue.pop(batch))
+        {
+            for (auto& p : batch.problems) epochStats.noteProblem(std::move(p));
+            for (auto& s : batch.samples)
+            {
+                if (s.label < 0) continue;
+                if (options.shuffleBuffer == 0 || options.leastSquares)
+                {
+                    trainOne(s);
+                }
+                else if (shuffle.size() < options.shuffleBuffer)
+                {
+                    shuffle.push_back(std::move(s));
+                }
+                else
+                {
+                    // train on a random buffered sample, park the new one in its slot
+                    const size_t j = std::uniform_int_distribution<size_t>(0, shuffle.size() - 1)(rng);
+                    trainOne(shuffle[j]);
+                    shuffle[j] = std::move(s);
+                }
+            }
+        }
+        producer.join();
+
+        std::shuffle(shuffle.begin(), shuffle.end(), rng);
+        for (const auto& s : shuffle) trainOne(s);
+        shuffle.clear();
+
+        epochStats.meanLoss = epochStats.samples ? lossSum / static_cast<double>(epochStats.samples) : 0.0;
+        if (options.leastSquares && epochStats.samples)
+        {
+            std::vector<double> w;
+            double b = 0.0;
+            for (size_t k = 1; k < sums.size(); ++k) sums[0].merge(sums[k]);
+            if (!solveLeastSquares(sums[0], options.ridge, w, b, error, &epochStats.meanLoss)) return false;
+            model.setParameters(w, b);
+        }
+        if (onEpoch && !onEpoch(epoch, epochStats)) break;
+    }
+
+    if (averager) averager->finalize();
+    if (stats) *stats = std::move(epochStats);
+    return true;
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <fstream>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+#include "Featurizer.h"
+#include "Perceptron.h"
+#include "ThreadPool.h"
+
+// Reads a training manifest: one "path<TAB>label" per line, label 0 or 1.
+// A space may separate the label instead of a tab (the last one on the line is
+// used, so paths may contain spaces). Blank lines and lines starting with '#'
+// are skipped.
+class ManifestReader
+{
+public:
+    bool open(const std::string& filename, std::string* error = nullptr);
+
+    // Next line; false at end of file. For a malformed line it returns true
+    // with a description in problem; problem is empty for a valid entry.
+    bool next(std::string& path, int& label, std::string& problem);
+
+    size_t lineNumber() const { return line; }
+
+private:
+    std::ifstream in;
+    std::string name;
+    size_t line = 0;
+};
+
+// Options for trainFromManifest
+struct StreamingOptions
+{
+    int epochs = 1;
+    size_t batchSize = 256;      // documents extracted per pipeline step
+    size_t prefetch = 2;         // extracted batches buffered ahead of training
+    size_t shuffleBuffer = 0;    // 0 = manifest order; else draw samples at random from a buffer this big
+    unsigned seed = 0;           // shuffle seed
+    bool average = false;        // leave averaged weights in the model (AveragedPerceptron)
+    bool leastSquares = false;   // one pass + closed-form ridge solve (LeastSquares.h); ignores epochs/average
+    double ridge = 1e-3;         // leastSquares: L2 penalty on the weights
+};
+
+struct StreamingStats
+{
+    size_t samples = 0;                  // samples trained in the epoch
+    size_t skipped = 0;                  // unreadable files + malformed manifest lines
+    double meanLoss = 0.0;               // mean 0.5*(score-y)^2 before each update (leastSquares: after the solve)
+    std::vector<std::string> problems;   // the first kMaxProblems skip reasons
+
+    static constexpr size_t kMaxProblems = 20;
+
+    // counts one skipped line or file and keeps its reason if there is room
+    void noteProblem(std::string problem)
+    {
+        ++skipped;
+        if (problems.size() < kMaxProblems) problems.push_back(std::move(problem));
+    }
+};
+
+// Called after every epoch with its 0-based index and stats; return false to stop.
+using EpochCallback = std::function<bool(int epoch, const StreamingStats& stats)>;
+
+// Out-of-core training: the manifest is read again every epoch, and documents
+// are extracted in batches on the pool while the calling thread trains on the
+// previous batch. At most (prefetch + 2) * batchSize + shuffleBuffer feature
+// vectors are held at once, whatever the corpus size: prefetch batches in the
+// queue, one being extracted (or waiting to be queued) and one being trained.
+//
+// featurizer must produce model.inputSize() features. Unreadable files and bad
+// lines are skipped and counted. Returns false (with *error) only if the
+// manifest cannot be read or the dimensions do not match. *stats receives the
+// last epoch's numbers.
+//
+// With options.leastSquares the manifest is read once: the pool workers sum
+// the vectors they extract into per-shard normal equations, which are merged
+// and the model is set to their ridge solution (one "epoch"). This fails for
+// models above kMaxLeastSquaresDimension inputs.
+bool trainFromManifest(Perceptron& model, const Featurizer& featurizer, const std::string& manifest,
+    ThreadPool& pool, const StreamingOptions& options = StreamingOptions(),
+    StreamingStats* stats = nullptr, std::string* error = nullptr,
+    const EpochCallback& onEpoch = nullptr);
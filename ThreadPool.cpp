@@ -0,0 +1,166 @@
+#include "ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <exception>
+
+namespace
+{
+    // which pool/worker the current thread belongs to (if any)
+    thread_local const ThreadPool* tlsPool = nullptr;
+    thread_local unsigned tlsIndex = 0;
+}
+
+ThreadPool::ThreadPool(unsigned threads)
+{
+    if (threads == 0)
+        threads = (std::max)(1u, std::thread::hardware_concurrency());
+
+    queues.reserve(threads);
+    for (unsigned i = 0; i < threads; ++i)
+        queues.push_back(std::make_unique<Queue>());
+
+    workers.reserve(threads);
+    for (unsigned i = 0; i < threads; ++i)
+        workers.emplace_back([this, i] { workerLoop(i); });
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> g(sleepLock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& t : workers) t.join();
+}
+
+void ThreadPool::push(unsigned index, std::function<void()> task)
+{
+    // count first so `pending` never dips below zero when a thief is quick
+    {
+        std::lock_guard<std::mutex> g(sleepLock);
+        pending.fetch_add(1, std::memory_order_relaxed);
+    }
+    {
+        std::lock_guard<std::mutex> g(queues[index]->lock);
+        queues[index]->tasks.push_back(std::move(task));
+    }
+    wake.notify_one();
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+    unsigned index = (tlsPool == this)
+        ? tlsIndex
+        : nextQueue.fetch_add(1, std::memory_order_relaxed) % size();
+    push(index, std::move(task));
+}
+
+bool ThreadPool::popLocal(unsigned index, std::function<void()>& task)
+{
+    Queue& q = *queues[index];
+    std::lock_guard<std::mutex> g(q.lock);
+    if (q.tasks.empty()) return false;
+    task = std::move(q.tasks.back());
+    q.tasks.pop_back();
+    pending.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool ThreadPool::steal(unsigned index, std::function<void()>& task)
+{
+    const unsigned n = size();
+    for (unsigned k = 1; k <= n; ++k)
+    {
+        Queue& q = *queues[(index + k) % n];
+        std::lock_guard<std::mutex> g(q.lock);
+        if (q.tasks.empty()) continue;
+        task = std::move(q.tasks.front());
+        q.tasks.pop_front();
+        pending.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::workerLoop(unsigned index)
+{
+    tlsPool = this;
+    tlsIndex = index;
+
+    std::function<void()> task;
+    for (;;)
+    {
+        if (popLocal(index, task) || steal(index, task))
+        {
+            task();
+            task = nullptr;
+            continue;
+        }
+
+        std::unique_lock<std::mutex> l(sleepLock);
+        wake.wait(l, [this] { return stopping || pending.load(std::memory_order_relaxed) > 0; });
+        if (stopping && pending.load(std::memory_order_relaxed) == 0)
+            return;
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& body, size_t grain)
+{
+    if (count == 0) return;
+    grain = (std::max)(static_cast<size_t>(1), grain);
+    const size_t chunks = (count + grain - 1) / grain;
+
+    struct State
+    {
+        std::atomic<size_t> remaining;
+        std::mutex lock;
+        std::condition_variable done;
+        std::exception_ptr error;
+    };
+    auto state = std::make_shared<State>();
+    state->remaining = chunks;
+
+    // deal contiguous blocks of chunks to each worker; stealing evens them out
+    const unsigned n = size();
+    for (size_t c = 0; c < chunks; ++c)
+    {
+        const size_t begin = c * grain;
+        const size_t end = (std::min)(count, begin + grain);
+        push(static_cast<unsigned>(c * n / chunks), [state, &body, begin, end] {
+            try
+            {
+                for (size_t i = begin; i < end; ++i) body(i);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> g(state->lock);
+                if (!state->error) state->error = std::current_exception();
+            }
+            if (state->remaining.fetch_sub(1) == 1)
+            {
+                std::lock_guard<std::mutex> g(state->lock);
+                state->done.notify_all();
+            }
+        });
+    }
+
+    // the caller helps instead of just blocking (also avoids deadlock when a
+    // worker itself calls parallelFor)
+    const unsigned self = (tlsPool == this) ? tlsIndex : 0;
+    std::function<void()> task;
+    while (state->remaining.load() > 0)
+    {
+        if (steal(self, task))
+        {
+            task();
+            task = nullptr;
+            continue;
+        }
+        std::unique_lock<std::mutex> l(state->lock);
+        state->done.wait_for(l, std::chrono::milliseconds(1),
+            [&] { return state->remaining.load() == 0; });
+    }
+
+    if (state->error) std::rethrow_exception(state->error);
+}
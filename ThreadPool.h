@@ -0,0 +1,56 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size work-stealing thread pool.
+// Every worker owns a deque: it pops its own work from the back and, when it
+// runs dry, steals from the front of the others. That keeps all cores busy when
+// task costs are very uneven (e.g. a mix of 2 KB and 20 MB files).
+class ThreadPool
+{
+public:
+    // threads = 0 uses std::thread::hardware_concurrency()
+    explicit ThreadPool(unsigned threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned size() const { return static_cast<unsigned>(queues.size()); }
+
+    // Queue a task. From a worker thread it lands on that worker's own deque.
+    void submit(std::function<void()> task);
+
+    // Run body(i) for i in [0, count) and block until all are done.
+    // Indices are handed out in chunks of `grain`; chunks are spread evenly over
+    // the workers up front and rebalanced by stealing.
+    void parallelFor(size_t count, const std::function<void(size_t)>& body, size_t grain = 1);
+
+private:
+    struct Queue
+    {
+        std::mutex lock;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    void workerLoop(unsigned index);
+    bool popLocal(unsigned index, std::function<void()>& task);
+    bool steal(unsigned index, std::function<void()>& task);
+    void push(unsigned index, std::function<void()> task);
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex sleepLock;              // guards waiting on `wake`
+    std::condition_variable wake;
+    std::atomic<size_t> pending{ 0 };  // queued, not yet started
+    std::atomic<unsigned> nextQueue{ 0 };
+    bool stopping = false;
+};
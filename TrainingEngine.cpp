@@ -0,0 +1,205 @@
+#include "TrainingEngine.h"
+#include "LeastSquares.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <numeric>
+#include <random>
+
+void LogSinkObserver::onSample(const SampleProgress& p)
+{
+    char line[160];
+    std::snprintf(line, sizeof(line), "epoch %d sample %zu: label %d score %.6g -> %.6g loss %.6g",
+        p.epoch + 1, p.row + 1, p.label, p.scoreBefore, p.scoreAfter, p.loss);
+    sink.write(line);
+}
+
+void LogSinkObserver::onEpoch(const EpochProgress& p)
+{
+    char line[160];
+    int n = std::snprintf(line, sizeof(line), "epoch %d: %zu samples, mean loss %.6g",
+        p.epoch + 1, p.samples, p.meanLoss);
+    if (p.skipped && n > 0 && static_cast<size_t>(n) < sizeof(line))
+        std::snprintf(line + n, sizeof(line) - n, ", %zu skipped", p.skipped);
+    sink.write(line);
+}
+
+void LogSinkObserver::onFinished(const TrainingResult& r)
+{
+    for (const auto& p : r.problems) sink.write("  skipped: " + p);
+    char line[160];
+    if (!r.ok)
+    {
+        sink.write("training failed: " + r.error);
+        return;
+    }
+    std::snprintf(line, sizeof(line), "%s after %d epoch(s) in %.3f s, mean loss %.6g",
+        r.cancelled ? "cancelled" : "trained", r.epochs, r.seconds, r.meanLoss);
+    sink.write(line);
+}
+
+TrainingEngine::~TrainingEngine()
+{
+    cancel();
+    if (worker.joinable()) worker.join();
+}
+
+bool TrainingEngine::launch()
+{
+    if (active) return false;
+    if (worker.joinable()) worker.join();
+    cancelRequested = false;
+    active = true;
+    result = TrainingResult();
+    return true;
+}
+
+bool TrainingEngine::start(Perceptron& model, Dataset samples, const TrainingOptions& options,
+    TrainingObserver* observer, ThreadPool* pool)
+{
+    if (!launch()) return false;
+    data = std::move(samples);
+    worker = std::thread([this, &model, options, observer, pool] {
+        result = run(model, data, options, observer, &cancelRequested, pool);
+        active = false;
+    });
+    return true;
+}
+
+bool TrainingEngine::startStreaming(Perceptron& model, const Featurizer& extractor, const std::string& manifest,
+    ThreadPool& pool, const StreamingOptions& options, ProgressLevel progress, TrainingObserver* observer)
+{
+    if (!launch()) return false;
+    featurizer = extractor;
+    worker = std::thread([this, &model, manifest, &pool, options, progress, observer] {
+        const auto t0 = std::chrono::steady_clock::now();
+        TrainingResult r;
+        StreamingStats stats;
+        r.ok = trainFromManifest(model, featurizer, manifest, pool, options, &stats, &r.error,
+            [&](int epoch, const StreamingStats& s) {
+                r.epochs = epoch + 1;
+                if (observer && progress != ProgressLevel::Summary)
+                {
+                    EpochProgress p;
+                    p.epoch = epoch;
+                    p.samples = s.samples;
+                    p.skipped = s.skipped;
+                    p.meanLoss = s.meanLoss;
+                    observer->onEpoch(p);
+                }
+                return !cancelRequested;
+            });
+        r.cancelled = cancelRequested && r.epochs < (options.leastSquares ? 1 : options.epochs);
+        r.samples = stats.samples;
+        r.skipped = stats.skipped;
+        r.meanLoss = stats.meanLoss;
+        r.problems = std::move(stats.problems);
+        r.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        result = r;
+        if (observer) observer->onFinished(r);
+        active = false;
+    });
+    return true;
+}
+
+TrainingResult TrainingEngine::wait()
+{
+    if (worker.joinable()) worker.join();
+    return result;
+}
+
+TrainingResult TrainingEngine::run(Perceptron& model, const Dataset& data, const TrainingOptions& options,
+    TrainingObserver* observer, const std::atomic<bool>* cancel, ThreadPool* pool)
+{
+    const auto t0 = std::chrono::steady_clock::now();
+    TrainingResult r;
+    if (data.cols() != model.inputSize())
+    {
+        r.ok = false;
+        r.error = "dataset has " + std::to_string(data.cols()) + " features, model expects "
+            + std::to_string(model.inputSize());
+        if (observer) observer->onFinished(r);
+        return r;
+    }
+
+    if (options.leastSquares)
+    {
+        // one pass + solve, reported as a single epoch
+        r.ok = fitLeastSquares(model, data, LeastSquaresOptions{ options.ridge, 0 }, pool, &r.error, &r.meanLoss);
+        if (r.ok)
+        {
+            r.epochs = 1;
+            r.samples = data.rows();
+            if (observer && options.progress != ProgressLevel::Summary)
+            {
+                EpochProgress p;
+                p.samples = r.samples;
+                p.meanLoss = r.meanLoss;
+                observer->onEpoch(p);
+            }
+        }
+        r.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        if (observer) observer->onFinished(r);
+        return r;
+    }
+
+    std::vector<size_t> order(data.rows());
+    std::iota(order.begin(), order.end(), static_cast<size_t>(0));
+    std::mt19937 rng(options.seed);
+    const bool perSample = observer && options.progress == ProgressLevel::Sample;
+    const bool perEpoch = observer && options.progress != ProgressLevel::Summary;
+
+    for (int e = 0; e < options.epochs && !r.cancelled; ++e)
+    {
+        if (options.shuffle) std::shuffle(order.begin(), order.end(), rng);
+
+        double epochLoss = 0.0;
+        size_t done = 0;
+        for (size_t i : order)
+        {
+            if (cancel && *cancel)
+            {
+                r.cancelled = true;
+                break;
+            }
+            if (perSample)
+            {
+                // the row as a vector only when someone wants the scores
+                const std::vector<double> x = data.rowVector(i);
+                SampleProgress p;
+                p.epoch = e;
+                p.row = i;
+                p.label = data.label(i);
+                p.scoreBefore = model.score(x);
+                const double grad = p.scoreBefore - p.label;
+                p.loss = 0.5 * grad * grad;
+                model.train(x, p.label);
+                p.scoreAfter = model.score(x);
+                epochLoss += p.loss;
+                observer->onSample(p);
+            }
+            else
+            {
+                epochLoss += model.trainBatch(data, &i, 1);
+            }
+            ++done;
+        }
+        if (r.cancelled) break;
+
+        r.epochs = e + 1;
+        r.samples = done;
+        r.meanLoss = done ? epochLoss / static_cast<double>(done) : 0.0;
+        if (perEpoch)
+        {
+            EpochProgress p;
+            p.epoch = e;
+            p.samples = done;
+            p.meanLoss = r.meanLoss;
+            observer->onEpoch(p);
+        }
+    }
+
+    r.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    if (observer) observer->onFinished(r);
+    return r;
+}
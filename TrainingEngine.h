@@ -0,0 +1,135 @@
+#pragma once
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Dataset.h"
+#include "Featurizer.h"
+#include "LogSink.h"
+#include "Perceptron.h"
+#include "StreamingTrainer.h"
+#include "ThreadPool.h"
+
+// How much progress a training run reports
+enum class ProgressLevel { Summary, Epoch, Sample };
+
+struct TrainingOptions
+{
+    int epochs = 10;
+    bool shuffle = false;        // reshuffle sample order every epoch (false = data order)
+    unsigned seed = 0;           // shuffle seed
+    bool leastSquares = false;   // closed-form ridge solve in one pass (LeastSquares.h); epochs/shuffle unused
+    double ridge = 1e-3;         // leastSquares: L2 penalty on the weights
+    ProgressLevel progress = ProgressLevel::Epoch;
+};
+
+// one training step (ProgressLevel::Sample)
+struct SampleProgress
+{
+    int epoch = 0;               // 0-based
+    size_t row = 0;              // row in the dataset
+    int label = 0;
+    double scoreBefore = 0.0;
+    double scoreAfter = 0.0;
+    double loss = 0.0;           // 0.5*(scoreBefore-label)^2
+};
+
+struct EpochProgress
+{
+    int epoch = 0;               // 0-based
+    size_t samples = 0;
+    size_t skipped = 0;          // streaming: unreadable files + bad manifest lines
+    double meanLoss = 0.0;       // measured before each update (least squares: after the solve)
+};
+
+struct TrainingResult
+{
+    bool ok = true;              // false: see error
+    bool cancelled = false;
+    int epochs = 0;              // epochs completed
+    size_t samples = 0;          // samples in the last epoch
+    size_t skipped = 0;
+    double meanLoss = 0.0;       // last epoch
+    double seconds = 0.0;
+    std::string error;
+    std::vector<std::string> problems;   // streaming: the first few skip reasons
+};
+
+// Progress callbacks. They run on the training thread, so keep them short:
+// write to a LogSink or post a message to the UI instead of touching it.
+class TrainingObserver
+{
+public:
+    virtual ~TrainingObserver() = default;
+    virtual void onSample(const SampleProgress&) {}
+    virtual void onEpoch(const EpochProgress&) {}
+    virtual void onFinished(const TrainingResult&) {}
+};
+
+// Formats progress as text lines into a LogSink
+class LogSinkObserver : public TrainingObserver
+{
+public:
+    explicit LogSinkObserver(LogSink& sink) : sink(sink) {}
+
+    void onSample(const SampleProgress& p) override;
+    void onEpoch(const EpochProgress& p) override;
+    void onFinished(const TrainingResult& r) override;
+
+private:
+    LogSink& sink;
+};
+
+// Runs the epoch loop on a worker thread and reports through a
+// TrainingObserver, so the caller (e.g. the GUI thread) never blocks on
+// training or on logging. Nothing here depends on a UI; run() does the same
+// work synchronously on the calling thread.
+//
+// The model is trained in place: leave it alone until the run has finished
+// (onFinished was called, or wait() returned).
+class TrainingEngine
+{
+public:
+    TrainingEngine() = default;
+    ~TrainingEngine();   // cancels a running job and joins it
+
+    TrainingEngine(const TrainingEngine&) = delete;
+    TrainingEngine& operator=(const TrainingEngine&) = delete;
+
+    // Train on an in-memory dataset (cols() must equal model.inputSize()).
+    // pool (optional) shards the least-squares pass. false if a previous run
+    // has not been waited for.
+    bool start(Perceptron& model, Dataset data, const TrainingOptions& options,
+        TrainingObserver* observer = nullptr, ThreadPool* pool = nullptr);
+
+    // Out-of-core training from a manifest (trainFromManifest). Progress is
+    // per epoch at most; ProgressLevel::Sample reports epochs.
+    bool startStreaming(Perceptron& model, const Featurizer& featurizer, const std::string& manifest,
+        ThreadPool& pool, const StreamingOptions& options, ProgressLevel progress,
+        TrainingObserver* observer = nullptr);
+
+    // Ask the run to stop after the current sample (streaming: epoch).
+    void cancel() { cancelRequested = true; }
+
+    // true from start() until onFinished has returned
+    bool running() const { return active; }
+
+    // Blocks until the run is over and returns its result.
+    TrainingResult wait();
+
+    // The in-memory training loop, on the calling thread. cancel (optional) is
+    // polled between samples; pool (optional) runs the least-squares pass.
+    static TrainingResult run(Perceptron& model, const Dataset& data, const TrainingOptions& options,
+        TrainingObserver* observer = nullptr, const std::atomic<bool>* cancel = nullptr,
+        ThreadPool* pool = nullptr);
+
+private:
+    bool launch();
+
+    std::thread worker;
+    std::atomic<bool> cancelRequested{ false };
+    std::atomic<bool> active{ false };
+    TrainingResult result;
+    Dataset data;
+    Featurizer featurizer;
+};
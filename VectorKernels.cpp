@@ -0,0 +1,980 @@
+#include "VectorKernels.h"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define KERNELS_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// GCC/Clang need per-function target attributes to emit AVX code from a file
+// compiled for baseline x86; MSVC accepts the intrinsics as-is.
+#if defined(__GNUC__) || defined(__clang__)
+#define KERNEL_TARGET(x) __attribute__((target(x)))
+#else
+#define KERNEL_TARGET(x)
+#endif
+
+namespace
+{
+    using kernels::Isa;
+
+    struct KernelTable
+    {
+        Isa isa;
+        double (*dotD)(const double*, const double*, size_t);
+        float (*dotF)(const float*, const float*, size_t);
+        double (*dotFD)(const float*, const double*, size_t);
+        void (*axpyD)(double, const double*, double*, size_t);
+        void (*axpyF)(float, const float*, float*, size_t);
+        void (*axpyFD)(double, const double*, float*, size_t);
+        void (*dotRows)(const double* const*, size_t, const double*, size_t, double*);
+        void (*axpyRows)(const double*, const double* const*, size_t, double*, size_t);
+        void (*gatherRows)(const double*, size_t, const uint32_t*, const double*, size_t, double*);
+        void (*scatterRows)(double*, size_t, const uint32_t*, const double*, size_t, const double*);
+        int64_t (*dotI8)(const int8_t*, const int8_t*, size_t);
+        int64_t (*gatherDotI8)(const int8_t*, const uint32_t*, const int8_t*, size_t);
+        bool (*toInt8Exact)(const double*, size_t, int8_t*);
+    };
+
+    // int8 kernels fold their int32 lanes into int64 after this many elements
+    constexpr size_t kI8Block = 65536;
+
+    KernelTable& table();
+
+    // ---------------- scalar (same order as the original loops) ----------------
+
+    double dotScalar(const double* a, const double* b, size_t n)
+    {
+        double s = 0.0;
+        for (size_t i = 0; i < n; ++i) s += a[i] * b[i];
+        return s;
+    }
+
+    float dotScalarF(const float* a, const float* b, size_t n)
+    {
+        float s = 0.0f;
+        for (size_t i = 0; i < n; ++i) s += a[i] * b[i];
+        return s;
+    }
+
+    double dotScalarFD(const float* w, const double* x, size_t n)
+    {
+        float s = 0.0f;
+        for (size_t i = 0; i < n; ++i) s += w[i] * static_cast<float>(x[i]);
+        return s;
+    }
+
+    void axpyScalar(double alpha, const double* x, double* y, size_t n)
+    {
+        for (size_t i = 0; i < n; ++i) y[i] += alpha * x[i];
+    }
+
+    void axpyScalarF(float alpha, const float* x, float* y, size_t n)
+    {
+        for (size_t i = 0; i < n; ++i) y[i] += alpha * x[i];
+    }
+
+    void axpyScalarFD(double alpha, const double* x, float* y, size_t n)
+    {
+        const float a = static_cast<float>(alpha);
+        for (size_t i = 0; i < n; ++i) y[i] += a * static_cast<float>(x[i]);
+    }
+
+    // generic batched forms: one single-row kernel call per row
+    void dotRowsGeneric(const double* const* rows, size_t count, const double* w, size_t n, double* out)
+    {
+        for (size_t r = 0; r < count; ++r) out[r] = table().dotD(rows[r], w, n);
+    }
+
+    void axpyRowsGeneric(const double* coeffs, const double* const* rows, size_t count, double* y, size_t n)
+    {
+        for (size_t r = 0; r < count; ++r) table().axpyD(coeffs[r], rows[r], y, n);
+    }
+
+    void gatherRowsScalar(const double* m, size_t stride, const uint32_t* idx, const double* val, size_t nnz, double* acc)
+    {
+        for (size_t k = 0; k < nnz; ++k)
+        {
+            const double* row = m + static_cast<size_t>(idx[k]) * stride;
+            for (size_t c = 0; c < stride; ++c) acc[c] += val[k] * row[c];
+        }
+    }
+
+    void scatterRowsScalar(double* m, size_t stride, const uint32_t* idx, const double* val, size_t nnz, const double* step)
+    {
+        for (size_t k = 0; k < nnz; ++k)
+        {
+            double* row = m + static_cast<size_t>(idx[k]) * stride;
+            for (size_t c = 0; c < stride; ++c) row[c] += val[k] * step[c];
+        }
+    }
+
+    int64_t dotI8Scalar(const int8_t* a, const int8_t* b, size_t n)
+    {
+        int64_t s = 0;
+        for (size_t i = 0; i < n; ++i) s += a[i] * b[i];
+        return s;
+    }
+
+    int64_t gatherDotI8Scalar(const int8_t* w, const uint32_t* idx, const int8_t* x, size_t nnz)
+    {
+        int64_t s = 0;
+        for (size_t k = 0; k < nnz; ++k) s += w[idx[k]] * x[k];
+        return s;
+    }
+
+    // clamp to [-127, 127] exactly like the SIMD paths (NaN ends up at -127,
+    // as max(NaN, lo) = lo), truncate, and compare the round trip with the input
+    bool toInt8ExactScalar(const double* x, size_t n, int8_t* out)
+    {
+        bool exact = true;
+        for (size_t i = 0; i < n; ++i)
+        {
+            const double v = x[i] > 127.0 ? 127.0 : (x[i] >= -127.0 ? x[i] : -127.0);
+            const int t = static_cast<int>(v);
+            exact &= (t == x[i]);
+            out[i] = static_cast<int8_t>(t);
+        }
+        return exact;
+    }
+
+#ifdef KERNELS_X86
+
+    // ---------------- SSE2 ----------------
+
+    KERNEL_TARGET("sse2") inline double hsum128(__m128d v)
+    {
+        return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+    }
+
+    KERNEL_TARGET("sse2") inline float hsum128(__m128 v)
+    {
+        __m128 t = _mm_add_ps(v, _mm_movehl_ps(v, v));
+        t = _mm_add_ss(t, _mm_shuffle_ps(t, t, 1));
+        return _mm_cvtss_f32(t);
+    }
+
+    // 4 doubles -> 4 floats
+    KERNEL_TARGET("sse2") inline __m128 load4AsFloat(const double* x)
+    {
+        return _mm_movelh_ps(_mm_cvtpd_ps(_mm_loadu_pd(x)), _mm_cvtpd_ps(_mm_loadu_pd(x + 2)));
+    }
+
+    KERNEL_TARGET("sse2") double dotSSE2(const double* a, const double* b, size_t n)
+    {
+        __m128d s0 = _mm_setzero_pd(), s1 = _mm_setzero_pd();
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4)
+        {
+            s0 = _mm_add_pd(s0, _mm_mul_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+            s1 = _mm_add_pd(s1, _mm_mul_pd(_mm_loadu_pd(a + i + 2), _mm_loadu_pd(b + i + 2)));
+        }
+        double s = hsum128(_mm_add_pd(s0, s1));
+        for (; i < n; ++i) s += a[i] * b[i];
+        return s;
+    }
+
+    KERNEL_TARGET("sse2") float dotSSE2F(const float* a, const float* b, size_t n)
+    {
+        __m128 s0 = _mm_setzero_ps(), s1 = _mm_setzero_ps();
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8)
+        {
+            s0 = _mm_add_ps(s0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+            s1 = _mm_add_ps(s1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+        }
+        float s = hsum128(_mm_add_ps(s0, s1));
+        for (; i < n; ++i) s += a[i] * b[i];
+        return s;
+    }
+
+    KERNEL_TARGET("sse2") double dotSSE2FD(const float* w, const double* x, size_t n)
+    {
+        __m128 s0 = _mm_setzero_ps();
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4)
+            s0 = _mm_add_ps(s0, _mm_mul_ps(_mm_loadu_ps(w + i), load4AsFloat(x + i)));
+        float s = hsum128(s0);
+        for (; i < n; ++i) s += w[i] * static_cast<float>(x[i]);
+        return s;
+    }
+
+    KERNEL_TARGET("sse2") void axpySSE2(double alpha, const double* x, double* y, size_t n)
+    {
+        const __m128d a = _mm_set1_pd(alpha);
+        size_t i = 0;
+        for (; i + 2 <= n; i += 2)
+            _mm_storeu_pd(y + i, _mm_add_pd(_mm_loadu_pd(y + i), _mm_mul_pd(a, _mm_loadu_pd(x + i))));
+        for (; i < n; ++i) y[i] += alpha * x[i];
+    }
+
+    KERNEL_TARGET("sse2") void axpySSE2F(float alpha, const float* x, float* y, size_t n)
+    {
+        const __m128 a = _mm_set1_ps(alpha);
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4)
+            _mm_storeu_ps(y + i, _mm_add_ps(_mm_loadu_ps(y + i), _mm_mul_ps(a, _mm_loadu_ps(x + i))));
+        for (; i < n; ++i) y[i] += alpha * x[i];
+    }
+
+    KERNEL_TARGET("sse2") void axpySSE2FD(double alpha, const double* x, float* y, size_t n)
+    {
+        const float af = static_cast<float>(alpha);
+        const __m128 a = _mm_set1_ps(af);
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4)
+            _mm_storeu_ps(y + i, _mm_add_ps(_mm_loadu_ps(y + i), _mm_mul_ps(a, load4AsFloat(x + i))));
+        for (; i < n; ++i) y[i] += af * static_cast<float>(x[i]);
+    }
+
+    KERNEL_TARGET("sse2") inline int64_t hsum128(__m128i v)
+    {
+        alignas(16) int32_t lanes[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), v);
+        return static_cast<int64_t>(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+    }
+
+    // int8 -> int16 by unpacking each byte into the high half and shifting back
+    KERNEL_TARGET("sse2") int64_t dotI8SSE2(const int8_t* a, const int8_t* b, size_t n)
+    {
+        int64_t s = 0;
+        size_t i = 0;
+        while (i + 16 <= n)
+        {
+            const size_t end = i + kI8Block < n ? i + kI8Block : n;
+            __m128i acc = _mm_setzero_si128();
+            for (; i + 16 <= end; i += 16)
+            {
+                const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+                const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+                const __m128i alo = _mm_srai_epi16(_mm_unpacklo_epi8(va, va), 8);
+                const __m128i ahi = _mm_srai_epi16(_mm_unpackhi_epi8(va, va), 8);
+                const __m128i blo = _mm_srai_epi16(_mm_unpacklo_epi8(vb, vb), 8);
+                const __m128i bhi = _mm_srai_epi16(_mm_unpackhi_epi8(vb, vb), 8);
+                acc = _mm_add_epi32(acc, _mm_madd_epi16(alo, blo));
+                acc = _mm_add_epi32(acc, _mm_madd_epi16(ahi, bhi));
+            }
+            s += hsum128(acc);
+        }
+        for (; i < n; ++i) s += a[i] * b[i];
+        return s;
+    }
+
+    // clamp to [-127, 127] (so a failed check cannot come from the clamp),
+    // truncate, and compare the round trip with the input
+    KERNEL_TARGET("sse2") bool toInt8ExactSSE2(const double* x, size_t n, int8_t* out)
+    {
+        const __m128d lo = _mm_set1_pd(-127.0), hi = _mm_set1_pd(127.0);
+        __m128d bad = _mm_setzero_pd();
+        size_t i = 0;
+        for (; i + 2 <= n; i += 2)
+        {
+            const __m128d v = _mm_loadu_pd(x + i);
+            const __m128i t = _mm_cvttpd_epi32(_mm_min_pd(_mm_max_pd(v, lo), hi));
+            bad = _mm_or_pd(bad, _mm_cmpneq_pd(_mm_cvtepi32_pd(t), v));
+            const __m128i b = _mm_packs_epi16(_mm_packs_epi32(t, t), t);
+            const uint16_t pair = static_cast<uint16_t>(_mm_cvtsi128_si32(b));
+            std::memcpy(out + i, &pair, sizeof(pair));
+        }
+        return (_mm_movemask_pd(bad) == 0) & toInt8ExactScalar(x + i, n - i, out + i);
+    }
+
+    // ---------------- AVX2 + FMA ----------------
+
+    KERNEL_TARGET("avx2,fma") inline double hsum256(__m256d v)
+    {
+        __m128d t = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+        return _mm_cvtsd_f64(_mm_add_sd(t, _mm_unpackhi_pd(t, t)));
+    }
+
+    KERNEL_TARGET("avx2,fma") inline float hsum256(__m256 v)
+    {
+        __m128 t = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+        t = _mm_add_ps(t, _mm_movehl_ps(t, t));
+        t = _mm_add_ss(t, _mm_shuffle_ps(t, t, 1));
+        return _mm_cvtss_f32(t);
+    }
+
+    // 8 doubles -> 8 floats
+    KERNEL_TARGET("avx2,fma") inline __m256 load8AsFloat(const double* x)
+    {
+        __m128 lo = _mm256_cvtpd_ps(_mm256_loadu_pd(x));
+        __m128 hi = _mm256_cvtpd_ps(_mm256_loadu_pd(x + 4));
+        return _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1);
+    }
+
+    KERNEL_TARGET("avx2,fma") double dotAVX2(const double* a, const double* b, size_t n)
+    {
+        __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+        __m256d s2 = _mm256_setzero_pd(), s3 = _mm256_setzero_pd();
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16)
+        {
+            s0 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i), s0);
+            s1 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i + 4), _mm256_loadu_pd(b + i + 4), s1);
+            s2 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i + 8), _mm256_loadu_pd(b + i + 8), s2);
+            s3 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i + 12), _mm256_loadu_pd(b + i + 12), s3);
+        }
+        for (; i + 4 <= n; i += 4)
+            s0 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i), s0);
+        double s = hsum256(_mm256_add_pd(_mm256_add_pd(s0, s1), _mm256_add_pd(s2, s3)));
+        for (; i < n; ++i) s += a[i] * b[i];
+        return s;
+    }
+
+    KERNEL_TARGET("avx2,fma") float dotAVX2F(const float* a, const float* b, size_t n)
+    {
+        __m256 s0 = _mm256_setzero_ps(), s1 = _mm256_setzero_ps();
+        __m256 s2 = _mm256_setzero_ps(), s3 = _mm256_setzero_ps();
+        size_t i = 0;
+        for (; i + 32 <= n; i += 32)
+        {
+            s0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), s0);
+            s1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), s1);
+            s2 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 16), _mm256_loadu_ps(b + i + 16), s2);
+            s3 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 24), _mm256_loadu_ps(b + i + 24), s3);
+        }
+        for (; i + 8 <= n; i += 8)
+            s0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), s0);
+        float s = hsum256(_mm256_add_ps(_mm256_add_ps(s0, s1), _mm256_add_ps(s2, s3)));
+        for (; i < n; ++i) s += a[i] * b[i];
+        return s;
+    }
+
+    KERNEL_TARGET("avx2,fma") double dotAVX2FD(const float* w, const double* x, size_t n)
+    {
+        __m256 s0 = _mm256_setzero_ps(), s1 = _mm256_setzero_ps();
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16)
+        {
+            s0 = _mm256_fmadd_ps(_mm256_loadu_ps(w + i), load8AsFloat(x + i), s0);
+            s1 = _mm256_fmadd_ps(_mm256_loadu_ps(w + i + 8), load8AsFloat(x + i + 8), s1);
+        }
+        for (; i + 8 <= n; i += 8)
+            s0 = _mm256_fmadd_ps(_mm256_loadu_ps(w + i), load8AsFloat(x + i), s0);
+        float s = hsum256(_mm256_add_ps(s0, s1));
+        for (; i < n; ++i) s += w[i] * static_cast<float>(x[i]);
+        return s;
+    }
+
+    KERNEL_TARGET("avx2,fma") void axpyAVX2(double alpha, const double* x, double* y, size_t n)
+    {
+        const __m256d a = _mm256_set1_pd(alpha);
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4)
+            _mm256_storeu_pd(y + i, _mm256_fmadd_pd(a, _mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+        for (; i < n; ++i) y[i] += alpha * x[i];
+    }
+
+    KERNEL_TARGET("avx2,fma") void axpyAVX2F(float alpha, const float* x, float* y, size_t n)
+    {
+        const __m256 a = _mm256_set1_ps(alpha);
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8)
+            _mm256_storeu_ps(y + i, _mm256_fmadd_ps(a, _mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i)));
+        for (; i < n; ++i) y[i] += alpha * x[i];
+    }
+
+    KERNEL_TARGET("avx2,fma") void axpyAVX2FD(double alpha, const double* x, float* y, size_t n)
+    {
+        const float af = static_cast<float>(alpha);
+        const __m256 a = _mm256_set1_ps(af);
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8)
+            _mm256_storeu_ps(y + i, _mm256_fmadd_ps(a, load8AsFloat(x + i), _mm256_loadu_ps(y + i)));
+        for (; i < n; ++i) y[i] += af * static_cast<float>(x[i]);
+    }
+
+    KERNEL_TARGET("avx2,fma") void dotRowsAVX2(const double* const* rows, size_t count,
+        const double* w, size_t n, double* out)
+    {
+        size_t r = 0;
+        for (; r + 4 <= count; r += 4)
+        {
+            const double* a0 = rows[r];
+            const double* a1 = rows[r + 1];
+            const double* a2 = rows[r + 2];
+            const double* a3 = rows[r + 3];
+            __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+            __m256d s2 = _mm256_setzero_pd(), s3 = _mm256_setzero_pd();
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4)
+            {
+                const __m256d wv = _mm256_loadu_pd(w + i);
+                s0 = _mm256_fmadd_pd(_mm256_loadu_pd(a0 + i), wv, s0);
+                s1 = _mm256_fmadd_pd(_mm256_loadu_pd(a1 + i), wv, s1);
+                s2 = _mm256_fmadd_pd(_mm256_loadu_pd(a2 + i), wv, s2);
+                s3 = _mm256_fmadd_pd(_mm256_loadu_pd(a3 + i), wv, s3);
+            }
+            double d0 = hsum256(s0), d1 = hsum256(s1), d2 = hsum256(s2), d3 = hsum256(s3);
+            for (; i < n; ++i)
+            {
+                d0 += a0[i] * w[i];
+                d1 += a1[i] * w[i];
+                d2 += a2[i] * w[i];
+                d3 += a3[i] * w[i];
+            }
+            out[r] = d0;
+            out[r + 1] = d1;
+            out[r + 2] = d2;
+            out[r + 3] = d3;
+        }
+        for (; r < count; ++r) out[r] = dotAVX2(rows[r], w, n);
+    }
+
+    KERNEL_TARGET("avx2,fma") void axpyRowsAVX2(const double* coeffs, const double* const* rows,
+        size_t count, double* y, size_t n)
+    {
+        size_t r = 0;
+        for (; r + 4 <= count; r += 4)
+        {
+            const double* a0 = rows[r];
+            const double* a1 = rows[r + 1];
+            const double* a2 = rows[r + 2];
+            const double* a3 = rows[r + 3];
+            const __m256d c0 = _mm256_set1_pd(coeffs[r]), c1 = _mm256_set1_pd(coeffs[r + 1]);
+            const __m256d c2 = _mm256_set1_pd(coeffs[r + 2]), c3 = _mm256_set1_pd(coeffs[r + 3]);
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4)
+            {
+                __m256d acc = _mm256_loadu_pd(y + i);
+                acc = _mm256_fmadd_pd(c0, _mm256_loadu_pd(a0 + i), acc);
+                acc = _mm256_fmadd_pd(c1, _mm256_loadu_pd(a1 + i), acc);
+                acc = _mm256_fmadd_pd(c2, _mm256_loadu_pd(a2 + i), acc);
+                acc = _mm256_fmadd_pd(c3, _mm256_loadu_pd(a3 + i), acc);
+                _mm256_storeu_pd(y + i, acc);
+            }
+            for (; i < n; ++i)
+                y[i] += coeffs[r] * a0[i] + coeffs[r + 1] * a1[i] + coeffs[r + 2] * a2[i] + coeffs[r + 3] * a3[i];
+        }
+        for (; r < count; ++r) axpyAVX2(coeffs[r], rows[r], y, n);
+    }
+
+    // 16 output columns (4 registers) per pass over the rows, then 4 at a time
+    KERNEL_TARGET("avx2,fma") void gatherRowsAVX2(const double* m, size_t stride, const uint32_t* idx,
+        const double* val, size_t nnz, double* acc)
+    {
+        size_t c = 0;
+        for (; c + 16 <= stride; c += 16)
+        {
+            __m256d a0 = _mm256_loadu_pd(acc + c), a1 = _mm256_loadu_pd(acc + c + 4);
+            __m256d a2 = _mm256_loadu_pd(acc + c + 8), a3 = _mm256_loadu_pd(acc + c + 12);
+            for (size_t k = 0; k < nnz; ++k)
+            {
+                const double* row = m + static_cast<size_t>(idx[k]) * stride + c;
+                const __m256d v = _mm256_set1_pd(val[k]);
+                a0 = _mm256_fmadd_pd(v, _mm256_loadu_pd(row), a0);
+                a1 = _mm256_fmadd_pd(v, _mm256_loadu_pd(row + 4), a1);
+                a2 = _mm256_fmadd_pd(v, _mm256_loadu_pd(row + 8), a2);
+                a3 = _mm256_fmadd_pd(v, _mm256_loadu_pd(row + 12), a3);
+            }
+            _mm256_storeu_pd(acc + c, a0);
+            _mm256_storeu_pd(acc + c + 4, a1);
+            _mm256_storeu_pd(acc + c + 8, a2);
+            _mm256_storeu_pd(acc + c + 12, a3);
+        }
+        for (; c < stride; c += 4)
+        {
+            __m256d a = _mm256_loadu_pd(acc + c);
+            for (size_t k = 0; k < nnz; ++k)
+                a = _mm256_fmadd_pd(_mm256_set1_pd(val[k]), _mm256_loadu_pd(m + static_cast<size_t>(idx[k]) * stride + c), a);
+            _mm256_storeu_pd(acc + c, a);
+        }
+    }
+
+    KERNEL_TARGET("avx2,fma") void scatterRowsAVX2(double* m, size_t stride, const uint32_t* idx,
+        const double* val, size_t nnz, const double* step)
+    {
+        size_t c = 0;
+        for (; c + 16 <= stride; c += 16)
+        {
+            const __m256d s0 = _mm256_loadu_pd(step + c), s1 = _mm256_loadu_pd(step + c + 4);
+            const __m256d s2 = _mm256_loadu_pd(step + c + 8), s3 = _mm256_loadu_pd(step + c + 12);
+            for (size_t k = 0; k < nnz; ++k)
+            {
+                double* row = m + static_cast<size_t>(idx[k]) * stride + c;
+                const __m256d v = _mm256_set1_pd(val[k]);
+                _mm256_storeu_pd(row, _mm256_fmadd_pd(v, s0, _mm256_loadu_pd(row)));
+                _mm256_storeu_pd(row + 4, _mm256_fmadd_pd(v, s1, _mm256_loadu_pd(row + 4)));
+                _mm256_storeu_pd(row + 8, _mm256_fmadd_pd(v, s2, _mm256_loadu_pd(row + 8)));
+                _mm256_storeu_pd(row + 12, _mm256_fmadd_pd(v, s3, _mm256_loadu_pd(row + 12)));
+            }
+        }
+        for (; c < stride; c += 4)
+        {
+            const __m256d s = _mm256_loadu_pd(step + c);
+            for (size_t k = 0; k < nnz; ++k)
+            {
+                double* row = m + static_cast<size_t>(idx[k]) * stride + c;
+                _mm256_storeu_pd(row, _mm256_fmadd_pd(_mm256_set1_pd(val[k]), s, _mm256_loadu_pd(row)));
+            }
+        }
+    }
+
+    KERNEL_TARGET("avx2") inline int64_t hsum256(__m256i v)
+    {
+        alignas(32) int32_t lanes[8];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), v);
+        int64_t s = 0;
+        for (int32_t l : lanes) s += l;
+        return s;
+    }
+
+    // sign-extend to int16, then multiply-add pairs into int32 lanes
+    KERNEL_TARGET("avx2") int64_t dotI8AVX2(const int8_t* a, const int8_t* b, size_t n)
+    {
+        int64_t s = 0;
+        size_t i = 0;
+        while (i + 32 <= n)
+        {
+            const size_t end = i + kI8Block < n ? i + kI8Block : n;
+            __m256i acc0 = _mm256_setzero_si256(), acc1 = _mm256_setzero_si256();
+            for (; i + 32 <= end; i += 32)
+            {
+                const __m256i a0 = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i)));
+                const __m256i b0 = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i)));
+                const __m256i a1 = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i + 16)));
+                const __m256i b1 = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i + 16)));
+                acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(a0, b0));
+                acc1 = _mm256_add_epi32(acc1, _mm256_madd_epi16(a1, b1));
+            }
+            s += hsum256(_mm256_add_epi32(acc0, acc1));
+        }
+        for (; i < n; ++i) s += a[i] * b[i];
+        return s;
+    }
+
+    // 8 weights per gather: each lane loads the 4 bytes at w + idx and keeps
+    // the sign-extended low byte
+    KERNEL_TARGET("avx2") int64_t gatherDotI8AVX2(const int8_t* w, const uint32_t* idx, const int8_t* x, size_t nnz)
+    {
+        const int* base = reinterpret_cast<const int*>(w);
+        int64_t s = 0;
+        size_t k = 0;
+        while (k + 8 <= nnz)
+        {
+            const size_t end = k + kI8Block < nnz ? k + kI8Block : nnz;
+            __m256i acc = _mm256_setzero_si256();
+            for (; k + 8 <= end; k += 8)
+            {
+                const __m256i vi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(idx + k));
+                __m256i vw = _mm256_i32gather_epi32(base, vi, 1);
+                vw = _mm256_srai_epi32(_mm256_slli_epi32(vw, 24), 24);
+                const __m256i vx = _mm256_cvtepi8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(x + k)));
+                acc = _mm256_add_epi32(acc, _mm256_mullo_epi32(vw, vx));
+            }
+            s += hsum256(acc);
+        }
+        for (; k < nnz; ++k) s += w[idx[k]] * x[k];
+        return s;
+    }
+
+    KERNEL_TARGET("avx2") bool toInt8ExactAVX2(const double* x, size_t n, int8_t* out)
+    {
+        const __m256d lo = _mm256_set1_pd(-127.0), hi = _mm256_set1_pd(127.0);
+        __m256d bad = _mm256_setzero_pd();
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4)
+        {
+            const __m256d v = _mm256_loadu_pd(x + i);
+            const __m128i t = _mm256_cvttpd_epi32(_mm256_min_pd(_mm256_max_pd(v, lo), hi));
+            bad = _mm256_or_pd(bad, _mm256_cmp_pd(_mm256_cvtepi32_pd(t), v, _CMP_NEQ_UQ));
+            const __m128i b = _mm_packs_epi16(_mm_packs_epi32(t, t), t);
+            const int32_t quad = _mm_cvtsi128_si32(b);
+            std::memcpy(out + i, &quad, sizeof(quad));
+        }
+        return (_mm256_movemask_pd(bad) == 0) & toInt8ExactScalar(x + i, n - i, out + i);
+    }
+
+    // ---------------- AVX-512F ----------------
+
+    // GCC 12's AVX-512 headers seed some intrinsics with self-initialized
+    // "undefined" vectors, which trips -Wuninitialized at every call site.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+    // 16 doubles -> 16 floats
+    KERNEL_TARGET("avx512f") inline __m512 load16AsFloat(const double* x)
+    {
+        __m256 lo = _mm512_cvtpd_ps(_mm512_loadu_pd(x));
+        __m256 hi = _mm512_cvtpd_ps(_mm512_loadu_pd(x + 8));
+        return _mm512_castpd_ps(_mm512_insertf64x4(
+            _mm512_castps_pd(_mm512_castps256_ps512(lo)), _mm256_castps_pd(hi), 1));
+    }
+
+    KERNEL_TARGET("avx512f") double dotAVX512(const double* a, const double* b, size_t n)
+    {
+        __m512d s0 = _mm512_setzero_pd(), s1 = _mm512_setzero_pd();
+        __m512d s2 = _mm512_setzero_pd(), s3 = _mm512_setzero_pd();
+        size_t i = 0;
+        for (; i + 32 <= n; i += 32)
+        {
+            s0 = _mm512_fmadd_pd(_mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i), s0);
+            s1 = _mm512_fmadd_pd(_mm512_loadu_pd(a + i + 8), _mm512_loadu_pd(b + i + 8), s1);
+            s2 = _mm512_fmadd_pd(_mm512_loadu_pd(a + i + 16), _mm512_loadu_pd(b + i + 16), s2);
+            s3 = _mm512_fmadd_pd(_mm512_loadu_pd(a + i + 24), _mm512_loadu_pd(b + i + 24), s3);
+        }
+        for (; i + 8 <= n; i += 8)
+            s0 = _mm512_fmadd_pd(_mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i), s0);
+        if (i < n)
+        {
+            const __mmask8 m = static_cast<__mmask8>((1u << (n - i)) - 1);
+            s1 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(m, a + i), _mm512_maskz_loadu_pd(m, b + i), s1);
+        }
+        return _mm512_reduce_add_pd(_mm512_add_pd(_mm512_add_pd(s0, s1), _mm512_add_pd(s2, s3)));
+    }
+
+    KERNEL_TARGET("avx512f") float dotAVX512F(const float* a, const float* b, size_t n)
+    {
+        __m512 s0 = _mm512_setzero_ps(), s1 = _mm512_setzero_ps();
+        __m512 s2 = _mm512_setzero_ps(), s3 = _mm512_setzero_ps();
+        size_t i = 0;
+        for (; i + 64 <= n; i += 64)
+        {
+            s0 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i), s0);
+            s1 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i + 16), _mm512_loadu_ps(b + i + 16), s1);
+            s2 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i + 32), _mm512_loadu_ps(b + i + 32), s2);
+            s3 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i + 48), _mm512_loadu_ps(b + i + 48), s3);
+        }
+        for (; i + 16 <= n; i += 16)
+            s0 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i), s0);
+        if (i < n)
+        {
+            const __mmask16 m = static_cast<__mmask16>((1u << (n - i)) - 1);
+            s1 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(m, a + i), _mm512_maskz_loadu_ps(m, b + i), s1);
+        }
+        return _mm512_reduce_add_ps(_mm512_add_ps(_mm512_add_ps(s0, s1), _mm512_add_ps(s2, s3)));
+    }
+
+    KERNEL_TARGET("avx512f") double dotAVX512FD(const float* w, const double* x, size_t n)
+    {
+        __m512 s0 = _mm512_setzero_ps(), s1 = _mm512_setzero_ps();
+        size_t i = 0;
+        for (; i + 32 <= n; i += 32)
+        {
+            s0 = _mm512_fmadd_ps(_mm512_loadu_ps(w + i), load16AsFloat(x + i), s0);
+            s1 = _mm512_fmadd_ps(_mm512_loadu_ps(w + i + 16), load16AsFloat(x + i + 16), s1);
+        }
+        for (; i + 16 <= n; i += 16)
+            s0 = _mm512_fmadd_ps(_mm512_loadu_ps(w + i), load16AsFloat(x + i), s0);
+        float s = _mm512_reduce_add_ps(_mm512_add_ps(s0, s1));
+        for (; i < n; ++i) s += w[i] * static_cast<float>(x[i]);
+        return s;
+    }
+
+    KERNEL_TARGET("avx512f") void axpyAVX512(double alpha, const double* x, double* y, size_t n)
+    {
+        const __m512d a = _mm512_set1_pd(alpha);
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8)
+            _mm512_storeu_pd(y + i, _mm512_fmadd_pd(a, _mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i)));
+        if (i < n)
+        {
+            const __mmask8 m = static_cast<__mmask8>((1u << (n - i)) - 1);
+            _mm512_mask_storeu_pd(y + i, m,
+                _mm512_fmadd_pd(a, _mm512_maskz_loadu_pd(m, x + i), _mm512_maskz_loadu_pd(m, y + i)));
+        }
+    }
+
+    KERNEL_TARGET("avx512f") void axpyAVX512F(float alpha, const float* x, float* y, size_t n)
+    {
+        const __m512 a = _mm512_set1_ps(alpha);
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16)
+            _mm512_storeu_ps(y + i, _mm512_fmadd_ps(a, _mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i)));
+        if (i < n)
+        {
+            const __mmask16 m = static_cast<__mmask16>((1u << (n - i)) - 1);
+            _mm512_mask_storeu_ps(y + i, m,
+                _mm512_fmadd_ps(a, _mm512_maskz_loadu_ps(m, x + i), _mm512_maskz_loadu_ps(m, y + i)));
+        }
+    }
+
+    KERNEL_TARGET("avx512f") void axpyAVX512FD(double alpha, const double* x, float* y, size_t n)
+    {
+        const float af = static_cast<float>(alpha);
+        const __m512 a = _mm512_set1_ps(af);
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16)
+            _mm512_storeu_ps(y + i, _mm512_fmadd_ps(a, load16AsFloat(x + i), _mm512_loadu_ps(y + i)));
+        for (; i < n; ++i) y[i] += af * static_cast<float>(x[i]);
+    }
+
+    KERNEL_TARGET("avx512f") void dotRowsAVX512(const double* const* rows, size_t count,
+        const double* w, size_t n, double* out)
+    {
+        size_t r = 0;
+        for (; r + 4 <= count; r += 4)
+        {
+            const double* a0 = rows[r];
+            const double* a1 = rows[r + 1];
+            const double* a2 = rows[r + 2];
+            const double* a3 = rows[r + 3];
+            __m512d s0 = _mm512_setzero_pd(), s1 = _mm512_setzero_pd();
+            __m512d s2 = _mm512_setzero_pd(), s3 = _mm512_setzero_pd();
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8)
+            {
+                const __m512d wv = _mm512_loadu_pd(w + i);
+                s0 = _mm512_fmadd_pd(_mm512_loadu_pd(a0 + i), wv, s0);
+                s1 = _mm512_fmadd_pd(_mm512_loadu_pd(a1 + i), wv, s1);
+                s2 = _mm512_fmadd_pd(_mm512_loadu_pd(a2 + i), wv, s2);
+                s3 = _mm512_fmadd_pd(_mm512_loadu_pd(a3 + i), wv, s3);
+            }
+            if (i < n)
+            {
+                const __mmask8 m = static_cast<__mmask8>((1u << (n - i)) - 1);
+                const __m512d wv = _mm512_maskz_loadu_pd(m, w + i);
+                s0 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(m, a0 + i), wv, s0);
+                s1 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(m, a1 + i), wv, s1);
+                s2 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(m, a2 + i), wv, s2);
+                s3 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(m, a3 + i), wv, s3);
+            }
+            out[r] = _mm512_reduce_add_pd(s0);
+            out[r + 1] = _mm512_reduce_add_pd(s1);
+            out[r + 2] = _mm512_reduce_add_pd(s2);
+            out[r + 3] = _mm512_reduce_add_pd(s3);
+        }
+        for (; r < count; ++r) out[r] = dotAVX512(rows[r], w, n);
+    }
+
+    KERNEL_TARGET("avx512f") void axpyRowsAVX512(const double* coeffs, const double* const* rows,
+        size_t count, double* y, size_t n)
+    {
+        size_t r = 0;
+        for (; r + 4 <= count; r += 4)
+        {
+            const double* a0 = rows[r];
+            const double* a1 = rows[r + 1];
+            const double* a2 = rows[r + 2];
+            const double* a3 = rows[r + 3];
+            const __m512d c0 = _mm512_set1_pd(coeffs[r]), c1 = _mm512_set1_pd(coeffs[r + 1]);
+            const __m512d c2 = _mm512_set1_pd(coeffs[r + 2]), c3 = _mm512_set1_pd(coeffs[r + 3]);
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8)
+            {
+                __m512d acc = _mm512_loadu_pd(y + i);
+                acc = _mm512_fmadd_pd(c0, _mm512_loadu_pd(a0 + i), acc);
+                acc = _mm512_fmadd_pd(c1, _mm512_loadu_pd(a1 + i), acc);
+                acc = _mm512_fmadd_pd(c2, _mm512_loadu_pd(a2 + i), acc);
+                acc = _mm512_fmadd_pd(c3, _mm512_loadu_pd(a3 + i), acc);
+                _mm512_storeu_pd(y + i, acc);
+            }
+            if (i < n)
+            {
+                const __mmask8 m = static_cast<__mmask8>((1u << (n - i)) - 1);
+                __m512d acc = _mm512_maskz_loadu_pd(m, y + i);
+                acc = _mm512_fmadd_pd(c0, _mm512_maskz_loadu_pd(m, a0 + i), acc);
+                acc = _mm512_fmadd_pd(c1, _mm512_maskz_loadu_pd(m, a1 + i), acc);
+                acc = _mm512_fmadd_pd(c2, _mm512_maskz_loadu_pd(m, a2 + i), acc);
+                acc = _mm512_fmadd_pd(c3, _mm512_maskz_loadu_pd(m, a3 + i), acc);
+                _mm512_mask_storeu_pd(y + i, m, acc);
+            }
+        }
+        for (; r < count; ++r) axpyAVX512(coeffs[r], rows[r], y, n);
+    }
+
+    // 32 output columns (4 registers) per pass over the rows, then 8 at a time
+    KERNEL_TARGET("avx512f") void gatherRowsAVX512(const double* m, size_t stride, const uint32_t* idx,
+        const double* val, size_t nnz, double* acc)
+    {
+        size_t c = 0;
+        for (; c + 32 <= stride; c += 32)
+        {
+            __m512d a0 = _mm512_loadu_pd(acc + c), a1 = _mm512_loadu_pd(acc + c + 8);
+            __m512d a2 = _mm512_loadu_pd(acc + c + 16), a3 = _mm512_loadu_pd(acc + c + 24);
+            for (size_t k = 0; k < nnz; ++k)
+            {
+                const double* row = m + static_cast<size_t>(idx[k]) * stride + c;
+                const __m512d v = _mm512_set1_pd(val[k]);
+                a0 = _mm512_fmadd_pd(v, _mm512_loadu_pd(row), a0);
+                a1 = _mm512_fmadd_pd(v, _mm512_loadu_pd(row + 8), a1);
+                a2 = _mm512_fmadd_pd(v, _mm512_loadu_pd(row + 16), a2);
+                a3 = _mm512_fmadd_pd(v, _mm512_loadu_pd(row + 24), a3);
+            }
+            _mm512_storeu_pd(acc + c, a0);
+            _mm512_storeu_pd(acc + c + 8, a1);
+            _mm512_storeu_pd(acc + c + 16, a2);
+            _mm512_storeu_pd(acc + c + 24, a3);
+        }
+        for (; c < stride; c += 8)
+        {
+            __m512d a = _mm512_loadu_pd(acc + c);
+            for (size_t k = 0; k < nnz; ++k)
+                a = _mm512_fmadd_pd(_mm512_set1_pd(val[k]), _mm512_loadu_pd(m + static_cast<size_t>(idx[k]) * stride + c), a);
+            _mm512_storeu_pd(acc + c, a);
+        }
+    }
+
+    KERNEL_TARGET("avx512f") void scatterRowsAVX512(double* m, size_t stride, const uint32_t* idx,
+        const double* val, size_t nnz, const double* step)
+    {
+        size_t c = 0;
+        for (; c + 32 <= stride; c += 32)
+        {
+            const __m512d s0 = _mm512_loadu_pd(step + c), s1 = _mm512_loadu_pd(step + c + 8);
+            const __m512d s2 = _mm512_loadu_pd(step + c + 16), s3 = _mm512_loadu_pd(step + c + 24);
+            for (size_t k = 0; k < nnz; ++k)
+            {
+                double* row = m + static_cast<size_t>(idx[k]) * stride + c;
+                const __m512d v = _mm512_set1_pd(val[k]);
+                _mm512_storeu_pd(row, _mm512_fmadd_pd(v, s0, _mm512_loadu_pd(row)));
+                _mm512_storeu_pd(row + 8, _mm512_fmadd_pd(v, s1, _mm512_loadu_pd(row + 8)));
+                _mm512_storeu_pd(row + 16, _mm512_fmadd_pd(v, s2, _mm512_loadu_pd(row + 16)));
+                _mm512_storeu_pd(row + 24, _mm512_fmadd_pd(v, s3, _mm512_loadu_pd(row + 24)));
+            }
+        }
+        for (; c < stride; c += 8)
+        {
+            const __m512d s = _mm512_loadu_pd(step + c);
+            for (size_t k = 0; k < nnz; ++k)
+            {
+                double* row = m + static_cast<size_t>(idx[k]) * stride + c;
+                _mm512_storeu_pd(row, _mm512_fmadd_pd(_mm512_set1_pd(val[k]), s, _mm512_loadu_pd(row)));
+            }
+        }
+    }
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+    Isa detectIsa()
+    {
+#if defined(_MSC_VER) && !defined(__clang__)
+        int info[4];
+        __cpuid(info, 0);
+        const int maxLeaf = info[0];
+        __cpuid(info, 1);
+        const bool sse2 = (info[3] & (1 << 26)) != 0;
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        const bool avx = (info[2] & (1 << 28)) != 0;
+        const bool fma = (info[2] & (1 << 12)) != 0;
+        bool avx2 = false, avx512 = false;
+        if (osxsave && avx && maxLeaf >= 7)
+        {
+            const unsigned long long xcr0 = _xgetbv(0);
+            __cpuidex(info, 7, 0);
+            avx2 = fma && (xcr0 & 0x6) == 0x6 && (info[1] & (1 << 5)) != 0;
+            avx512 = (xcr0 & 0xE6) == 0xE6 && (info[1] & (1 << 16)) != 0;
+        }
+#else
+        __builtin_cpu_init();
+        const bool sse2 = __builtin_cpu_supports("sse2");
+        const bool avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+        const bool avx512 = __builtin_cpu_supports("avx512f");
+#endif
+        if (avx512) return Isa::AVX512;
+        if (avx2) return Isa::AVX2;
+        if (sse2) return Isa::SSE2;
+        return Isa::Scalar;
+    }
+
+#else // !KERNELS_X86
+
+    Isa detectIsa() { return Isa::Scalar; }
+
+#endif
+
+    KernelTable makeTable(Isa isa)
+    {
+        switch (isa)
+        {
+#ifdef KERNELS_X86
+        case Isa::AVX512:
+            return { isa, dotAVX512, dotAVX512F, dotAVX512FD, axpyAVX512, axpyAVX512F, axpyAVX512FD,
+                dotRowsAVX512, axpyRowsAVX512, gatherRowsAVX512, scatterRowsAVX512,
+                dotI8AVX2, gatherDotI8AVX2, toInt8ExactAVX2 };   // AVX-512F has no byte/word multiply-add
+        case Isa::AVX2:
+            return { isa, dotAVX2, dotAVX2F, dotAVX2FD, axpyAVX2, axpyAVX2F, axpyAVX2FD,
+                dotRowsAVX2, axpyRowsAVX2, gatherRowsAVX2, scatterRowsAVX2,
+                dotI8AVX2, gatherDotI8AVX2, toInt8ExactAVX2 };
+        case Isa::SSE2:
+            return { isa, dotSSE2, dotSSE2F, dotSSE2FD, axpySSE2, axpySSE2F, axpySSE2FD,
+                dotRowsGeneric, axpyRowsGeneric, gatherRowsScalar, scatterRowsScalar,
+                dotI8SSE2, gatherDotI8Scalar, toInt8ExactSSE2 };
+#endif
+        default:
+            return { Isa::Scalar, dotScalar, dotScalarF, dotScalarFD, axpyScalar, axpyScalarF, axpyScalarFD,
+                dotRowsGeneric, axpyRowsGeneric, gatherRowsScalar, scatterRowsScalar,
+                dotI8Scalar, gatherDotI8Scalar, toInt8ExactScalar };
+        }
+    }
+
+    Isa detectedIsa()
+    {
+        static const Isa isa = detectIsa();
+        return isa;
+    }
+
+    KernelTable& table()
+    {
+        static KernelTable t = makeTable(detectedIsa());
+        return t;
+    }
+}
+
+namespace kernels
+{
+    Isa activeIsa() { return table().isa; }
+
+    const char* isaName(Isa isa)
+    {
+        switch (isa)
+        {
+        case Isa::AVX512: return "avx512";
+        case Isa::AVX2:   return "avx2";
+        case Isa::SSE2:   return "sse2";
+        default:          return "scalar";
+        }
+    }
+
+    void forceIsa(Isa isa)
+    {
+        if (static_cast<int>(isa) > static_cast<int>(detectedIsa())) isa = detectedIsa();
+        table() = makeTable(isa);
+    }
+
+    double dot(const double* a, const double* b, size_t n) { return table().dotD(a, b, n); }
+    float dot(const float* a, const float* b, size_t n) { return table().dotF(a, b, n); }
+    double dot(const float* w, const double* x, size_t n) { return table().dotFD(w, x, n); }
+
+    void axpy(double alpha, const double* x, double* y, size_t n) { table().axpyD(alpha, x, y, n); }
+    void axpy(float alpha, const float* x, float* y, size_t n) { table().axpyF(alpha, x, y, n); }
+    void axpy(double alpha, const double* x, float* y, size_t n) { table().axpyFD(alpha, x, y, n); }
+
+    void dotRows(const double* const* rows, size_t count, const double* w, size_t n, double* out)
+    {
+        table().dotRows(rows, count, w, n, out);
+    }
+
+    void axpyRows(const double* coeffs, const double* const* rows, size_t count, double* y, size_t n)
+    {
+        table().axpyRows(coeffs, rows, count, y, n);
+    }
+
+    void gatherRows(const double* m, size_t stride, const uint32_t* idx, const double* val, size_t nnz, double* acc)
+    {
+        table().gatherRows(m, stride, idx, val, nnz, acc);
+    }
+
+    void scatterRows(double* m, size_t stride, const uint32_t* idx, const double* val, size_t nnz, const double* step)
+    {
+        table().scatterRows(m, stride, idx, val, nnz, step);
+    }
+
+    int64_t dotI8(const int8_t* a, const int8_t* b, size_t n) { return table().dotI8(a, b, n); }
+
+    int64_t gatherDotI8(const int8_t* w, const uint32_t* idx, const int8_t* x, size_t nnz)
+    {
+        return table().gatherDotI8(w, idx, x, nnz);
+    }
+
+    bool toInt8Exact(const double* x, size_t n, int8_t* out) { return table().toInt8Exact(x, n, out); }
+}
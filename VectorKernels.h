@@ -0,0 +1,63 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Dense vector kernels used by Perceptron::score / Perceptron::train.
+// The implementation (AVX-512, AVX2+FMA, SSE2 or scalar) is picked once at
+// startup from CPUID; every call after that is a single indirect jump.
+// SIMD versions sum in a different order than a plain loop, so results can
+// differ from the scalar path in the last bits.
+namespace kernels
+{
+    enum class Isa { Scalar, SSE2, AVX2, AVX512 };
+
+    // instruction set the kernels currently dispatch to
+    Isa activeIsa();
+    const char* isaName(Isa isa);
+
+    // Force a specific implementation (e.g. Scalar for bit-reproducible runs).
+    // Requests above what the CPU supports are clamped. Not thread-safe: call
+    // before any kernel is used concurrently.
+    void forceIsa(Isa isa);
+
+    // sum(a[i] * b[i])
+    double dot(const double* a, const double* b, size_t n);
+    float dot(const float* a, const float* b, size_t n);
+    // float weights against double features, accumulated in float
+    double dot(const float* w, const double* x, size_t n);
+
+    // y[i] += alpha * x[i]
+    void axpy(double alpha, const double* x, double* y, size_t n);
+    void axpy(float alpha, const float* x, float* y, size_t n);
+    // float weights updated from double features
+    void axpy(double alpha, const double* x, float* y, size_t n);
+
+    // Batched (GEMV-style) forms over `count` rows of length n, given as row
+    // pointers so shuffled mini-batches need no copy. Rows are processed four
+    // at a time so every load of w / y is shared by four rows.
+    // out[r] = dot(rows[r], w)
+    void dotRows(const double* const* rows, size_t count, const double* w, size_t n, double* out);
+    // y[i] += sum_r coeffs[r] * rows[r][i]
+    void axpyRows(const double* coeffs, const double* const* rows, size_t count, double* y, size_t n);
+
+    // Sparse access to a row-major matrix whose rows are `stride` doubles
+    // (stride a multiple of 8), e.g. a feature-major class-weight matrix.
+    // The output row is kept in registers across all nnz rows.
+    // acc[c] += sum_k val[k] * m[idx[k] * stride + c]
+    void gatherRows(const double* m, size_t stride, const uint32_t* idx, const double* val, size_t nnz, double* acc);
+    // m[idx[k] * stride + c] += val[k] * step[c]
+    void scatterRows(double* m, size_t stride, const uint32_t* idx, const double* val, size_t nnz, const double* step);
+
+    // Int8 dot products for quantized models. Products are summed exactly in
+    // int32 lanes, which are folded into an int64 every 64K elements so long
+    // vectors cannot overflow.
+    // sum(a[i] * b[i])
+    int64_t dotI8(const int8_t* a, const int8_t* b, size_t n);
+    // sum(w[idx[k]] * x[k]) with idx[k] < 2^31. w must stay readable for 3
+    // bytes past its last element: the AVX2 path gathers 4 bytes per index.
+    int64_t gatherDotI8(const int8_t* w, const uint32_t* idx, const int8_t* x, size_t nnz);
+    // out[i] = x[i] clamped to [-127, 127] and truncated (NaN gives -127);
+    // true if every x[i] was an integer in [-127, 127], i.e. the conversion
+    // was exact. Every ISA writes the same out.
+    bool toInt8Exact(const double* x, size_t n, int8_t* out);
+}
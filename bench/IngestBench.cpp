@@ -0,0 +1,174 @@
+// Benchmark: reading a directory tree of small documents.
+//
+//   ingest-bench --dir corpus/ [--depth N] [--readers N] [--repeat N] [--cold]
+//
+// Compares a serial std::ifstream loop (how the GUI's extractFeatures reads),
+// the Threads backend of CorpusIngest and the io_uring backend, then runs the
+// full extractFiles pipeline (ingest -> default-keyword extraction) for each
+// backend and checks they produce the same features. One JSON line per case.
+// --cold evicts the files from the page cache before every run
+// (posix_fadvise DONTNEED; works for clean pages without root), so the disk is
+// measured instead of memory copies.
+#include "CorpusIngest.h"
+#include "DefaultKeywords.h"
+#include "Featurizer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    struct BenchOptions
+    {
+        std::string dir;
+        unsigned depth = 64;
+        unsigned readers = 8;
+        int repeat = 3;
+        bool cold = false;
+    };
+
+    bool parseArgs(int argc, char** argv, BenchOptions& opt)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string arg = argv[i];
+            const bool hasValue = i + 1 < argc;
+            if (arg == "--dir" && hasValue) opt.dir = argv[++i];
+            else if (arg == "--depth" && hasValue) opt.depth = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+            else if (arg == "--readers" && hasValue) opt.readers = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+            else if (arg == "--repeat" && hasValue) opt.repeat = std::atoi(argv[++i]);
+            else if (arg == "--cold") opt.cold = true;
+            else return false;
+        }
+        return !opt.dir.empty() && opt.repeat > 0;
+    }
+
+    void evict(const std::vector<std::string>& paths)
+    {
+#ifndef _WIN32
+        for (const auto& p : paths)
+        {
+            const int fd = ::open(p.c_str(), O_RDONLY);
+            if (fd < 0) continue;
+            posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+            ::close(fd);
+        }
+#else
+        (void)paths;
+#endif
+    }
+
+    void report(const char* bench, const char* backend, const BenchOptions& opt, size_t files, uint64_t bytes,
+        double seconds, uint64_t submitCalls)
+    {
+        std::printf("{\"bench\":\"%s\",\"backend\":\"%s\",\"files\":%zu,\"bytes\":%llu,\"cold\":%s,"
+            "\"seconds\":%.4f,\"files_per_sec\":%.0f,\"mb_per_sec\":%.1f,\"submit_calls\":%llu}\n",
+            bench, backend, files, static_cast<unsigned long long>(bytes), opt.cold ? "true" : "false",
+            seconds, files / seconds, bytes / seconds / 1e6, static_cast<unsigned long long>(submitCalls));
+        std::fflush(stdout);
+    }
+
+    // best of opt.repeat runs
+    template <class Run>
+    double best(const BenchOptions& opt, const std::vector<std::string>& paths, Run&& run)
+    {
+        double fastest = 1e300;
+        for (int r = 0; r < opt.repeat; ++r)
+        {
+            if (opt.cold) evict(paths);
+            const auto t0 = std::chrono::steady_clock::now();
+            run();
+            fastest = (std::min)(fastest, std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count());
+        }
+        return fastest;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    BenchOptions opt;
+    if (!parseArgs(argc, argv, opt))
+    {
+        std::fprintf(stderr, "usage: ingest-bench --dir DIR [--depth N] [--readers N] [--repeat N] [--cold]\n");
+        return 1;
+    }
+
+    std::vector<std::string> paths;
+    std::string error;
+    if (!listFiles(opt.dir, paths, &error))
+    {
+        std::fprintf(stderr, "ingest-bench: %s\n", error.c_str());
+        return 1;
+    }
+    std::fprintf(stderr, "ingest-bench: %zu files, io_uring %s\n", paths.size(),
+        ioUringAvailable() ? "available" : "not available");
+
+    // serial ifstream open/read/close per file
+    uint64_t bytes = 0;
+    const double serial = best(opt, paths, [&] {
+        bytes = 0;
+        for (const auto& p : paths)
+        {
+            std::ifstream in(p, std::ios::binary);
+            const std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            bytes += text.size();
+        }
+    });
+    report("read", "ifstream", opt, paths.size(), bytes, serial, 0);
+
+    IngestOptions ingest;
+    ingest.queueDepth = opt.depth;
+    ingest.readers = opt.readers;
+    const IngestBackend backends[] = { IngestBackend::Threads, IngestBackend::IoUring };
+    for (IngestBackend b : backends)
+    {
+        ingest.backend = b;
+        IngestStats stats;
+        const double s = best(opt, paths, [&] {
+            BoundedQueue<IngestBatch> queue(ingest.prefetch);
+            std::thread consumer([&] {
+                IngestBatch batch;
+                while (queue.pop(batch)) {}
+            });
+            stats = readFiles(paths, queue, ingest);
+            consumer.join();
+        });
+        report("read", ingestBackendName(stats.backend), opt, stats.files, stats.bytes, s, stats.submitCalls);
+    }
+
+    // full pipeline: ingestion feeding keyword extraction on a pool
+    const Featurizer featurizer(FeatureConfig::forKeywords(
+        std::vector<std::string>(kDefaultKeywords.begin(), kDefaultKeywords.end())));
+    ThreadPool pool;
+    std::vector<std::vector<SparseVector>> results;
+    for (IngestBackend b : backends)
+    {
+        ingest.backend = b;
+        std::vector<SparseVector> rows;
+        std::vector<std::string> errors;
+        IngestStats stats;
+        const double s = best(opt, paths, [&] { stats = extractFiles(paths, featurizer, pool, rows, errors, ingest); });
+        report("extract", ingestBackendName(stats.backend), opt, stats.files, stats.bytes, s, stats.submitCalls);
+        results.push_back(std::move(rows));
+    }
+    for (size_t i = 0; i < paths.size(); ++i)
+    {
+        if (results[0][i].indices != results[1][i].indices || results[0][i].values != results[1][i].values)
+        {
+            std::fprintf(stderr, "ingest-bench: backends disagree on '%s'\n", paths[i].c_str());
+            return 1;
+        }
+    }
+    return 0;
+}
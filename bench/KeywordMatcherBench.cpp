@@ -0,0 +1,111 @@
+// Benchmark: naive per-keyword token.find() vs the Aho-Corasick KeywordMatcher,
+// and naive per-keyword token == keyword vs the exact-token perfect hash.
+// Sweeps the keyword count and checks each pair gives identical feature vectors.
+//
+// build: cmake target keyword-bench, or
+//   g++ -O2 -std=c++17 -I.. KeywordMatcherBench.cpp ../PerfectHash.cpp -o keyword_bench
+#include "KeywordMatcher.h"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+static std::string randomWord(std::mt19937& rng, size_t minLen, size_t maxLen)
+{
+    std::uniform_int_distribution<size_t> len(minLen, maxLen);
+    std::uniform_int_distribution<int> ch('a', 'z');
+    std::string w(len(rng), ' ');
+    for (auto& c : w) c = static_cast<char>(ch(rng));
+    return w;
+}
+
+// the original extractFeatures inner loop
+static void countNaive(const std::vector<std::string>& tokens,
+    const std::vector<std::string>& keywords, std::vector<double>& features)
+{
+    for (const auto& token : tokens)
+        for (size_t i = 0; i < keywords.size(); ++i)
+            if (!keywords[i].empty() && token.find(keywords[i]) != std::string::npos)
+                features[i] += 1.0;
+}
+
+// exact-token counterpart of countNaive
+static void countNaiveExact(const std::vector<std::string>& tokens,
+    const std::vector<std::string>& keywords, std::vector<double>& features)
+{
+    for (const auto& token : tokens)
+        for (size_t i = 0; i < keywords.size(); ++i)
+            if (!keywords[i].empty() && token == keywords[i])
+                features[i] += 1.0;
+}
+
+static void countMatcher(const std::vector<std::string>& tokens,
+    const KeywordMatcher& matcher, std::vector<double>& features)
+{
+    KeywordMatcher::Scratch scratch;
+    for (const auto& token : tokens)
+        matcher.countToken(token, features.data(), scratch);
+}
+
+template <class F>
+static double bestOfMs(int reps, F&& f)
+{
+    double best = 1e300;
+    for (int r = 0; r < reps; ++r)
+    {
+        auto t0 = std::chrono::steady_clock::now();
+        f();
+        auto t1 = std::chrono::steady_clock::now();
+        double ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+        if (ms < best) best = ms;
+    }
+    return best;
+}
+
+int main()
+{
+    std::mt19937 rng(42);
+
+    // ~20k tokens, roughly a large mail body
+    std::vector<std::string> tokens;
+    for (int i = 0; i < 20000; ++i) tokens.push_back(randomWord(rng, 2, 12));
+
+    std::printf("%10s %12s %12s %12s %9s | %12s %12s %12s %9s\n",
+        "keywords", "build(ms)", "naive(ms)", "matcher(ms)", "speedup",
+        "build(ms)", "naive==(ms)", "exact(ms)", "speedup");
+
+    for (size_t k : { 20u, 100u, 500u, 1000u, 5000u, 20000u })
+    {
+        std::vector<std::string> keywords;
+        for (size_t i = 0; i < k; ++i) keywords.push_back(randomWord(rng, 3, 7));
+
+        // every 8th token is a keyword, so exact mode has hits to count
+        std::vector<std::string> text = tokens;
+        for (size_t i = 0; i < text.size(); i += 8) text[i] = keywords[i / 8 % k];
+
+        KeywordMatcher matcher;
+        double buildMs = bestOfMs(1, [&] { matcher = KeywordMatcher(keywords); });
+
+        std::vector<double> a(k, 0.0), b(k, 0.0);
+        int reps = k <= 1000 ? 5 : 1;
+        double naiveMs = bestOfMs(reps, [&] { a.assign(k, 0.0); countNaive(text, keywords, a); });
+        double acMs = bestOfMs(5, [&] { b.assign(k, 0.0); countMatcher(text, matcher, b); });
+
+        KeywordMatcher exact;
+        double exactBuildMs = bestOfMs(1, [&] { exact = KeywordMatcher(keywords, KeywordMatch::ExactToken); });
+        std::vector<double> c(k, 0.0), d(k, 0.0);
+        double naiveExactMs = bestOfMs(reps, [&] { c.assign(k, 0.0); countNaiveExact(text, keywords, c); });
+        double exactMs = bestOfMs(5, [&] { d.assign(k, 0.0); countMatcher(text, exact, d); });
+
+        if (a != b || c != d)
+        {
+            std::printf("MISMATCH at %zu keywords\n", k);
+            return 1;
+        }
+        std::printf("%10zu %12.3f %12.3f %12.3f %8.1fx | %12.3f %12.3f %12.3f %8.1fx\n",
+            k, buildMs, naiveMs, acMs, naiveMs / acMs,
+            exactBuildMs, naiveExactMs, exactMs, naiveExactMs / exactMs);
+    }
+    return 0;
+}
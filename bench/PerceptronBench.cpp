@@ -0,0 +1,451 @@
+// Microbenchmarks for feature extraction, scoring, training and model I/O.
+//
+// Every case prints one JSON line:
+//   {"bench":"score","params":{"dim":4096,"input":"dense"},"iterations":...,
+//    "ns_per_op":...,"bytes_per_sec":...,"allocs_per_op":...,"isa":"avx2"}
+// so runs can be diffed or loaded into a notebook to catch regressions.
+//
+// usage: perceptron-bench [--filter SUBSTR] [--min-time-ms N] [--quick]
+//
+// Allocations are counted by replacing the global operator new in this binary.
+#include "AveragedPerceptron.h"
+#include "DefaultKeywords.h"
+#include "FeatureExtractor.h"
+#include "FixedKeywordMatcher.h"
+#include "FixedPerceptron.h"
+#include "KeywordMatcher.h"
+#include "ModelFormat.h"
+#include "MulticlassPerceptron.h"
+#include "Perceptron.h"
+#include "SparseVector.h"
+#include "VectorKernels.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+// ---------------- allocation counting ----------------
+
+static std::atomic<uint64_t> gAllocs{ 0 };
+
+void* operator new(size_t n)
+{
+    gAllocs.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t n) { return operator new(n); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+
+void* operator new(size_t n, std::align_val_t al)
+{
+    gAllocs.fetch_add(1, std::memory_order_relaxed);
+    const size_t a = static_cast<size_t>(al);
+#ifdef _WIN32
+    if (void* p = _aligned_malloc(n ? n : 1, a)) return p;
+#else
+    if (void* p = std::aligned_alloc(a, (n + a - 1) / a * a)) return p;
+#endif
+    throw std::bad_alloc();
+}
+void* operator new[](size_t n, std::align_val_t al) { return operator new(n, al); }
+#ifdef _WIN32
+void operator delete(void* p, std::align_val_t) noexcept { _aligned_free(p); }
+#else
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+#endif
+void operator delete[](void* p, std::align_val_t al) noexcept { operator delete(p, al); }
+void operator delete(void* p, size_t, std::align_val_t al) noexcept { operator delete(p, al); }
+void operator delete[](void* p, size_t, std::align_val_t al) noexcept { operator delete(p, al); }
+
+// ---------------- harness ----------------
+
+namespace
+{
+    struct BenchOptions
+    {
+        std::string filter;
+        double minTimeMs = 100.0;
+        bool quick = false;
+    };
+
+    BenchOptions gOptions;
+    volatile double gSink = 0.0;   // keeps results alive
+
+    // Run op until it takes at least minTimeMs, then print one JSON line.
+    // params is a JSON object body, e.g. "\"dim\":64". bytesPerOp = 0 omits
+    // bytes_per_sec.
+    template <class Op>
+    void run(const char* bench, const std::string& params, double bytesPerOp, Op&& op)
+    {
+        const std::string id = std::string(bench) + "{" + params + "}";
+        if (!gOptions.filter.empty() && id.find(gOptions.filter) == std::string::npos) return;
+
+        op(); // warm-up
+        uint64_t iterations = 1;
+        double elapsedNs = 0.0;
+        uint64_t allocs = 0;
+        for (;;)
+        {
+            const uint64_t allocsBefore = gAllocs.load(std::memory_order_relaxed);
+            const auto t0 = std::chrono::steady_clock::now();
+            for (uint64_t i = 0; i < iterations; ++i) op();
+            const auto t1 = std::chrono::steady_clock::now();
+            allocs = gAllocs.load(std::memory_order_relaxed) - allocsBefore;
+            elapsedNs = std::chrono::duration<double, std::nano>(t1 - t0).count();
+            if (elapsedNs >= gOptions.minTimeMs * 1e6 || iterations >= (1ull << 40)) break;
+            // aim a bit past the target so the next round usually ends it
+            const double scale = elapsedNs > 0.0 ? gOptions.minTimeMs * 1e6 * 1.2 / elapsedNs : 100.0;
+            iterations = static_cast<uint64_t>(iterations * (scale < 2.0 ? 2.0 : (scale > 100.0 ? 100.0 : scale)));
+        }
+
+        const double nsPerOp = elapsedNs / static_cast<double>(iterations);
+        std::printf("{\"bench\":\"%s\",\"params\":{%s},\"iterations\":%llu,\"ns_per_op\":%.3f",
+            bench, params.c_str(), static_cast<unsigned long long>(iterations), nsPerOp);
+        if (bytesPerOp > 0.0)
+            std::printf(",\"bytes_per_sec\":%.6g", bytesPerOp * 1e9 / nsPerOp);
+        std::printf(",\"allocs_per_op\":%.3f,\"isa\":\"%s\"}\n",
+            static_cast<double>(allocs) / static_cast<double>(iterations),
+            kernels::isaName(kernels::activeIsa()));
+        std::fflush(stdout);
+    }
+
+    std::string randomWord(std::mt19937& rng, size_t minLen, size_t maxLen)
+    {
+        std::uniform_int_distribution<size_t> len(minLen, maxLen);
+        std::uniform_int_distribution<int> ch('a', 'z');
+        std::string w(len(rng), ' ');
+        for (auto& c : w) c = static_cast<char>(ch(rng));
+        return w;
+    }
+
+    // text of about `bytes` bytes: random words, some keywords, punctuation
+    std::string makeDocument(std::mt19937& rng, size_t bytes, const std::vector<std::string>& keywords)
+    {
+        std::string doc;
+        doc.reserve(bytes + 32);
+        std::uniform_int_distribution<int> pick(0, 9);
+        std::uniform_int_distribution<size_t> kw(0, keywords.size() - 1);
+        while (doc.size() < bytes)
+        {
+            doc += pick(rng) == 0 ? keywords[kw(rng)] : randomWord(rng, 2, 10);
+            doc += pick(rng) == 0 ? ".\n" : " ";
+        }
+        return doc;
+    }
+
+    std::vector<double> randomVector(std::mt19937& rng, size_t n)
+    {
+        std::uniform_real_distribution<double> d(-1.0, 1.0);
+        std::vector<double> v(n);
+        for (auto& x : v) x = d(rng);
+        return v;
+    }
+
+    SparseVector randomSparse(std::mt19937& rng, size_t dim, size_t nnz)
+    {
+        SparseVector sv;
+        sv.dimension = dim;
+        const size_t stride = dim / nnz;
+        std::uniform_real_distribution<double> d(-1.0, 1.0);
+        for (size_t k = 0; k < nnz; ++k) sv.push(static_cast<uint32_t>(k * stride), d(rng));
+        return sv;
+    }
+
+    std::string param(const char* key, size_t value)
+    {
+        return "\"" + std::string(key) + "\":" + std::to_string(value);
+    }
+
+    std::string param(const char* key, const char* value)
+    {
+        return "\"" + std::string(key) + "\":\"" + value + "\"";
+    }
+
+    void benchExtraction(std::mt19937& rng)
+    {
+        const std::vector<size_t> docSizes = gOptions.quick
+            ? std::vector<size_t>{ 4096, 1 << 20 }
+            : std::vector<size_t>{ 1024, 16 * 1024, 256 * 1024, 4 << 20 };
+        const std::vector<size_t> keywordCounts = gOptions.quick
+            ? std::vector<size_t>{ 16, 256 }
+            : std::vector<size_t>{ 8, 64, 512, 4096 };
+
+        for (size_t k : keywordCounts)
+        {
+            std::vector<std::string> keywords;
+            for (size_t i = 0; i < k; ++i) keywords.push_back(randomWord(rng, 3, 8));
+            const KeywordMatcher matcher(keywords);
+
+            for (size_t size : docSizes)
+            {
+                const std::string doc = makeDocument(rng, size, keywords);
+                const std::string path = "perceptron_bench_doc.txt";
+                {
+                    std::ofstream out(path, std::ios::binary);
+                    out << doc;
+                }
+                const std::string p = param("doc_bytes", doc.size()) + "," + param("keywords", k);
+                const double bytes = static_cast<double>(doc.size());
+
+                // original API: builds the matcher on every call
+                run("extractFeatures", p + "," + param("api", "keywords"), bytes,
+                    [&] { gSink = gSink + extractFeatures(path, keywords)[0]; });
+                run("extractFeatures", p + "," + param("api", "matcher_stream"), bytes,
+                    [&] { gSink = gSink + extractFeatures(path, matcher)[0]; });
+                run("extractFeatures", p + "," + param("api", "matcher_mapped"), bytes,
+                    [&] { gSink = gSink + extractFeaturesMapped(path, matcher)[0]; });
+
+                std::vector<double> dense;
+                run("extractFeaturesFromText", p + "," + param("output", "dense"), bytes, [&] {
+                    dense.assign(k, 0.0);
+                    extractFeaturesFromText(doc, matcher, dense);
+                    gSink = gSink + dense[0];
+                });
+                SparseVector sparse;
+                SparseExtractScratch scratch;
+                run("extractFeaturesFromText", p + "," + param("output", "sparse"), bytes, [&] {
+                    extractSparseFeaturesFromText(doc, matcher, sparse, scratch);
+                    gSink = gSink + static_cast<double>(sparse.nnz());
+                });
+                std::remove(path.c_str());
+            }
+        }
+    }
+
+    void benchModel(std::mt19937& rng)
+    {
+        const std::vector<size_t> dims = gOptions.quick
+            ? std::vector<size_t>{ 64, 16384 }
+            : std::vector<size_t>{ 16, 256, 4096, 65536, 1 << 20 };
+
+        for (WeightPrecision precision : { WeightPrecision::Double, WeightPrecision::Float })
+        {
+            const char* prec = precision == WeightPrecision::Float ? "float" : "double";
+            for (size_t dim : dims)
+            {
+                Perceptron model(static_cast<int>(dim), 0.01, precision);
+                const std::vector<double> dense = randomVector(rng, dim);
+                const size_t nnz = dim < 64 ? dim : 64;
+                const SparseVector sparse = randomSparse(rng, dim, nnz);
+                const std::string base = param("dim", dim) + "," + param("weights", prec);
+                const std::string pd = base + "," + param("input", "dense");
+                const std::string ps = base + "," + param("input", "sparse") + "," + param("nnz", nnz);
+                const double wBytes = precision == WeightPrecision::Float ? 4.0 : 8.0;
+                const double denseBytes = static_cast<double>(dim) * (wBytes + 8.0);
+                const double sparseBytes = static_cast<double>(nnz) * (wBytes + 12.0);
+
+                run("score", pd, denseBytes, [&] { gSink = gSink + model.score(dense); });
+                run("score", ps, sparseBytes, [&] { gSink = gSink + model.score(sparse); });
+                run("predict", pd, denseBytes, [&] { gSink = gSink + model.predict(dense); });
+                run("predict", ps, sparseBytes, [&] { gSink = gSink + model.predict(sparse); });
+                int label = 0;
+                run("train", pd, denseBytes * 2.0, [&] { model.train(dense, label ^= 1); });
+                run("train", ps, sparseBytes * 2.0, [&] { model.train(sparse, label ^= 1); });
+
+                // lazy averaging should add O(nnz), not O(dim), to each update
+                AveragedPerceptron averaged(model);
+                run("train_averaged", ps, 0.0, [&] { averaged.train(sparse, label ^= 1); });
+            }
+        }
+    }
+
+    // fused multi-class scoring vs one binary Perceptron per class
+    void benchMulticlass(std::mt19937& rng)
+    {
+        const size_t dim = 65536, nnz = 64;
+        const std::vector<int> classCounts = gOptions.quick ? std::vector<int>{ 12 } : std::vector<int>{ 4, 12, 32 };
+        const SparseVector sparse = randomSparse(rng, dim, nnz);
+
+        for (int classes : classCounts)
+        {
+            MulticlassPerceptron multi(static_cast<int>(dim), classes, 0.01);
+            std::vector<Perceptron> perClass;
+            for (int c = 0; c < classes; ++c) perClass.emplace_back(static_cast<int>(dim), 0.01);
+
+            const std::string p = param("dim", dim) + "," + param("nnz", nnz) + "," + param("classes", static_cast<size_t>(classes));
+            run("multiclass_predict", p + "," + param("impl", "fused"), 0.0,
+                [&] { gSink = gSink + multi.predict(sparse); });
+            run("multiclass_predict", p + "," + param("impl", "per_class_models"), 0.0, [&] {
+                int best = 0;
+                double bestScore = perClass[0].score(sparse);
+                for (int c = 1; c < classes; ++c)
+                {
+                    const double s = perClass[static_cast<size_t>(c)].score(sparse);
+                    if (s > bestScore) { bestScore = s; best = c; }
+                }
+                gSink = gSink + best;
+            });
+            int label = 0;
+            run("multiclass_train", p + "," + param("impl", "fused"), 0.0,
+                [&] { multi.train(sparse, label = (label + 1) % classes); });
+        }
+    }
+
+    // compile-time keyword set vs the runtime matcher + dynamic model on short messages
+    void benchFixed(std::mt19937& rng)
+    {
+        constexpr size_t N = kDefaultKeywords.size();
+        static constexpr FixedKeywordMatcher<N> fixedMatcher(kDefaultKeywords);
+        const std::vector<std::string> keywords(kDefaultKeywords.begin(), kDefaultKeywords.end());
+        const KeywordMatcher matcher(keywords);
+        FixedPerceptron<N> fixedModel(0.01);
+        const Perceptron model = fixedModel.toPerceptron();
+
+        for (size_t size : { size_t(160), size_t(1024) })
+        {
+            const std::string msg = makeDocument(rng, size, keywords);
+            const std::string p = param("doc_bytes", msg.size()) + "," + param("keywords", N);
+            const double bytes = static_cast<double>(msg.size());
+
+            std::vector<double> dense;
+            run("classify_message", p + "," + param("impl", "dynamic"), bytes, [&] {
+                dense.assign(N, 0.0);
+                extractFeaturesFromText(msg, matcher, dense);
+                gSink = gSink + model.score(dense);
+            });
+            typename FixedPerceptron<N>::Inputs counts;
+            run("classify_message", p + "," + param("impl", "fixed"), bytes, [&] {
+                fixedMatcher.extract(msg, counts);
+                gSink = gSink + fixedModel.score(counts);
+            });
+        }
+
+        const std::vector<double> x = randomVector(rng, N);
+        typename FixedPerceptron<N>::Inputs xa;
+        std::copy(x.begin(), x.end(), xa.begin());
+        const std::string p = param("dim", N) + "," + param("input", "dense");
+        run("score", p + "," + param("impl", "dynamic"), 0.0, [&] { gSink = gSink + model.score(x); });
+        run("score", p + "," + param("impl", "fixed"), 0.0, [&] { gSink = gSink + fixedModel.score(xa); });
+    }
+
+    // count-valued document with random (sorted, distinct) indices
+    SparseVector randomCounts(std::mt19937& rng, size_t dim, size_t nnz)
+    {
+        std::uniform_int_distribution<uint32_t> index(0, static_cast<uint32_t>(dim - 1));
+        std::uniform_int_distribution<int> count(1, 5);
+        std::vector<double> dense;
+        std::vector<uint32_t> idx;
+        while (idx.size() < nnz)
+        {
+            idx.push_back(index(rng));
+            std::sort(idx.begin(), idx.end());
+            idx.erase(std::unique(idx.begin(), idx.end()), idx.end());
+        }
+        SparseVector sv;
+        sv.dimension = dim;
+        for (uint32_t i : idx) sv.push(i, count(rng));
+        return sv;
+    }
+
+    // double vs int8 models served from the mapping; with several tenants the
+    // documents rotate over that many models, so the weights compete for cache
+    void benchQuantized(std::mt19937& rng)
+    {
+        struct Case { size_t dim, tenants; };
+        const std::vector<Case> cases = gOptions.quick
+            ? std::vector<Case>{ { 1 << 18, 1 }, { 1 << 18, 16 } }
+            : std::vector<Case>{ { 1 << 14, 1 }, { 1 << 18, 1 }, { 1 << 18, 16 }, { 1 << 20, 16 } };
+        const size_t nnz = 128, docCount = 256;
+
+        for (const Case& c : cases)
+        {
+            std::vector<SparseVector> docs;
+            for (size_t d = 0; d < docCount; ++d) docs.push_back(randomCounts(rng, c.dim, nnz));
+
+            std::vector<std::string> paths;
+            std::vector<MappedModel> full(c.tenants), quantized(c.tenants);
+            for (size_t t = 0; t < c.tenants; ++t)
+            {
+                Perceptron model(static_cast<int>(c.dim), 0.01);
+                const std::string base = "perceptron_bench_tenant" + std::to_string(t);
+                model.saveModelBinary(base + ".bin");
+                model.saveModelQuantized(base + ".q8");
+                full[t].open(base + ".bin");
+                quantized[t].open(base + ".q8");
+                paths.push_back(base + ".bin");
+                paths.push_back(base + ".q8");
+            }
+
+            const std::string p = param("dim", c.dim) + "," + param("nnz", nnz) + "," + param("tenants", c.tenants);
+            for (const char* weights : { "double", "int8" })
+            {
+                const std::vector<MappedModel>& models = weights[0] == 'i' ? quantized : full;
+                size_t next = 0;
+                run("score_mapped", p + "," + param("weights", weights), 0.0, [&] {
+                    const size_t d = next++ % docCount;
+                    gSink = gSink + models[d % c.tenants].score(docs[d]);
+                });
+            }
+            for (const auto& path : paths) std::remove(path.c_str());
+        }
+    }
+
+    size_t fileSize(const std::string& path)
+    {
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        return in ? static_cast<size_t>(in.tellg()) : 0;
+    }
+
+    void benchModelIO()
+    {
+        const std::vector<size_t> dims = gOptions.quick
+            ? std::vector<size_t>{ 1024 }
+            : std::vector<size_t>{ 64, 16384, 1 << 20 };
+        const std::string path = "perceptron_bench_model";
+
+        for (size_t dim : dims)
+        {
+            Perceptron model(static_cast<int>(dim), 0.01);
+            Perceptron loaded(static_cast<int>(dim), 0.01);
+
+            for (const char* format : { "text", "binary" })
+            {
+                const bool binary = format[0] == 'b';
+                const std::string p = param("dim", dim) + "," + param("format", format);
+                auto save = [&] {
+                    gSink = gSink + (binary ? model.saveModelBinary(path) : model.saveModel(path));
+                };
+                save();
+                const double bytes = static_cast<double>(fileSize(path));
+
+                run("saveModel", p, bytes, save);
+                run("loadModel", p, bytes, [&] { gSink = gSink + loaded.loadModel(path); });
+            }
+            std::remove(path.c_str());
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--filter" && i + 1 < argc) gOptions.filter = argv[++i];
+        else if (arg == "--min-time-ms" && i + 1 < argc) gOptions.minTimeMs = std::atof(argv[++i]);
+        else if (arg == "--quick") gOptions.quick = true;
+        else
+        {
+            std::fprintf(stderr, "usage: perceptron-bench [--filter SUBSTR] [--min-time-ms N] [--quick]\n");
+            return 1;
+        }
+    }
+
+    std::mt19937 rng(42);
+    benchExtraction(rng);
+    benchModel(rng);
+    benchMulticlass(rng);
+    benchFixed(rng);
+    benchQuantized(rng);
+    benchModelIO();
+    return 0;
+}
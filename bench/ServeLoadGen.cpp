@@ -0,0 +1,150 @@
+// Closed-loop load generator for perceptron-serve.
+//
+// Opens --connections client connections, each sending --requests requests
+// back to back (a new one as soon as the reply arrives), and prints one JSON
+// line with throughput and latency percentiles:
+//   {"bench":"serve","params":{"connections":8,"doc_bytes":2000,"mode":"text"},
+//    "requests":...,"errors":...,"req_per_sec":...,"p50_us":...,"p99_us":...}
+//
+// usage: serve-loadgen --socket PATH [--connections N] [--requests N]
+//                      [--doc-bytes N | --file PATH] [--paths]
+//
+// By default every request carries a generated document of --doc-bytes bytes
+// made of the default keywords and random filler. --file sends that file's
+// bytes instead; with --paths only its path is sent and the server reads it.
+#include "ClassifierServer.h"
+#include "DefaultKeywords.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+static std::string makeDocument(size_t bytes, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> pick(0, 9);
+    std::uniform_int_distribution<size_t> keyword(0, kDefaultKeywords.size() - 1);
+    std::uniform_int_distribution<int> ch('a', 'z');
+    std::string doc;
+    while (doc.size() < bytes)
+    {
+        if (pick(rng) == 0)
+            doc += kDefaultKeywords[keyword(rng)];
+        else
+            for (int k = 0; k < 6; ++k) doc += static_cast<char>(ch(rng));
+        doc += ' ';
+    }
+    doc.resize(bytes);
+    return doc;
+}
+
+static double percentile(const std::vector<uint64_t>& sorted, double q)
+{
+    if (sorted.empty()) return 0.0;
+    const size_t i = (std::min)(sorted.size() - 1, static_cast<size_t>(q * static_cast<double>(sorted.size())));
+    return static_cast<double>(sorted[i]) / 1000.0;
+}
+
+int main(int argc, char** argv)
+{
+    std::string socketPath, filePath;
+    unsigned connections = 8;
+    size_t requests = 2000, docBytes = 2000;
+    bool sendPaths = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--socket" && hasValue) socketPath = argv[++i];
+        else if (arg == "--connections" && hasValue) connections = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        else if (arg == "--requests" && hasValue) requests = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--doc-bytes" && hasValue) docBytes = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--file" && hasValue) filePath = argv[++i];
+        else if (arg == "--paths") sendPaths = true;
+        else
+        {
+            socketPath.clear();   // unknown option: print usage
+            break;
+        }
+    }
+    if (socketPath.empty() || connections == 0 || (sendPaths && filePath.empty()))
+    {
+        std::fprintf(stderr, "usage: serve-loadgen --socket PATH [--connections N] [--requests N]\n"
+            "                     [--doc-bytes N | --file PATH] [--paths]\n");
+        return 1;
+    }
+
+    std::string document;
+    if (!filePath.empty() && !sendPaths)
+    {
+        MappedFile file;
+        std::string error;
+        if (!file.open(filePath, &error))
+        {
+            std::fprintf(stderr, "serve-loadgen: %s\n", error.c_str());
+            return 1;
+        }
+        document.assign(file.view());
+    }
+    else if (filePath.empty())
+    {
+        document = makeDocument(docBytes, 1);
+    }
+
+    std::vector<std::vector<uint64_t>> latencies(connections);
+    std::vector<size_t> errors(connections, 0);
+    std::vector<std::string> firstError(connections);
+
+    const auto t0 = std::chrono::steady_clock::now();
+    std::vector<std::thread> clients;
+    for (unsigned c = 0; c < connections; ++c)
+    {
+        clients.emplace_back([&, c] {
+            ClassifierClient client;
+            std::string error, label;
+            double score = 0.0;
+            if (!client.connect(socketPath, &error))
+            {
+                errors[c] = requests;
+                firstError[c] = error;
+                return;
+            }
+            latencies[c].reserve(requests);
+            for (size_t r = 0; r < requests; ++r)
+            {
+                const auto start = std::chrono::steady_clock::now();
+                const bool ok = sendPaths ? client.classifyPath(filePath, label, score, &error)
+                                          : client.classifyText(document, label, score, &error);
+                latencies[c].push_back(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start).count()));
+                if (!ok && errors[c]++ == 0) firstError[c] = error;
+            }
+        });
+    }
+    for (auto& t : clients) t.join();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    std::vector<uint64_t> all;
+    size_t failed = 0;
+    for (unsigned c = 0; c < connections; ++c)
+    {
+        all.insert(all.end(), latencies[c].begin(), latencies[c].end());
+        if (errors[c] && !failed) std::fprintf(stderr, "serve-loadgen: %s\n", firstError[c].c_str());
+        failed += errors[c];
+    }
+    std::sort(all.begin(), all.end());
+
+    std::printf("{\"bench\":\"serve\",\"params\":{\"connections\":%u,\"doc_bytes\":%zu,\"mode\":\"%s\"},"
+        "\"requests\":%zu,\"errors\":%zu,\"seconds\":%.3f,\"req_per_sec\":%.1f,"
+        "\"p50_us\":%.1f,\"p90_us\":%.1f,\"p99_us\":%.1f,\"p999_us\":%.1f,\"max_us\":%.1f}\n",
+        connections, sendPaths ? static_cast<size_t>(0) : document.size(), sendPaths ? "path" : "text",
+        all.size(), failed, seconds, static_cast<double>(all.size()) / seconds,
+        percentile(all, 0.5), percentile(all, 0.9), percentile(all, 0.99), percentile(all, 0.999),
+        all.empty() ? 0.0 : static_cast<double>(all.back()) / 1000.0);
+    return failed ? 2 : 0;
+}
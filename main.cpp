@@ -8,12 +8,19 @@
 // Make sure these header files exist in your project
 #include "Perceptron.h"
 #include "FeatureExtractor.h"
+#include "DefaultKeywords.h"
+#include "BatchExtractor.h"
+#include "Featurizer.h"
+#include "StreamingTrainer.h"
+#include "TrainingEngine.h"
 
 #define ID_BTN_TRAIN   1
 #define ID_BTN_USE     2
 #define ID_EDIT_INPUT  100
 #define ID_BTN_ACTION  101
 #define ID_FRAME       102
+#define ID_TIMER_LOG   1
+#define WM_APP_TRAINED (WM_APP + 1)   // posted by the training thread when a run ends
 
 // ---------------- App State ----------------
 enum AppState { STATE_MENU, STATE_TRAIN, STATE_USE };
@@ -39,14 +46,34 @@ int gTrainStep = -1;
 int gExpectedInputs = 0;
 int gCurrentSample = 0;
 int gEpochs = 10;
+bool gLeastSquares = false; // closed-form solve instead of epochs
 
 // ---------------- Use Flow Globals ----------------
 int gUseStep = -1;
 
+std::vector<std::string>         gPaths;     // sample files, extracted in one batch
+std::string                      gManifest;  // train mode: stream samples from this manifest instead
 std::vector<std::vector<double>> gX;
 std::vector<int>                 gY;
 std::vector<std::string>         gKeywords;
+KeywordMatch                     gKeywordMatch = KeywordMatch::Substring;
+KeywordMatcher                   gMatcher;   // built from gKeywords, reused per file
+Featurizer                       gFeaturizer; // use mode: extractor matching the model
 Perceptron* gPerceptron = nullptr;
+TrainingEngine                   gTrainer;   // runs the epoch loop off the UI thread
+LogSink                          gTrainLog(4096); // training progress, drained by a timer
+
+// Training progress goes to gTrainLog; the window is told when the run ends
+class GuiTrainingObserver : public LogSinkObserver {
+public:
+    GuiTrainingObserver() : LogSinkObserver(gTrainLog) {}
+    HWND hwnd = NULL;
+    void onFinished(const TrainingResult& r) override {
+        LogSinkObserver::onFinished(r);
+        PostMessage(hwnd, WM_APP_TRAINED, 0, 0);
+    }
+};
+static GuiTrainingObserver gTrainObserver;
 
 // ---------------- Helpers ----------------
 static void setGreenText(HDC hdc) {
@@ -55,13 +82,26 @@ static void setGreenText(HDC hdc) {
     SetBkMode(hdc, TRANSPARENT);
 }
 
+// the log keeps at most this many characters; older text is dropped
+static const size_t kMaxLogChars = 256 * 1024;
+
 static void AppendLog(const std::wstring& s, HWND hwnd) {
-    gLogBuffer += s;
-    gLogBuffer += L"\r\n";
+    const std::wstring text = s + L"\r\n";
+    gLogBuffer += text;
 
     // Update the scrollable edit control
+    if (gLogBuffer.size() > kMaxLogChars) {
+        // drop the oldest half in one go, so trimming stays cheap per line
+        gLogBuffer.erase(0, gLogBuffer.size() - kMaxLogChars / 2);
+        if (gLogEdit) SetWindowText(gLogEdit, gLogBuffer.c_str());
+    }
+    else if (gLogEdit) {
+        // append at the end instead of replacing the whole text every line
+        int len = GetWindowTextLength(gLogEdit);
+        SendMessage(gLogEdit, EM_SETSEL, len, len);
+        SendMessage(gLogEdit, EM_REPLACESEL, FALSE, (LPARAM)text.c_str());
+    }
     if (gLogEdit) {
-        SetWindowText(gLogEdit, gLogBuffer.c_str());
         // Auto-scroll to bottom
         int len = GetWindowTextLength(gLogEdit);
         SendMessage(gLogEdit, EM_SETSEL, len, len);
@@ -75,13 +115,37 @@ static std::wstring Widen(const std::string& s) {
     return std::wstring(s.begin(), s.end());
 }
 
+// Move progress lines written by the training thread into the log window
+static void DrainTrainingLog(HWND hwnd) {
+    std::vector<std::string> lines;
+    if (!gTrainLog.drain(lines)) return;
+    std::string text;
+    for (size_t i = 0; i < lines.size(); ++i) {
+        if (i) text += "\r\n";
+        text += lines[i];
+    }
+    AppendLog(Widen(text), hwnd);
+}
+
+// Cancel a running training job (mode switch, window close) and wait for it
+static void StopTraining(HWND hwnd) {
+    gTrainer.cancel();
+    gTrainer.wait();
+    KillTimer(hwnd, ID_TIMER_LOG);
+    gTrainLog.clear();
+}
+
+// extracted training features, reused across runs while files are unchanged
+static const char* const kFeatureCacheFile = "features.cache";
+
+static ThreadPool& ExtractionPool() {
+    static ThreadPool pool; // one worker per core, created on first use
+    return pool;
+}
+
 static std::vector<std::string> buildKeywordList() {
-    // If you have your own list, replace this with the original.
-    return {
-        "free","win","money","offer","click","buy","urgent",
-        "reward","account","verify","login","pin","selected",
-        "limited","now","risk","credit","deal","bonus","gift"
-    };
+    // the production list lives in DefaultKeywords.h (shared with the fixed-size filter)
+    return std::vector<std::string>(kDefaultKeywords.begin(), kDefaultKeywords.end());
 }
 
 // Paint the log text inside gFrameBox, aligned to that child's rectangle
@@ -101,6 +165,8 @@ static void StartUseFlow(HWND hwnd);
 static void HandleUseInput(HWND hwnd);
 static void StartUseFlow(HWND hwnd) {
     // reset UI log + state
+    StopTraining(hwnd);
+    gTrainStep = -1;
     gLogBuffer.clear();
 
     if (gPerceptron) {
@@ -108,7 +174,10 @@ static void StartUseFlow(HWND hwnd) {
         gPerceptron = nullptr;
     }
     gKeywords = buildKeywordList();
+    gMatcher = KeywordMatcher(gKeywords);
     gPerceptron = new Perceptron((int)gKeywords.size(), 0.001);
+    gPerceptron->setFeatureConfig(FeatureConfig::forKeywords(gKeywords));
+    gFeaturizer = Featurizer(gPerceptron->getFeatureConfig());
 
     AppendLog(L"Load existing model? (y/n): ", hwnd);
     gUseStep = 0; // expecting y/n
@@ -144,6 +213,10 @@ static void HandleUseInput(HWND hwnd) {
         std::string path = input.empty() ? "model.txt" : input;
         if (gPerceptron->loadModel(path)) {
             AppendLog(L"Loaded '" + Widen(path) + L"'.", hwnd);
+            // extract the way the model was trained (its keywords or hashing params)
+            gFeaturizer = Featurizer(gPerceptron->getFeatureConfig());
+            if (gFeaturizer.getConfig().mode == FeatureMode::Hashing)
+                AppendLog(L"Model uses feature hashing (" + std::to_wstring(gFeaturizer.dimension()) + L" buckets).", hwnd);
         }
         else {
             AppendLog(L"Could not load '" + Widen(path) + L"', using fresh random weights.", hwnd);
@@ -162,16 +235,29 @@ static void HandleUseInput(HWND hwnd) {
         }
 
         // Extract features and classify
-        auto feats = extractFeatures(input, gKeywords);
+        Featurizer::Scratch scratch;
+        SparseVector feats;
+        std::string error;
+        if (!gFeaturizer.extractFile(input, feats, scratch, error)) {
+            AppendLog(L"Could not read '" + inputW + L"': " + Widen(error), hwnd);
+            AppendLog(L"File to classify: ", hwnd);
+            return;
+        }
         int pred = gPerceptron->predict(feats);
         double sc = gPerceptron->score(feats);
 
         // Display results
         std::wstringstream results;
         results << L"\nFeatures: ";
-        for (size_t i = 0; i < feats.size(); ++i) {
-            results << feats[i];
-            if (i + 1 < feats.size()) results << L" ";
+        if (gFeaturizer.getConfig().mode == FeatureMode::Hashing) {
+            results << feats.nnz() << L" non-zero buckets";
+        }
+        else {
+            auto dense = feats.toDense();
+            for (size_t i = 0; i < dense.size(); ++i) {
+                results << dense[i];
+                if (i + 1 < dense.size()) results << L" ";
+            }
         }
         results << L"\nScore: " << sc
             << L"  => Prediction: " << (pred ? L"SPAM" : L"HAM");
@@ -198,26 +284,121 @@ static void HandleUseInput(HWND hwnd) {
 // ---------------- Train Flow State Machine ----------------
 static void StartTrainFlow(HWND hwnd) {
     // reset UI log + state
+    StopTraining(hwnd);
     gLogBuffer.clear();
+    gPaths.clear();
     gX.clear();
     gY.clear();
     gExpectedInputs = 0;
     gCurrentSample = 0;
     gEpochs = 10;
+    gLeastSquares = false;
 
     if (gPerceptron) {
         delete gPerceptron;
         gPerceptron = nullptr;
     }
     gKeywords = buildKeywordList();
+    gKeywordMatch = KeywordMatch::Substring;
+    gMatcher = KeywordMatcher(gKeywords);
     gPerceptron = new Perceptron((int)gKeywords.size(), 0.001);
+    gPerceptron->setFeatureConfig(FeatureConfig::forKeywords(gKeywords));
 
+    gManifest.clear();
     AppendLog(L"Load existing model before training? (y/n): ", hwnd);
     gTrainStep = 0; // expecting y/n
     SetWindowText(gEditInput, L"");
     SetFocus(gEditInput);
 }
 
+// Extract all collected sample files in parallel; failed files are reported
+// and dropped together with their labels. Returns false if nothing is left.
+static bool ExtractTrainingSet(HWND hwnd) {
+    // unchanged sample files are served from the on-disk feature cache
+    FeatureCache cache;
+    std::string cacheError;
+    if (!cache.open(kFeatureCacheFile, gPerceptron->getFeatureConfig(), &cacheError))
+        AppendLog(L"Ignoring feature cache: " + Widen(cacheError), hwnd);
+
+    BatchFeatures batch = extractFeaturesBatch(gPaths, gMatcher, ExtractionPool(), &cache);
+    if (cache.hits())
+        AppendLog(std::to_wstring(cache.hits()) + L" of " + std::to_wstring(gPaths.size()) + L" samples loaded from the feature cache.", hwnd);
+    if (cache.misses() && !cache.save(&cacheError))
+        AppendLog(L"Could not save feature cache: " + Widen(cacheError), hwnd);
+
+    gX.clear();
+    std::vector<int> labels;
+    for (size_t i = 0; i < gPaths.size(); ++i) {
+        if (!batch.ok(i)) {
+            AppendLog(L"Skipping sample " + std::to_wstring(i + 1) + L": " + Widen(batch.errors[i]), hwnd);
+            continue;
+        }
+        gX.push_back(std::move(batch.rows[i]));
+        labels.push_back(gY[i]);
+    }
+    gY = std::move(labels);
+    return !gX.empty();
+}
+
+// Called once every sample has been entered (or skipped)
+static void FinishSampleInput(HWND hwnd) {
+    if (gPaths.empty() || !ExtractTrainingSet(hwnd)) {
+        AppendLog(L"No valid training samples provided. Exiting.", hwnd);
+        gTrainStep = -1;
+    }
+    else {
+        AppendLog(L"Epochs (default 10, 'ls' = least-squares solve): ", hwnd);
+        gTrainStep = 5;
+    }
+}
+
+// Called on WM_APP_TRAINED: report the finished run and ask about saving
+static void FinishTraining(HWND hwnd) {
+    KillTimer(hwnd, ID_TIMER_LOG);
+    TrainingResult result = gTrainer.wait();
+    DrainTrainingLog(hwnd);
+    if (gTrainStep != 9) return; // the flow was restarted meanwhile
+    if (gTrainLog.dropped())
+        AppendLog(L"(" + std::to_wstring(gTrainLog.dropped()) + L" progress lines were dropped)", hwnd);
+    if (!result.ok) {
+        gTrainStep = -1;
+        return;
+    }
+
+    std::wstringstream sf;
+    if (gPerceptron->getFeatureConfig().mode == FeatureMode::Hashing) {
+        // too many buckets to list
+        sf << L"\nTrained! " << gPerceptron->inputSize() << L" weights";
+    }
+    else {
+        sf << L"\nTrained! Weights: ";
+        for (auto w : gPerceptron->getWeights()) sf << w << L" ";
+    }
+    sf << L"  Bias: " << gPerceptron->getBias();
+    AppendLog(sf.str(), hwnd);
+
+    if (gManifest.empty()) {
+        AppendLog(L"\nTraining set predictions:", hwnd);
+        for (size_t i = 0; i < gX.size(); ++i) {
+            double yhat = gPerceptron->score(gX[i]);
+            int    pred = gPerceptron->predict(gX[i]);
+            int    y = gY[i];
+            double grad = (yhat - y);
+
+            std::wstringstream sp;
+            sp << L"  #" << (i + 1)
+                << L" expected=" << y
+                << L" predicted=" << pred
+                << L"  score=" << yhat
+                << L"  grad(yhat-y)=" << grad;
+            AppendLog(sp.str(), hwnd);
+        }
+    }
+
+    AppendLog(L"\nSave model? (y/n): ", hwnd);
+    gTrainStep = 6;
+}
+
 // Handles the Action button click during training
 static void HandleTrainInput(HWND hwnd) {
     if (gTrainStep < 0) return;
@@ -236,24 +417,51 @@ static void HandleTrainInput(HWND hwnd) {
             gTrainStep = 1;
         }
         else {
-            AppendLog(L"How many training samples? ", hwnd);
-            gTrainStep = 2;
+            AppendLog(L"Match keywords as whole words only? (y/n, h = feature hashing instead of keywords, default n): ", hwnd);
+            gTrainStep = 8;
         }
     } break;
 
     case 1: { // filename to load
         std::string path = input.empty() ? "model.txt" : input;
         if (gPerceptron->loadModel(path)) {
-            AppendLog(L"Loaded model from '" + Widen(path) + L"'. Training will continue...", hwnd);
+            const FeatureConfig& fc = gPerceptron->getFeatureConfig();
+            if (fc.mode == FeatureMode::Hashing) {
+                // hashed features are only extracted by the streaming trainer
+                AppendLog(L"Loaded feature-hashing model from '" + Widen(path) + L"' (" + std::to_wstring(fc.dimension())
+                    + L" buckets). Training will continue from a manifest...", hwnd);
+                AppendLog(L"Manifest to train on (@manifest.txt with 'path<TAB>label' lines): ", hwnd);
+                gTrainStep = 2;
+                return;
+            }
+            else {
+                // keep training on the keyword list (and match mode) the model was saved with
+                gKeywords = fc.keywords;
+                gKeywordMatch = fc.match;
+                gMatcher = KeywordMatcher(gKeywords, gKeywordMatch);
+                AppendLog(L"Loaded model from '" + Widen(path) + L"'. Training will continue...", hwnd);
+            }
         }
         else {
             AppendLog(L"Could not load '" + Widen(path) + L"'. Starting a new model.", hwnd);
         }
-        AppendLog(L"How many training samples? ", hwnd);
+        AppendLog(L"How many training samples? (or @manifest.txt to stream 'path<TAB>label' lines) ", hwnd);
         gTrainStep = 2;
     } break;
 
     case 2: { // number of samples
+        if (!input.empty() && input[0] == '@') {
+            // out-of-core: samples are streamed from the manifest every epoch
+            gManifest = input.substr(1);
+            AppendLog(L"Streaming samples from '" + Widen(gManifest) + L"'.", hwnd);
+            AppendLog(L"Epochs (default 10, 'ls' = least-squares solve): ", hwnd);
+            gTrainStep = 5;
+            return;
+        }
+        if (gPerceptron->getFeatureConfig().mode == FeatureMode::Hashing) {
+            AppendLog(L"Feature-hashing models train from a manifest: enter @manifest.txt ", hwnd);
+            return;
+        }
         int N = 0;
         try {
             N = std::stoi(input);
@@ -266,9 +474,10 @@ static void HandleTrainInput(HWND hwnd) {
             gTrainStep = -1;
             return;
         }
+        gPaths.clear();
         gX.clear();
         gY.clear();
-        gX.reserve(N);
+        gPaths.reserve(N);
         gY.reserve(N);
         gExpectedInputs = N;
         gCurrentSample = 0;
@@ -292,21 +501,13 @@ static void HandleTrainInput(HWND hwnd) {
                 gTrainStep = 3;
             }
             else {
-                if (gX.empty()) {
-                    AppendLog(L"No valid training samples provided. Exiting.", hwnd);
-                    gTrainStep = -1;
-                }
-                else {
-                    AppendLog(L"Epochs (default 10): ", hwnd);
-                    gTrainStep = 5;
-                }
+                FinishSampleInput(hwnd);
             }
             return;
         }
 
-        // Extract features
-        auto feats = extractFeatures(input, gKeywords);
-        gX.push_back(std::move(feats));
+        // Features are extracted for all samples at once (FinishSampleInput)
+        gPaths.push_back(input);
 
         AppendLog(L"Label (1 = spam, 0 = ham): ", hwnd);
         gTrainStep = 4;
@@ -330,19 +531,13 @@ static void HandleTrainInput(HWND hwnd) {
             gTrainStep = 3;
         }
         else {
-            if (gX.empty()) {
-                AppendLog(L"No valid training samples provided. Exiting.", hwnd);
-                gTrainStep = -1;
-            }
-            else {
-                AppendLog(L"Epochs (default 10): ", hwnd);
-                gTrainStep = 5;
-            }
+            FinishSampleInput(hwnd);
         }
     } break;
 
     case 5: { // epochs
-        if (!input.empty()) {
+        gLeastSquares = input == "ls";
+        if (!input.empty() && !gLeastSquares) {
             int e = 10;
             try {
                 e = std::stoi(input);
@@ -353,80 +548,38 @@ static void HandleTrainInput(HWND hwnd) {
             gEpochs = (std::max)(1, e);
         }
 
-        // ---- TRAIN LOOP (exact same prints as console) ----
-        for (int e = 0; e < gEpochs; ++e) {
-            std::wstringstream se;
-            se << L"\n--- Epoch " << (e + 1) << L" ---";
-            AppendLog(se.str(), hwnd);
-
-            for (size_t i = 0; i < gX.size(); ++i) {
-                std::wstringstream ss;
-                ss << L"Sample #" << (i + 1) << L":\n";
-                ss << L"  Input: ";
-                for (auto v : gX[i]) ss << v << L" ";
-
-                // before update
-                double yhat_before = gPerceptron->score(gX[i]);   // this is "score"
-                int    pred_before = gPerceptron->predict(gX[i]);
-                int    y = gY[i];
-
-                // gradient wrt yhat for squared loss 0.5 * (yhat - y)^2
-                double grad = (yhat_before - y);
-                double loss = 0.5 * grad * grad;
-
-                ss << L"\n  Score(before): " << yhat_before
-                    << L" Predicted: " << pred_before
-                    << L" Expected: " << y
-                    << L" Error(0/1): " << (y - pred_before)
-                    << L"  Grad(yhat-y): " << grad
-                    << L"  Loss: " << loss;
-                AppendLog(ss.str(), hwnd);
-
-                // train step (this uses grad internally)
-                gPerceptron->train(gX[i], gY[i]);
-
-                // after
-                double yhat_after = gPerceptron->score(gX[i]);
-                std::wstringstream ss2;
-                ss2 << L"  Score(after): " << yhat_after << L"\n";
-                ss2 << L"  Weights: ";
-                const auto& W = gPerceptron->getWeights();
-                for (auto w : W) ss2 << w << L" ";
-                ss2 << L" Bias: " << gPerceptron->getBias() << L"\n";
-                AppendLog(ss2.str(), hwnd);
-            }
+        // training runs on a worker thread; progress arrives through gTrainLog
+        // and WM_APP_TRAINED ends the run (FinishTraining)
+        gTrainLog.clear();
+        gTrainObserver.hwnd = hwnd;
+        bool started = false;
+        if (!gManifest.empty()) {
+            // streaming mode: per-epoch summaries instead of per-sample logs
+            StreamingOptions opt;
+            opt.epochs = gEpochs;
+            opt.shuffleBuffer = 4096;
+            opt.leastSquares = gLeastSquares;
+            started = gTrainer.startStreaming(*gPerceptron, Featurizer(gPerceptron->getFeatureConfig()), gManifest,
+                ExtractionPool(), opt, ProgressLevel::Epoch, &gTrainObserver);
         }
-
-
-        // final prints (exact)
-        {
-            std::wstringstream sf;
-            sf << L"\nTrained! Weights: ";
-            const auto& W = gPerceptron->getWeights();
-            for (auto w : W) sf << w << L" ";
-            sf << L"  Bias: " << gPerceptron->getBias();
-            AppendLog(sf.str(), hwnd);
-        }
-
-        AppendLog(L"\nTraining set predictions:", hwnd);
-        for (size_t i = 0; i < gX.size(); ++i) {
-            double yhat = gPerceptron->score(gX[i]);
-            int    pred = gPerceptron->predict(gX[i]);
-            int    y = gY[i];
-            double grad = (yhat - y);
-
-            std::wstringstream sp;
-            sp << L"  #" << (i + 1)
-                << L" expected=" << y
-                << L" predicted=" << pred
-                << L"  score=" << yhat
-                << L"  grad(yhat-y)=" << grad;
-            AppendLog(sp.str(), hwnd);
+        else {
+            Dataset data(gPerceptron->inputSize());
+            data.reserve(gX.size());
+            for (size_t i = 0; i < gX.size(); ++i) data.addRow(gX[i], gY[i]);
+            TrainingOptions opt;
+            opt.epochs = gEpochs;
+            opt.leastSquares = gLeastSquares;
+            // per-sample detail for a handful of hand-entered samples, epochs otherwise
+            opt.progress = gX.size() <= 50 ? ProgressLevel::Sample : ProgressLevel::Epoch;
+            started = gTrainer.start(*gPerceptron, std::move(data), opt, &gTrainObserver, &ExtractionPool());
+        }
+        if (!started) {
+            AppendLog(L"Training is already running.", hwnd);
+            return;
         }
-
-
-        AppendLog(L"\nSave model? (y/n): ", hwnd);
-        gTrainStep = 6;
+        AppendLog(L"Training...", hwnd);
+        SetTimer(hwnd, ID_TIMER_LOG, 100, NULL);
+        gTrainStep = 9; // busy until WM_APP_TRAINED
     } break;
 
     case 6: { // save choice
@@ -443,7 +596,9 @@ static void HandleTrainInput(HWND hwnd) {
 
     case 7: { // save filename
         std::string path = input.empty() ? "model.txt" : input;
-        if (gPerceptron->saveModel(path)) {
+        // *.bin -> binary model format, anything else -> text
+        bool binary = path.size() >= 4 && path.compare(path.size() - 4, 4, ".bin") == 0;
+        if (binary ? gPerceptron->saveModelBinary(path) : gPerceptron->saveModel(path)) {
             AppendLog(L"Saved to '" + Widen(path) + L"'.", hwnd);
         }
         else {
@@ -451,6 +606,49 @@ static void HandleTrainInput(HWND hwnd) {
         }
         gTrainStep = -1;
     } break;
+
+    case 8: { // keyword match mode (or hashing) for a new model
+        char ch = input.empty() ? 'n' : input[0];
+        if (ch == 'h' || ch == 'H') {
+            AppendLog(L"Hash buckets as a power of two (1-" + std::to_wstring(kMaxHashBits) + L", default 18): ", hwnd);
+            gTrainStep = 10;
+            return;
+        }
+        gKeywordMatch = (ch == 'y' || ch == 'Y') ? KeywordMatch::ExactToken : KeywordMatch::Substring;
+        gMatcher = KeywordMatcher(gKeywords, gKeywordMatch);
+        gPerceptron->setFeatureConfig(FeatureConfig::forKeywords(gKeywords, gKeywordMatch));
+        if (gKeywordMatch == KeywordMatch::ExactToken)
+            AppendLog(L"Keywords match whole tokens only ('winter' no longer counts as 'win').", hwnd);
+        AppendLog(L"How many training samples? (or @manifest.txt to stream 'path<TAB>label' lines) ", hwnd);
+        gTrainStep = 2;
+    } break;
+
+    case 9: // training in progress
+        AppendLog(L"Training is still running...", hwnd);
+        break;
+
+    case 10: { // hash bits for a new feature-hashing model
+        int bits = 18;
+        try {
+            if (!input.empty()) bits = std::stoi(input);
+        }
+        catch (...) {
+            bits = 0;
+        }
+        if (bits < 1 || bits > (int)kMaxHashBits) {
+            AppendLog(L"Invalid number of bits.", hwnd);
+            AppendLog(L"Hash buckets as a power of two (1-" + std::to_wstring(kMaxHashBits) + L", default 18): ", hwnd);
+            return;
+        }
+        HashingConfig h;
+        h.bits = (unsigned)bits;
+        delete gPerceptron;
+        gPerceptron = new Perceptron((int)h.dimension(), 0.001);
+        gPerceptron->setFeatureConfig(FeatureConfig::forHashing(h));
+        AppendLog(L"New feature-hashing model with " + std::to_wstring(h.dimension()) + L" buckets (seed 0, saved with the model).", hwnd);
+        AppendLog(L"Manifest to train on (@manifest.txt with 'path<TAB>label' lines): ", hwnd);
+        gTrainStep = 2;
+    } break;
     }
 }
 
@@ -578,6 +776,7 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
             ANSI_CHARSET, OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS,
             DEFAULT_QUALITY, FF_MODERN, L"Consolas");
         SendMessage(gLogEdit, WM_SETFONT, (WPARAM)hLogFont, TRUE);
+        SendMessage(gLogEdit, EM_SETLIMITTEXT, 0, 0); // no 32K cap; AppendLog bounds the text
 
         ShowWindow(gEditInput, SW_HIDE);
         ShowWindow(gActionBtn, SW_HIDE);
@@ -740,7 +939,16 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
     }
     break;
 
+    case WM_TIMER:
+        if (wParam == ID_TIMER_LOG) DrainTrainingLog(hwnd);
+        break;
+
+    case WM_APP_TRAINED:
+        FinishTraining(hwnd);
+        break;
+
     case WM_DESTROY:
+        StopTraining(hwnd);
         if (gPerceptron) {
             delete gPerceptron;
             gPerceptron = nullptr;
@@ -0,0 +1,186 @@
+// The keyword matchers against the baseline extractor semantics: every
+// whitespace-separated token, lowercased and stripped of trailing punctuation,
+// adds 1 to keyword i if `token.find(keywords[i]) != npos` (exact-token mode:
+// `token == keywords[i]`). KeywordMatcher (Aho-Corasick), ExactKeywordTable,
+// FixedKeywordMatcher and the dense/sparse/mapped extraction paths must all
+// agree with it.
+#include "FeatureExtractor.h"
+#include "DefaultKeywords.h"
+#include "FixedKeywordMatcher.h"
+#include "KeywordMatcher.h"
+#include "PerfectHash.h"
+#include "TestSupport.h"
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+    // the original extractFeatures loop, on a string instead of a file
+    std::vector<double> baseline(const std::string& text, const std::vector<std::string>& keywords, KeywordMatch match)
+    {
+        std::vector<double> features(keywords.size(), 0.0);
+        std::istringstream in(text);
+        std::string token;
+        while (in >> token)
+        {
+            std::transform(token.begin(), token.end(), token.begin(),
+                [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+            while (!token.empty() && std::ispunct(static_cast<unsigned char>(token.back())))
+                token.pop_back();
+            for (size_t i = 0; i < keywords.size(); ++i)
+            {
+                if (keywords[i].empty()) continue;
+                const bool hit = match == KeywordMatch::ExactToken ? token == keywords[i]
+                                                                   : token.find(keywords[i]) != std::string::npos;
+                if (hit) features[i] += 1.0;
+            }
+        }
+        return features;
+    }
+
+    std::vector<double> densify(const SparseVector& v, size_t n)
+    {
+        std::vector<double> out(n, 0.0);
+        for (size_t k = 0; k < v.nnz(); ++k) out[v.indices[k]] = v.values[k];
+        return out;
+    }
+
+    // overlapping keywords, a prefix chain, a repeated one, an empty one, upper
+    // case (never matches lowercased text) and punctuation inside a keyword
+    constexpr std::array<std::string_view, 14> kTricky = {
+        "he", "she", "his", "hers", "a", "ab", "abc", "bc", "", "Win", "win", "e-mail", "he", "x1"
+    };
+
+    std::vector<std::string> toStrings(const std::array<std::string_view, 14>& words)
+    {
+        return std::vector<std::string>(words.begin(), words.end());
+    }
+
+    std::vector<std::string> texts()
+    {
+        std::vector<std::string> out = {
+            "",
+            "   \t\n",
+            "She sells his hers; HE, he! ushers... abcabc abc-bc",
+            "WIN win Winner winwin twin, WINTER!!! e-mail E-MAIL email x1 X1x1",
+            "free FREE free!!! freedom \"free\" (free) click-now now. NOW? money$ $money",
+            "a\tab\vabc\fbc\rbcd\n\xe9t\xe9 caf\xc3\xa9 ab\x80 \x01he\x02",
+            "trailing punctuation only: !!! ??? ... ,,,",
+        };
+
+        // random documents over a small alphabet so keywords occur often
+        std::mt19937 rng(12345);
+        const std::string alphabet = "abcehirsw-1xAEHSW!.,;? \t\n\x80\xff";
+        for (int d = 0; d < 300; ++d)
+        {
+            std::string doc(std::uniform_int_distribution<size_t>(0, 200)(rng), ' ');
+            for (char& c : doc) c = alphabet[std::uniform_int_distribution<size_t>(0, alphabet.size() - 1)(rng)];
+            out.push_back(std::move(doc));
+        }
+        return out;
+    }
+
+    template <class Fixed>
+    void checkMode(const std::vector<std::string>& keywords, KeywordMatch match, const Fixed& fixed)
+    {
+        const KeywordMatcher matcher(keywords, match);
+        CHECK(matcher.size() == keywords.size());
+        SparseExtractScratch scratch;
+        test::TempDir dir("perceptron-keyword-matcher-test");
+        int docIndex = 0;
+        for (const std::string& text : texts())
+        {
+            const std::vector<double> expected = baseline(text, keywords, match);
+
+            std::vector<double> dense;
+            extractFeaturesFromText(text, matcher, dense);
+            CHECK(dense == expected);
+
+            SparseVector sparse;
+            extractSparseFeaturesFromText(text, matcher, sparse, scratch);
+            CHECK(sparse.dimension == keywords.size());
+            CHECK(std::is_sorted(sparse.indices.begin(), sparse.indices.end()));
+            CHECK(densify(sparse, keywords.size()) == expected);
+
+            typename Fixed::Counts counts;
+            fixed.extract(text, counts);
+            CHECK(std::vector<double>(counts.begin(), counts.end()) == expected);
+
+            // the stream and mapped-file paths on a few documents
+            if (docIndex++ < 20)
+            {
+                const std::string path = dir.write("doc.txt", text);
+                CHECK(extractFeatures(path, matcher) == expected);
+                CHECK(extractFeaturesMapped(path, matcher) == expected);
+            }
+        }
+    }
+
+    void testSubstring()
+    {
+        checkMode(toStrings(kTricky), KeywordMatch::Substring, FixedKeywordMatcher<14>(kTricky));
+        checkMode(std::vector<std::string>(kDefaultKeywords.begin(), kDefaultKeywords.end()),
+            KeywordMatch::Substring, FixedKeywordMatcher<20>(kDefaultKeywords));
+    }
+
+    void testExactToken()
+    {
+        checkMode(toStrings(kTricky), KeywordMatch::ExactToken,
+            FixedKeywordMatcher<14, KeywordMatch::ExactToken>(kTricky));
+        checkMode(std::vector<std::string>(kDefaultKeywords.begin(), kDefaultKeywords.end()),
+            KeywordMatch::ExactToken, FixedKeywordMatcher<20, KeywordMatch::ExactToken>(kDefaultKeywords));
+    }
+
+    void testExactKeywordTable()
+    {
+        const std::vector<std::string> keywords = toStrings(kTricky);
+        const ExactKeywordTable table(keywords);
+        auto hits = [&](std::string_view token, bool foldCase) {
+            std::vector<uint32_t> out;
+            table.forEachHit(token, [&](uint32_t k) { out.push_back(k); }, foldCase);
+            std::sort(out.begin(), out.end());
+            return out;
+        };
+        for (size_t i = 0; i < keywords.size(); ++i)
+        {
+            if (keywords[i].empty()) continue;
+            // case-sensitive lookup: every keyword equal to the token
+            std::vector<uint32_t> expected;
+            for (size_t j = 0; j < keywords.size(); ++j)
+                if (keywords[j] == keywords[i]) expected.push_back(static_cast<uint32_t>(j));
+            CHECK(hits(keywords[i], false) == expected);
+        }
+        CHECK(hits("he", false) == (std::vector<uint32_t>{ 0, 12 }));
+        CHECK(hits("Win", false) == (std::vector<uint32_t>{ 9 }));
+        // folded lookups compare the lowercased token with the lowercase keywords only
+        CHECK(hits("WIN", true) == (std::vector<uint32_t>{ 10 }));
+        CHECK(hits("HeRs", true) == (std::vector<uint32_t>{ 3 }));
+        CHECK(hits("hers!", true).empty());
+        CHECK(hits("", true).empty());
+        CHECK(hits("missing", false).empty());
+    }
+
+    void testDedupePerToken()
+    {
+        // a keyword counts once per token however often it occurs in it
+        const KeywordMatcher matcher({ "ab", "b" });
+        std::vector<double> features;
+        extractFeaturesFromText("ababab bb", matcher, features);
+        CHECK(features == (std::vector<double>{ 1.0, 2.0 }));
+    }
+}
+
+int main()
+{
+    testSubstring();
+    testExactToken();
+    testExactKeywordTable();
+    testDedupePerToken();
+    return test::testResult("KeywordMatcherTest");
+}
@@ -0,0 +1,351 @@
+// Model files round-trip: text, binary (double and float weights) and int8,
+// with every kind of feature config, through Perceptron::loadModel and
+// MappedModel; corrupt binary headers are rejected. The multi-class model:
+// its update rule, text round trip and malformed headers.
+#include "ModelFormat.h"
+#include "MulticlassPerceptron.h"
+#include "Perceptron.h"
+#include "Quantization.h"
+#include "TestSupport.h"
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    std::vector<double> randomWeights(size_t n, unsigned seed)
+    {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<double> dist(-2.0, 2.0);
+        std::vector<double> w(n);
+        for (double& v : w) v = dist(rng);
+        return w;
+    }
+
+    bool sameConfig(const FeatureConfig& a, const FeatureConfig& b)
+    {
+        if (a.mode != b.mode) return false;
+        if (a.mode == FeatureMode::Hashing)
+            return a.hashing.bits == b.hashing.bits && a.hashing.seed == b.hashing.seed
+                && a.hashing.signedHash == b.hashing.signedHash;
+        return a.keywords == b.keywords && a.match == b.match;
+    }
+
+    std::vector<FeatureConfig> configs()
+    {
+        HashingConfig h;
+        h.bits = 10;
+        h.seed = 77;
+        h.signedHash = true;
+        return {
+            FeatureConfig::forKeywords({ "free", "win", "money", "e-mail", "click now" }),
+            FeatureConfig::forKeywords({ "free", "win", "money", "e-mail", "click now" }, KeywordMatch::ExactToken),
+            FeatureConfig::forHashing(h),
+        };
+    }
+
+    Perceptron makeModel(const FeatureConfig& config, WeightPrecision precision, unsigned seed)
+    {
+        Perceptron model(static_cast<int>(config.dimension()), 0.0125, precision);
+        model.setParameters(randomWeights(config.dimension(), seed), -0.375);
+        model.setFeatureConfig(config);
+        return model;
+    }
+
+    void testText(const test::TempDir& dir)
+    {
+        for (const FeatureConfig& config : configs())
+        {
+            const Perceptron model = makeModel(config, WeightPrecision::Double, 1);
+            const std::string path = dir.path("model.txt");
+            CHECK(model.saveModel(path));
+
+            Perceptron loaded(0);
+            CHECK(loaded.loadModel(path));
+            CHECK(loaded.inputSize() == model.inputSize());
+            CHECK(loaded.getBias() == model.getBias());
+            CHECK(loaded.getLearningRate() == model.getLearningRate());
+            CHECK(sameConfig(loaded.getFeatureConfig(), config));
+            // the text format keeps 6 significant digits
+            for (size_t i = 0; i < model.inputSize(); ++i)
+                CHECK(std::fabs(loaded.getWeight(i) - model.getWeight(i)) <= 1e-5 * std::fabs(model.getWeight(i)));
+        }
+    }
+
+    void testBinary(const test::TempDir& dir)
+    {
+        for (WeightPrecision precision : { WeightPrecision::Double, WeightPrecision::Float })
+        {
+            for (const FeatureConfig& config : configs())
+            {
+                const Perceptron model = makeModel(config, precision, 2);
+                const std::string path = dir.path("model.bin");
+                CHECK(model.saveModelBinary(path));
+                CHECK(isBinaryModelFile(path));
+
+                // lossless in both precisions
+                Perceptron loaded(0, 0.1, precision);
+                CHECK(loaded.loadModel(path));
+                CHECK(loaded.getWeights() == model.getWeights());
+                CHECK(loaded.getBias() == model.getBias());
+                CHECK(loaded.getLearningRate() == model.getLearningRate());
+                CHECK(sameConfig(loaded.getFeatureConfig(), config));
+
+                MappedModel mapped;
+                std::string error;
+                CHECK(mapped.open(path, &error, /*verifyWeights=*/true));
+                CHECK(error.empty());
+                CHECK(mapped.weightType()
+                    == (precision == WeightPrecision::Float ? ModelWeightType::Float32 : ModelWeightType::Float64));
+                CHECK(mapped.getWeights() == model.getWeights());
+                CHECK(sameConfig(mapped.getFeatureConfig(), config));
+
+                SparseVector x;
+                x.dimension = model.inputSize();
+                x.push(0, 2.0);
+                x.push(3, 1.0);
+                x.push(static_cast<uint32_t>(model.inputSize() - 1), 5.0);
+                CHECK(std::fabs(mapped.score(x) - model.score(x)) < 1e-9);
+            }
+        }
+    }
+
+    void testInt8(const test::TempDir& dir)
+    {
+        for (const FeatureConfig& config : configs())
+        {
+            const Perceptron model = makeModel(config, WeightPrecision::Double, 3);
+            const std::string path = dir.path("model.q8.bin");
+            CHECK(model.saveModelQuantized(path));
+
+            MappedModel mapped;
+            std::string error;
+            CHECK(mapped.open(path, &error, /*verifyWeights=*/true));
+            CHECK(mapped.weightType() == ModelWeightType::Int8);
+            CHECK(sameConfig(mapped.getFeatureConfig(), config));
+            const double scale = mapped.weightScale();
+            CHECK(scale > 0.0);
+
+            // every weight is within half a quantization step
+            const std::vector<double> w = model.getWeights();
+            const std::vector<double> q = mapped.getWeights();
+            CHECK(q.size() == w.size());
+            for (size_t i = 0; i < w.size(); ++i) CHECK(std::fabs(q[i] - w[i]) <= 0.5 * scale + 1e-9);
+
+            // loadModel reads the int8 file back dequantized
+            Perceptron loaded(0);
+            CHECK(loaded.loadModel(path));
+            CHECK(loaded.getWeights() == q);
+            CHECK(loaded.getBias() == model.getBias());
+
+            // a count vector scores exactly like the dequantized weights would
+            std::vector<double> x(w.size(), 0.0);
+            x[0] = 3.0;
+            x[1] = 1.0;
+            x[w.size() - 1] = 2.0;
+            double expected = model.getBias();
+            for (size_t i = 0; i < x.size(); ++i) expected += q[i] * x[i];
+            CHECK(std::fabs(mapped.score(x) - expected) < 1e-6);
+        }
+    }
+
+    // rewrites the header of a binary model (checksum recomputed) to see that
+    // the reader validates more than the checksum
+    bool openPatched(const std::string& from, const std::string& to, void (*patch)(ModelFileHeader&, std::string&))
+    {
+        std::ifstream in(from, std::ios::binary);
+        std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        ModelFileHeader h;
+        std::memcpy(&h, bytes.data(), sizeof(h));
+        patch(h, bytes);
+        h.metaChecksum = 0;
+        h.weightsChecksum = 0;
+        h.metaChecksum = modelChecksum(bytes.data() + h.keywordsOffset, static_cast<size_t>(h.keywordsSize),
+            modelChecksum(&h, sizeof(h)));
+        std::memcpy(&bytes[0], &h, sizeof(h));
+        std::ofstream(to, std::ios::binary).write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        MappedModel m;
+        return m.open(to);
+    }
+
+    void testCorruptHeaders(const test::TempDir& dir)
+    {
+        const Perceptron model = makeModel(configs()[0], WeightPrecision::Double, 4);
+        const std::string path = dir.path("good.bin");
+        const std::string bad = dir.path("bad.bin");
+        CHECK(model.saveModelBinary(path));
+
+        CHECK(openPatched(path, bad, [](ModelFileHeader&, std::string&) {}));
+        // dimension * 8 wraps around to the real weight block size
+        CHECK(!openPatched(path, bad, [](ModelFileHeader& h, std::string&) { h.dimension += uint64_t(1) << 61; }));
+        // weight block not aligned for doubles
+        CHECK(!openPatched(path, bad, [](ModelFileHeader& h, std::string& b) {
+            b.append(4, '\0');
+            h.weightsOffset += 4;
+        }));
+        // weight block past the end of the file
+        CHECK(!openPatched(path, bad, [](ModelFileHeader& h, std::string&) { h.weightsOffset += 64; }));
+        CHECK(!openPatched(path, bad, [](ModelFileHeader& h, std::string&) { h.version = kModelVersion + 1; }));
+
+        // a flipped weight byte is caught by verifyWeights
+        std::ifstream in(path, std::ios::binary);
+        std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        ModelFileHeader h;
+        std::memcpy(&h, bytes.data(), sizeof(h));
+        bytes[static_cast<size_t>(h.weightsOffset) + 8] ^= 0x40;
+        std::ofstream(bad, std::ios::binary).write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        MappedModel m;
+        CHECK(!m.open(bad, nullptr, /*verifyWeights=*/true));
+
+        // a failed re-open does not leave the previous model half in place
+        MappedModel reopened;
+        CHECK(reopened.open(path));
+        CHECK(reopened.dimension() == model.inputSize());
+        CHECK(!reopened.open(bad, nullptr, /*verifyWeights=*/true));
+        CHECK(reopened.dimension() == 0);
+        CHECK(reopened.getBias() == 0.0);
+        CHECK(reopened.weightData() == nullptr);
+        CHECK(reopened.getFeatureConfig().dimension() == 0);
+        CHECK(reopened.getWeights().empty());
+    }
+
+    void testMulticlassTrain()
+    {
+        MulticlassPerceptron model(4, 3, 0.05);
+        SparseVector x;
+        x.dimension = 4;
+        x.push(1, 2.0);
+        x.push(3, -1.0);
+
+        // one step: every class row moves by -lr * x_f * (score - onehot)
+        std::vector<double> scores;
+        model.scores(x, scores);
+        std::vector<std::vector<double>> before(3);
+        std::vector<double> biasBefore(3);
+        for (int c = 0; c < 3; ++c)
+        {
+            before[c] = model.getWeights(c);
+            biasBefore[c] = model.getBias(c);
+        }
+        model.train(x, 2);
+        for (int c = 0; c < 3; ++c)
+        {
+            const double step = -0.05 * (scores[c] - (c == 2 ? 1.0 : 0.0));
+            CHECK(std::fabs(model.getBias(c) - (biasBefore[c] + step)) < 1e-12);
+            const std::vector<double> w = model.getWeights(c);
+            for (size_t f = 0; f < 4; ++f)
+            {
+                const double xf = f == 1 ? 2.0 : (f == 3 ? -1.0 : 0.0);
+                CHECK(std::fabs(w[f] - (before[c][f] + step * xf)) < 1e-12);
+            }
+        }
+
+        // the dense update is the same step
+        MulticlassPerceptron dense = model;
+        model.train(x, 0);
+        dense.train(std::vector<double>{ 0.0, 2.0, 0.0, -1.0 }, 0);
+        for (int c = 0; c < 3; ++c)
+        {
+            CHECK(std::fabs(dense.getBias(c) - model.getBias(c)) < 1e-12);
+            const std::vector<double> a = dense.getWeights(c), b = model.getWeights(c);
+            for (size_t f = 0; f < 4; ++f) CHECK(std::fabs(a[f] - b[f]) < 1e-12);
+        }
+
+        // one feature per class is learned to argmax
+        MulticlassPerceptron learner(3, 3, 0.1);
+        for (int epoch = 0; epoch < 200; ++epoch)
+            for (int c = 0; c < 3; ++c)
+            {
+                std::vector<double> in(3, 0.0);
+                in[c] = 1.0;
+                learner.train(in, c);
+            }
+        for (int c = 0; c < 3; ++c)
+        {
+            std::vector<double> in(3, 0.0);
+            in[c] = 1.0;
+            CHECK(learner.predict(in) == c);
+        }
+    }
+
+    void testMulticlassFormat(const test::TempDir& dir)
+    {
+        for (const FeatureConfig& config : configs())
+        {
+            const int n = static_cast<int>(config.dimension());
+            MulticlassPerceptron model(n, 11, 0.0125);   // 11 classes: a padded stride of 16
+            SparseVector x;
+            x.dimension = config.dimension();
+            x.push(0, 1.0);
+            x.push(static_cast<uint32_t>(n - 1), 3.0);
+            model.train(x, 7);
+            model.setClassNames({ "billing", "", "sales", "support", "a b", "", "", "", "", "", "spam" });
+            model.setFeatureConfig(config);
+            const std::string path = dir.path("multi.txt");
+            CHECK(model.saveModel(path));
+            CHECK(MulticlassPerceptron::isMulticlassModelFile(path));
+            CHECK(!MulticlassPerceptron::isMulticlassModelFile(dir.write("binary.txt", "5 0.1 0\n")));
+
+            // 17 significant digits: lossless
+            MulticlassPerceptron loaded(1, 1);
+            CHECK(loaded.loadModel(path));
+            CHECK(loaded.inputSize() == model.inputSize());
+            CHECK(loaded.numClasses() == 11);
+            CHECK(loaded.getLearningRate() == model.getLearningRate());
+            CHECK(loaded.getClassNames() == model.getClassNames());
+            CHECK(sameConfig(loaded.getFeatureConfig(), config));
+            for (int c = 0; c < 11; ++c)
+            {
+                CHECK(loaded.getBias(c) == model.getBias(c));
+                CHECK(loaded.getWeights(c) == model.getWeights(c));
+            }
+            CHECK(loaded.predict(x) == model.predict(x));
+        }
+    }
+
+    void testMulticlassMalformed(const test::TempDir& dir)
+    {
+        MulticlassPerceptron model(2, 2, 0.1);
+        const std::vector<double> w0 = model.getWeights(0);
+        auto rejects = [&](const std::string& text) {
+            return !model.loadModel(dir.write("bad-multi.txt", text));
+        };
+        CHECK(rejects("multiclass 2 0 0.1\n"));
+        // sizes that wrap or overflow the int constructor arguments
+        CHECK(rejects("multiclass 4294967297 2 0.1\n\n\n0 0\n1 2\n"));
+        CHECK(rejects("multiclass 2 4294967297 0.1\n\n\n0 0\n1 2\n"));
+        CHECK(rejects("multiclass 18446744073709551615 18446744073709551615 0.1\n"));
+        // sizes the file is far too short to hold
+        CHECK(rejects("multiclass 2000000000 1 0.1\n\n0\n1\n"));
+        CHECK(rejects("multiclass 1 2000000000 0.1\n"));
+        // too few weights, a non-number, a features section of the wrong size
+        CHECK(rejects("multiclass 2 2 0.1\n\n\n0 0\n1 2\n3\n"));
+        CHECK(rejects("multiclass 2 2 0.1\n\n\n0 0\n1 2\n3 x\n"));
+        CHECK(rejects("multiclass 2 2 0.1\n\n\n0 0\n1 2\n3 4\nfeatures hashing 4 0 0\n"));
+        // a failed load leaves the model as it was
+        CHECK(model.inputSize() == 2 && model.numClasses() == 2);
+        CHECK(model.getWeights(0) == w0);
+
+        CHECK(model.loadModel(dir.write("good-multi.txt", "multiclass 2 2 0.1\nham\nspam\n0 0.5\n1 2\n3 4\n")));
+        CHECK(model.getWeights(1) == (std::vector<double>{ 2.0, 4.0 }));
+        CHECK(model.getBias(1) == 0.5);
+        CHECK(model.getClassNames() == (std::vector<std::string>{ "ham", "spam" }));
+    }
+}
+
+int main()
+{
+    test::TempDir dir("perceptron-model-format-test");
+    testText(dir);
+    testBinary(dir);
+    testInt8(dir);
+    testCorruptHeaders(dir);
+    testMulticlassTrain();
+    testMulticlassFormat(dir);
+    testMulticlassMalformed(dir);
+    return test::testResult("ModelFormatTest");
+}
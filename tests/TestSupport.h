@@ -0,0 +1,69 @@
+#pragma once
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <system_error>
+
+// Minimal checks for the test programs (no framework dependency): CHECK
+// reports a failed expression and carries on, testResult() turns the failure
+// count into the exit code ctest looks at.
+namespace test
+{
+    inline int& failures()
+    {
+        static int count = 0;
+        return count;
+    }
+
+    inline void check(bool ok, const char* expr, const char* file, int line)
+    {
+        if (ok) return;
+        std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", file, line, expr);
+        ++failures();
+    }
+
+    inline int testResult(const char* name)
+    {
+        if (failures() == 0)
+        {
+            std::printf("%s: all checks passed\n", name);
+            return 0;
+        }
+        std::fprintf(stderr, "%s: %d check(s) failed\n", name, failures());
+        return 1;
+    }
+
+    // Scratch directory under the system temp dir, removed with its contents
+    class TempDir
+    {
+    public:
+        explicit TempDir(const std::string& name)
+            : dir(std::filesystem::temp_directory_path() / name)
+        {
+            std::error_code ec;
+            std::filesystem::remove_all(dir, ec);
+            std::filesystem::create_directories(dir);
+        }
+        ~TempDir()
+        {
+            std::error_code ec;
+            std::filesystem::remove_all(dir, ec);
+        }
+
+        std::string path(const std::string& file) const { return (dir / file).string(); }
+
+        // writes text to file and returns its full path
+        std::string write(const std::string& file, const std::string& text) const
+        {
+            const std::string p = path(file);
+            std::ofstream(p, std::ios::binary) << text;
+            return p;
+        }
+
+    private:
+        std::filesystem::path dir;
+    };
+}
+
+#define CHECK(expr) test::check(static_cast<bool>(expr), #expr, __FILE__, __LINE__)
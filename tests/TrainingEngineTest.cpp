@@ -0,0 +1,268 @@
+// Headless TrainingEngine: run() at every ProgressLevel, start()/wait() on the
+// worker thread, cancellation, least squares and streaming from a manifest.
+#include "TestSupport.h"
+#include "TrainingEngine.h"
+#include <atomic>
+#include <cmath>
+#include <future>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // counts the callbacks and keeps what they reported
+    class RecordingObserver : public TrainingObserver
+    {
+    public:
+        void onSample(const SampleProgress& p) override { samples.push_back(p); }
+        void onEpoch(const EpochProgress& p) override { epochs.push_back(p); }
+        void onFinished(const TrainingResult& r) override
+        {
+            ++finished;
+            last = r;
+        }
+
+        std::vector<SampleProgress> samples;
+        std::vector<EpochProgress> epochs;
+        int finished = 0;
+        TrainingResult last;
+    };
+
+    // a small separable problem: label 1 when the first input outweighs the second
+    Dataset makeData()
+    {
+        Dataset data(3);
+        const double rows[][3] = { { 3, 0, 1 }, { 0, 2, 1 }, { 4, 1, 0 }, { 1, 3, 2 }, { 2, 0, 0 }, { 0, 1, 1 } };
+        for (const auto& r : rows) data.addRow(std::vector<double>(r, r + 3), r[0] > r[1] ? 1 : 0);
+        return data;
+    }
+
+    Perceptron makeModel()
+    {
+        Perceptron model(3, 0.05);
+        model.setParameters({ 0.1, -0.2, 0.05 }, 0.0);
+        return model;
+    }
+
+    void testProgressLevels()
+    {
+        const Dataset data = makeData();
+        TrainingOptions options;
+        options.epochs = 4;
+
+        std::vector<double> weights[3];
+        const ProgressLevel levels[] = { ProgressLevel::Summary, ProgressLevel::Epoch, ProgressLevel::Sample };
+        for (int l = 0; l < 3; ++l)
+        {
+            options.progress = levels[l];
+            Perceptron model = makeModel();
+            RecordingObserver observer;
+            const TrainingResult r = TrainingEngine::run(model, data, options, &observer);
+            CHECK(r.ok);
+            CHECK(!r.cancelled);
+            CHECK(r.epochs == 4);
+            CHECK(r.samples == data.rows());
+            CHECK(observer.finished == 1);
+            CHECK(observer.epochs.size() == (levels[l] == ProgressLevel::Summary ? 0u : 4u));
+            CHECK(observer.samples.size() == (levels[l] == ProgressLevel::Sample ? 4 * data.rows() : 0u));
+            weights[l] = model.getWeights();
+        }
+
+        // the reporting level must not change what is learned
+        for (int l = 1; l < 3; ++l)
+            for (size_t i = 0; i < weights[0].size(); ++i)
+                CHECK(std::fabs(weights[l][i] - weights[0][i]) < 1e-12);
+    }
+
+    void testSampleProgress()
+    {
+        const Dataset data = makeData();
+        TrainingOptions options;
+        options.epochs = 2;
+        options.progress = ProgressLevel::Sample;
+        Perceptron model = makeModel();
+        RecordingObserver observer;
+        const TrainingResult r = TrainingEngine::run(model, data, options, &observer);
+        CHECK(r.ok);
+
+        double lossSum = 0.0;
+        for (size_t i = 0; i < observer.samples.size(); ++i)
+        {
+            const SampleProgress& p = observer.samples[i];
+            CHECK(p.epoch == static_cast<int>(i / data.rows()));
+            CHECK(p.row == i % data.rows());   // shuffle is off: data order
+            CHECK(p.label == data.label(p.row));
+            const double grad = p.scoreBefore - p.label;
+            CHECK(std::fabs(p.loss - 0.5 * grad * grad) < 1e-12);
+            if (p.epoch == 1) lossSum += p.loss;
+        }
+        CHECK(std::fabs(r.meanLoss - lossSum / static_cast<double>(data.rows())) < 1e-12);
+        CHECK(observer.epochs.size() == 2);
+    }
+
+    void testCancelledBeforeStart()
+    {
+        const Dataset data = makeData();
+        Perceptron model = makeModel();
+        const std::vector<double> before = model.getWeights();
+        const std::atomic<bool> cancel{ true };
+        RecordingObserver observer;
+        const TrainingResult r = TrainingEngine::run(model, data, TrainingOptions(), &observer, &cancel);
+        CHECK(r.ok);
+        CHECK(r.cancelled);
+        CHECK(r.epochs == 0);
+        CHECK(observer.finished == 1);
+        CHECK(model.getWeights() == before);
+    }
+
+    // holds the worker in its first onSample until released
+    class BlockingObserver : public RecordingObserver
+    {
+    public:
+        void onSample(const SampleProgress& p) override
+        {
+            RecordingObserver::onSample(p);
+            if (samples.size() == 1)
+            {
+                reached.set_value();
+                release.get_future().wait();
+            }
+        }
+
+        std::promise<void> reached;
+        std::promise<void> release;
+    };
+
+    void testStartCancelWait()
+    {
+        Perceptron model = makeModel();
+        TrainingOptions options;
+        options.epochs = 1000;
+        options.progress = ProgressLevel::Sample;
+
+        TrainingEngine engine;
+        BlockingObserver observer;
+        CHECK(engine.start(model, makeData(), options, &observer));
+        observer.reached.get_future().wait();
+        CHECK(engine.running());
+
+        // one run at a time
+        Perceptron other = makeModel();
+        CHECK(!engine.start(other, makeData(), options));
+
+        engine.cancel();
+        observer.release.set_value();
+        const TrainingResult r = engine.wait();
+        CHECK(!engine.running());
+        CHECK(r.ok);
+        CHECK(r.cancelled);
+        CHECK(r.epochs == 0);               // stopped inside the first epoch
+        CHECK(observer.samples.size() == 1);
+        CHECK(observer.finished == 1);
+        CHECK(observer.last.cancelled);
+
+        // the engine takes a new run after wait()
+        RecordingObserver second;
+        options.epochs = 2;
+        options.progress = ProgressLevel::Epoch;
+        CHECK(engine.start(model, makeData(), options, &second));
+        const TrainingResult r2 = engine.wait();
+        CHECK(r2.ok && !r2.cancelled && r2.epochs == 2);
+        CHECK(second.epochs.size() == 2);
+    }
+
+    void testDimensionMismatch()
+    {
+        Perceptron model(5, 0.1);
+        RecordingObserver observer;
+        const TrainingResult r = TrainingEngine::run(model, makeData(), TrainingOptions(), &observer);
+        CHECK(!r.ok);
+        CHECK(!r.error.empty());
+        CHECK(observer.finished == 1);
+    }
+
+    void testLeastSquares()
+    {
+        const Dataset data = makeData();
+        TrainingOptions options;
+        options.leastSquares = true;
+        options.ridge = 1e-6;
+        Perceptron model = makeModel();
+        RecordingObserver observer;
+        const TrainingResult r = TrainingEngine::run(model, data, options, &observer);
+        CHECK(r.ok);
+        CHECK(r.epochs == 1);
+        CHECK(observer.epochs.size() == 1);
+        CHECK(observer.samples.empty());
+        // the solution zeroes the gradient of the ridge objective
+        std::vector<double> grad(data.cols(), 0.0);
+        double biasGrad = 0.0;
+        for (size_t i = 0; i < data.rows(); ++i)
+        {
+            const std::vector<double> x = data.rowVector(i);
+            const double residual = model.score(x) - data.label(i);
+            for (size_t j = 0; j < x.size(); ++j) grad[j] += residual * x[j];
+            biasGrad += residual;
+        }
+        for (size_t j = 0; j < grad.size(); ++j)
+            CHECK(std::fabs(grad[j] + options.ridge * model.getWeight(j)) < 1e-9);
+        CHECK(std::fabs(biasGrad) < 1e-9);
+    }
+
+    void testStreaming()
+    {
+        test::TempDir dir("perceptron-training-engine-test");
+        std::string manifest;
+        const char* docs[][2] = {
+            { "Click now to claim your free reward money", "1" },
+            { "Meeting notes for Tuesday, see attached agenda", "0" },
+            { "Urgent: verify your account login and pin now", "1" },
+            { "Lunch on Friday? The usual place.", "0" },
+        };
+        for (size_t i = 0; i < 4; ++i)
+            manifest += dir.write("doc" + std::to_string(i) + ".txt", docs[i][0]) + "\t" + docs[i][1] + "\n";
+        manifest += dir.path("missing.txt") + "\t1\n";
+        const std::string manifestPath = dir.write("train.tsv", manifest);
+
+        const FeatureConfig config = FeatureConfig::forKeywords({ "free", "click", "now", "verify", "meeting" });
+        Perceptron model(static_cast<int>(config.dimension()), 0.05);
+        model.setFeatureConfig(config);
+        ThreadPool pool(2);
+        StreamingOptions options;
+        options.epochs = 3;
+        options.batchSize = 2;
+
+        TrainingEngine engine;
+        RecordingObserver observer;
+        CHECK(engine.startStreaming(model, Featurizer(config), manifestPath, pool, options, ProgressLevel::Epoch,
+            &observer));
+        const TrainingResult r = engine.wait();
+        CHECK(r.ok);
+        CHECK(!r.cancelled);
+        CHECK(r.epochs == 3);
+        CHECK(r.samples == 4);
+        CHECK(r.skipped == 1);
+        CHECK(observer.epochs.size() == 3);
+        CHECK(observer.finished == 1);
+
+        // Summary: no per-epoch reports
+        RecordingObserver quiet;
+        CHECK(engine.startStreaming(model, Featurizer(config), manifestPath, pool, options, ProgressLevel::Summary,
+            &quiet));
+        CHECK(engine.wait().ok);
+        CHECK(quiet.epochs.empty());
+        CHECK(quiet.finished == 1);
+    }
+}
+
+int main()
+{
+    testProgressLevels();
+    testSampleProgress();
+    testCancelledBeforeStart();
+    testStartCancelWait();
+    testDimensionMismatch();
+    testLeastSquares();
+    testStreaming();
+    return test::testResult("TrainingEngineTest");
+}